@@ -168,6 +168,8 @@ macro(dmitigr_cefeika_propagate_tests_settings lib)
       ${dmitigr_${lib}_test_${test}_target_link_libraries} PARENT_SCOPE)
     set(dmitigr_${lib}_test_${test}_target_compile_definitions
       ${dmitigr_${lib}_test_${test}_target_compile_definitions} PARENT_SCOPE)
+    set(dmitigr_${lib}_test_${test}_cxx_standard
+      ${dmitigr_${lib}_test_${test}_cxx_standard} PARENT_SCOPE)
   endforeach()
   set(dmitigr_${lib}_tests ${dmitigr_${lib}_tests} PARENT_SCOPE)
   set(dmitigr_${lib}_tests_target_link_libraries ${dmitigr_${lib}_tests_target_link_libraries} PARENT_SCOPE)
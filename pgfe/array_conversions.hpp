@@ -9,14 +9,17 @@
 #include "conversions_api.hpp"
 #include "data.hpp"
 #include "exceptions.hpp"
-#include "../str.hpp"
+#include "../net/conversions.hpp"
 
 #include <algorithm>
 #include <cassert>
-#include <locale>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace dmitigr::pgfe {
@@ -35,6 +38,10 @@ std::string to_array_literal(const Container<Optional<T>, Allocator<Optional<T>>
 template<class Container, typename ... Types>
 Container to_container(const char* literal, char delimiter = ',', Types&& ... args);
 
+/// @returns The container representation of the binary PostgreSQL array `bytes`.
+template<class Container, typename ... Types>
+Container to_container_binary(const char* bytes, std::size_t size, Types&& ... args);
+
 // =============================================================================
 
 /**
@@ -180,8 +187,12 @@ struct Array_data_conversions_opts<Container<Optional<T>, Allocator<Optional<T>>
   template<typename ... Types>
   static Type to_type(const Data* const data, Types&& ... args)
   {
-    assert(data && data->format() == Data_format::text);
-    return to_container<Type>(static_cast<const char*>(data->bytes()), ',', std::forward<Types>(args)...);
+    assert(data);
+    if (data->format() == Data_format::binary)
+      return to_container_binary<Type>(static_cast<const char*>(data->bytes()), data->size(),
+        std::forward<Types>(args)...);
+    else
+      return to_container<Type>(static_cast<const char*>(data->bytes()), ',', std::forward<Types>(args)...);
   }
 
   template<typename ... Types>
@@ -371,11 +382,11 @@ std::string to_array_literal(const std::basic_string<CharT, Traits, Allocator>&
 
   std::string result{Conversions<String>::to_string(element, std::forward<Types>(args)...)};
 
-  // Escaping quotes.
-  typename String::size_type i = result.find("\"");
-  while (i != String::npos) {
-    result.replace(i, 1, "\\\"");
-    i = result.find("\"", i + 2);
+  // Escaping quotes and backslashes.
+  auto i = result.find_first_of("\"\\");
+  while (i != std::string::npos) {
+    result.insert(i, 1, '\\');
+    i = result.find_first_of("\"\\", i + 2);
   }
 
   return result;
@@ -428,6 +439,21 @@ Optional<T> to_container_of_optionals(T&& element)
 
 // =====================================
 
+/// @returns `true` if `c` is a space character of the PostgreSQL array literal.
+constexpr bool is_array_space(const char c) noexcept
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/// @returns The pointer to the first non-space character of the `literal`.
+inline const char* skip_array_spaces(const char* literal) noexcept
+{
+  assert(literal);
+  while (is_array_space(*literal))
+    ++literal;
+  return literal;
+}
+
 /**
  * @brief PostgreSQL array parsing routine.
  *
@@ -443,6 +469,13 @@ Optional<T> to_container_of_optionals(T&& element)
  *   - dimension -- is a zero-based index of type `int` of the element dimension;
  *   - args -- extra arguments for passing to the conversion routine.
  *
+ * The elements are scanned by spans rather than by characters: the spans
+ * without the special characters (quotes, backslashes, curly brackets and the
+ * `delimiter`) are found by `std::strcspn()` (which is vectorized by the most
+ * of the standard libraries) and appended to the element at once. The buffer
+ * of the element is reused between the elements unless it's moved by the
+ * `handler`.
+ *
  * @returns The pointer that points to a next character after the last closing
  * curly bracket found in the `literal`.
  *
@@ -467,121 +500,101 @@ const char* parse_array_literal(const char* literal, const char delimiter, F& ha
    *   {{{1,2}},{{3,4}}}
    */
 
-  enum { in_beginning, in_dimension,
-         in_quoted_element, in_unquoted_element } state = in_beginning;
-
-  int  dimension{};
-  char previous_char{};
-  char previous_nonspace_char{};
-  std::string element;
-  const std::locale loc;
-  while (const char c = *literal) {
-    switch (state) {
-    case in_beginning: {
-      if (c == '{') {
-        handler(dimension);
-        dimension = 1;
-        state = in_dimension;
-      } else if (std::isspace(c, loc)) {
-        // Skip space.
-      } else
-        throw Client_exception{Client_errc::malformed_array_literal};
+  // The stop characters for std::strcspn().
+  const char* const quoted_stops = "\"\\";
+  const char unquoted_stops[5]{delimiter, '{', '}', '\\', '\0'};
 
-      goto preparing_to_the_next_iteration;
-    }
+  enum { opening, separator, element, closing } previous_token = opening;
 
-    case in_dimension: {
-      assert(dimension > 0);
+  literal = skip_array_spaces(literal);
+  if (*literal != '{')
+    throw Client_exception{Client_errc::malformed_array_literal};
+  handler(0);
+  ++literal;
 
-      if (std::isspace(c, loc)) {
-        // Skip space.
-      } else if (c == delimiter) {
-        if (previous_nonspace_char == delimiter || previous_nonspace_char == '{')
-          throw Client_exception{Client_errc::malformed_array_literal};
-      } else if (c == '{') {
-        handler(dimension);
-        ++dimension;
-      } else if (c == '}') {
-        if (previous_nonspace_char == delimiter)
+  int dimension{1};
+  std::string value;
+  while (const char c = *literal) {
+    if (is_array_space(c)) {
+      ++literal;
+      continue;
+    } else if (c == delimiter) {
+      if (previous_token == separator || previous_token == opening)
+        throw Client_exception{Client_errc::malformed_array_literal};
+      previous_token = separator;
+      ++literal;
+      continue;
+    } else if (c == '{') {
+      if (previous_token == element || previous_token == closing)
+        throw Client_exception{Client_errc::malformed_array_literal};
+      handler(dimension);
+      ++dimension;
+      previous_token = opening;
+      ++literal;
+      continue;
+    } else if (c == '}') {
+      if (previous_token == separator)
+        throw Client_exception{Client_errc::malformed_array_literal};
+      previous_token = closing;
+      ++literal; // consuming the closing curly bracket
+      if (--dimension == 0) {
+        // Any character may follow after the closing curly bracket. It's ok.
+        return literal;
+      }
+      continue;
+    } else if (previous_token == element || previous_token == closing)
+      throw Client_exception{Client_errc::malformed_array_literal};
+
+    value.clear();
+    bool is_element_null{};
+    if (c == '"') {
+      ++literal; // consuming the opening quote
+      while (true) {
+        const auto span_size = std::strcspn(literal, quoted_stops);
+        value.append(literal, span_size);
+        literal += span_size;
+        if (*literal == '"') {
+          ++literal; // consuming the closing quote
+          break;
+        } else if (*literal == '\\' && literal[1]) {
+          value += literal[1];
+          literal += 2;
+        } else
           throw Client_exception{Client_errc::malformed_array_literal};
-
-        --dimension;
-        if (dimension == 0) {
-          // Any character may follow after the closing curly bracket. It's ok.
-          ++literal; // consuming the closing curly bracket
-          return literal;
-        }
-      } else if (c == '"') {
-        state = in_quoted_element;
-      } else {
-        state = in_unquoted_element;
-        continue;
+      }
+    } else {
+      std::string::size_type escaped_size{};
+      while (true) {
+        const auto span_size = std::strcspn(literal, unquoted_stops);
+        value.append(literal, span_size);
+        literal += span_size;
+        if (*literal == '\\' && literal[1]) {
+          value += literal[1];
+          escaped_size = value.size();
+          literal += 2;
+        } else
+          break;
       }
 
-      goto preparing_to_the_next_iteration;
-    }
-
-    case in_quoted_element: {
-      if (c == '\\' && previous_char != '\\') {
-        // Skip escape character '\\'.
-      } else if (c == '"' && previous_char != '\\')
-        goto element_extracted;
-      else
-        element += c;
-
-      goto preparing_to_the_next_iteration;
-    }
-
-    case in_unquoted_element: {
-      if (c == delimiter || c == '{' || c == '}')
-        goto element_extracted;
-      else
-        element += c;
-
-      goto preparing_to_the_next_iteration;
-    }
-    } // switch (state)
+      // Unescaped trailing spaces are not the part of the unquoted element.
+      while (value.size() > escaped_size && is_array_space(value.back()))
+        value.pop_back();
 
-  element_extracted:
-    {
-      if (element.empty())
+      if (value.empty())
         throw Client_exception{Client_errc::malformed_array_literal};
 
-      const bool is_element_null =
-        ((state == in_unquoted_element && element.size() == 4)
-          &&
-          ((element[0] == 'n' || element[0] == 'N') &&
-            (element[1] == 'u' || element[1] == 'U') &&
-            (element[2] == 'l' || element[2] == 'L') &&
-            (element[3] == 'l' || element[3] == 'L')));
-
-      handler(std::move(element), is_element_null, dimension, std::forward<Types>(args)...);
-
-      element = std::string{}; // The element was moved and must be recreated!
-
-      if (state == in_unquoted_element) {
-        /*
-         * Just after extracting unquoted element, the (*literal) is a
-         * character that must be processed next. Thus, continue immediately.
-         */
-        state = in_dimension;
-        continue;
-      } else {
-        state = in_dimension;
-      }
-    } // extracted element processing
+      is_element_null = !escaped_size && value.size() == 4 &&
+        (value[0] == 'n' || value[0] == 'N') &&
+        (value[1] == 'u' || value[1] == 'U') &&
+        (value[2] == 'l' || value[2] == 'L') &&
+        (value[3] == 'l' || value[3] == 'L');
+    }
 
-  preparing_to_the_next_iteration:
-    if (!std::isspace(c, loc))
-      previous_nonspace_char = c;
-    previous_char = c;
-    ++literal;
+    handler(std::move(value), is_element_null, dimension, std::forward<Types>(args)...);
+    previous_token = element;
   } // while
 
-  if (dimension != 0)
-    throw Client_exception{Client_errc::malformed_array_literal};
-
-  return literal;
+  throw Client_exception{Client_errc::malformed_array_literal};
 }
 
 /**
@@ -604,17 +617,11 @@ const char* fill_container(Container<Optional<T>, Allocator<Optional<T>>>& resul
   assert(result.empty());
   assert(literal);
 
-  /*
-   * Note: On MSVS the "fatal error C1001: An internal error has occurred in the compiler."
-   * is possible if the using directive below points to the incorrect symbol!
-   */
-  using str::next_non_space_pointer;
-
-  literal = next_non_space_pointer(literal);
+  literal = skip_array_spaces(literal);
   if (*literal != '{')
     throw Client_exception{Client_errc::malformed_array_literal};
 
-  const char* subliteral = next_non_space_pointer(literal + 1);
+  const char* subliteral = skip_array_spaces(literal + 1);
   if (*subliteral == '{') {
     // Multidimensional array literal detected.
     while (true) {
@@ -635,13 +642,13 @@ const char* fill_container(Container<Optional<T>, Allocator<Optional<T>>>& resul
       subliteral = fill_container(subcontainer, subliteral, delimiter, std::forward<Types>(args)...);
 
       // For better understanding, imagine the source literal as "{{{1,2}},{{3,4}}}".
-      subliteral = next_non_space_pointer(subliteral);
+      subliteral = skip_array_spaces(subliteral);
       if (*subliteral == delimiter) {
         /*
          * The end of the subarray of the current dimension: subliteral is ",{{3,4}}}".
          * Parsing will be continued. The subliteral of next array must begins with '{'.
          */
-        subliteral = next_non_space_pointer(subliteral + 1);
+        subliteral = skip_array_spaces(subliteral + 1);
         if (*subliteral != '{')
           throw Client_exception{Client_errc::malformed_array_literal};
       } else if (*subliteral == '}') {
@@ -703,6 +710,174 @@ Container to_container(const char* const literal, const char delimiter, Types&&
   return result;
 }
 
+// -----------------------------------------------------------------------------
+// Binary arrays
+// -----------------------------------------------------------------------------
+
+/// The header of the binary representation of PostgreSQL array.
+struct Binary_array_header final {
+  /// The maximum number of dimensions of PostgreSQL arrays.
+  static constexpr int max_dimension_count{6};
+
+  /// The number of dimensions.
+  int dimension_count{};
+
+  /// The OID of the element type.
+  std::uint_fast32_t element_oid{};
+
+  /// The sizes of the dimensions.
+  std::int32_t dimensions[max_dimension_count]{};
+
+  /// The lower bounds of the dimensions.
+  std::int32_t lower_bounds[max_dimension_count]{};
+};
+
+/**
+ * @brief Reads the header of the binary representation of PostgreSQL array
+ * from the range `[bytes, end)`.
+ *
+ * @returns The pointer to the first element of the array.
+ *
+ * @throws Client_exception.
+ */
+inline const char* read_binary_array_header(Binary_array_header& result,
+  const char* bytes, const char* const end)
+{
+  assert(bytes && bytes <= end);
+  const auto read_int32 = [&bytes, end]
+  {
+    if (end - bytes < static_cast<std::ptrdiff_t>(sizeof(std::int32_t)))
+      throw Client_exception{Client_errc::malformed_array_literal};
+    const auto result = net::conv<std::int32_t>(bytes, sizeof(std::int32_t));
+    bytes += sizeof(std::int32_t);
+    return result;
+  };
+
+  const auto dimension_count = read_int32();
+  if (dimension_count < 0 || dimension_count > Binary_array_header::max_dimension_count)
+    throw Client_exception{Client_errc::malformed_array_literal};
+  result.dimension_count = dimension_count;
+  read_int32(); // flags
+  result.element_oid = static_cast<std::uint32_t>(read_int32());
+  for (int i = 0; i < dimension_count; ++i) {
+    if ((result.dimensions[i] = read_int32()) < 0)
+      throw Client_exception{Client_errc::malformed_array_literal};
+    result.lower_bounds[i] = read_int32();
+  }
+  return bytes;
+}
+
+/// Denotes the container of optionals.
+template<typename>
+struct Is_container_of_optionals final : std::false_type {};
+
+/// The partial specialization of Is_container_of_optionals.
+template<typename T,
+  template<class> class Optional,
+  template<class, class> class Container,
+  template<class> class Allocator>
+struct Is_container_of_optionals<Container<Optional<T>, Allocator<Optional<T>>>> final
+  : std::true_type {};
+
+/// Denotes the container with `reserve()`.
+template<class, typename = void>
+struct Has_reserve final : std::false_type {};
+
+/// The partial specialization of Has_reserve.
+template<class Container>
+struct Has_reserve<Container, std::void_t<decltype(std::declval<Container&>().reserve(0))>> final
+  : std::true_type {};
+
+namespace arrays {
+
+/// Used by fill_container_binary().
+template<typename T, typename ... Types>
+const char* fill_container_binary(T& /*result*/, const Binary_array_header& /*header*/,
+  int /*dimension*/, const char* /*bytes*/, const char* /*end*/, Types&& ... /*args*/)
+{
+  throw Client_exception{Client_errc::insufficient_array_dimensionality};
+}
+
+} // namespace arrays
+
+/**
+ * @brief Fills the container with elements of the `dimension` of the binary
+ * representation of PostgreSQL array in the range `[bytes, end)`.
+ *
+ * The elements are converted directly from the views of the range without
+ * copying them into the intermediate strings.
+ *
+ * @returns The pointer to the next element of the array.
+ *
+ * @throws Client_exception.
+ */
+template<typename T,
+  template<class> class Optional,
+  template<class, class> class Container,
+  template<class> class Allocator,
+  typename ... Types>
+const char* fill_container_binary(Container<Optional<T>, Allocator<Optional<T>>>& result,
+  const Binary_array_header& header, const int dimension, const char* bytes,
+  const char* const end, Types&& ... args)
+{
+  assert(result.empty());
+  assert(0 <= dimension && dimension < header.dimension_count);
+  assert(bytes && bytes <= end);
+
+  using Result = Container<Optional<T>, Allocator<Optional<T>>>;
+  const auto size = header.dimensions[dimension];
+  // Each element is preceded by its size, so the data must be large enough.
+  if (static_cast<std::size_t>(size) >
+    static_cast<std::size_t>(end - bytes) / sizeof(std::int32_t))
+    throw Client_exception{Client_errc::malformed_array_literal};
+  if constexpr (Has_reserve<Result>::value)
+    result.reserve(static_cast<typename Result::size_type>(size));
+
+  if (dimension + 1 < header.dimension_count) {
+    for (std::int32_t i = 0; i < size; ++i) {
+      result.push_back(T());
+      using namespace arrays;
+      bytes = fill_container_binary(*result.back(), header, dimension + 1, bytes, end,
+        std::forward<Types>(args)...);
+    }
+  } else if constexpr (!Is_container_of_optionals<T>::value) {
+    for (std::int32_t i = 0; i < size; ++i) {
+      if (end - bytes < static_cast<std::ptrdiff_t>(sizeof(std::int32_t)))
+        throw Client_exception{Client_errc::malformed_array_literal};
+      const auto element_size = net::conv<std::int32_t>(bytes, sizeof(std::int32_t));
+      bytes += sizeof(std::int32_t);
+      if (element_size < 0)
+        result.push_back(Optional<T>());
+      else if (end - bytes < element_size)
+        throw Client_exception{Client_errc::malformed_array_literal};
+      else {
+        const Data_view element{bytes, element_size, Data_format::binary};
+        result.push_back(Conversions<T>::to_type(&element, std::forward<Types>(args)...));
+        bytes += element_size;
+      }
+    }
+  } else
+    throw Client_exception{Client_errc::excessive_array_dimensionality};
+
+  return bytes;
+}
+
+/// @returns A container converted from the binary representation of PostgreSQL array.
+template<class Container, typename ... Types>
+Container to_container_binary(const char* const bytes, const std::size_t size, Types&& ... args)
+{
+  assert(bytes);
+  const char* const end = bytes + size;
+  Binary_array_header header;
+  const char* const elements = read_binary_array_header(header, bytes, end);
+  Container result;
+  if (header.dimension_count > 0) {
+    if (fill_container_binary(result, header, 0, elements, end, std::forward<Types>(args)...) != end)
+      throw Client_exception{Client_errc::malformed_array_literal};
+  }
+  return result;
+}
+
 /**
  * @returns A container of non-null values converted from PostgreSQL array literal.
  *
@@ -776,7 +951,7 @@ auto to_container_of_optionals(Container<T, Allocator<T>>&& container)
  * @tparam Allocator The allocator template class, such as `std::allocator`.
  *
  * The support of the following data formats is implemented:
- *   - for input data  - Data_format::text;
+ *   - for input data  - Data_format::text, Data_format::binary;
  *   - for output data - Data_format::text.
  */
 template<typename T,
@@ -808,7 +983,7 @@ struct Conversions<Container<Optional<T>, Allocator<Optional<T>>>> final
  * the PostgreSQL array representations with at least one `NULL` element.
  *
  * The support of the following data formats is implemented:
- *   - for input data  - Data_format::text;
+ *   - for input data  - Data_format::text, Data_format::binary;
  *   - for output data - Data_format::text.
  */
 template<typename T,
@@ -63,6 +63,19 @@ struct Basic_conversions {
   {
     return StringConversions::to_string(std::forward<U>(value), std::forward<Types>(args)...);
   }
+
+  /**
+   * @brief Appends the binary representation of the `value` to the `result`.
+   *
+   * @remarks This function participates in overload resolution only if the
+   * binary format is supported by `DataConversions`.
+   */
+  template<typename U, class DC = DataConversions>
+  static auto append_binary(std::string& result, U&& value)
+    -> decltype(DC::append_binary(result, std::forward<U>(value)))
+  {
+    return DC::append_binary(result, std::forward<U>(value));
+  }
 };
 
 } // namespace dmitigr::pgfe
@@ -147,6 +147,28 @@ enum class Transaction_status {
 
 // =============================================================================
 
+/**
+ * @ingroup main
+ *
+ * @brief A pipeline status.
+ */
+enum class Pipeline_status {
+  /// The connection is not in pipeline mode.
+  disabled = 0,
+
+  /// The connection is in pipeline mode.
+  enabled = 100,
+
+  /**
+   * The connection is in pipeline mode and an error occurred while processing
+   * the current pipeline. The aborted flag is cleared when the result of the
+   * synchronization point is processed.
+   */
+  aborted = 200
+};
+
+// =============================================================================
+
 /**
  * @ingroup main
  *
@@ -162,6 +184,21 @@ enum class Data_format {
 
 // =============================================================================
 
+/**
+ * @ingroup main
+ *
+ * @brief A data direction.
+ */
+enum class Data_direction {
+  /// To the server.
+  to_server = 1,
+
+  /// From the server.
+  from_server = 2
+};
+
+// =============================================================================
+
 /**
  * @ingroup main
  *
@@ -0,0 +1,149 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "binary_copy.hpp"
+
+#include <cstring>
+
+namespace dmitigr::pgfe {
+
+namespace {
+
+/// The signature of the binary format of `COPY`.
+constexpr std::string_view binary_copy_signature{"PGCOPY\n\377\r\n\0", 11};
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Binary_copy_encoder
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE void Binary_copy_encoder::finish()
+{
+  assert(!is_finished());
+  append_integer__(std::int16_t{-1});
+  is_finished_ = true;
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_encoder::reset()
+{
+  buffer_.clear();
+  buffer_.append(binary_copy_signature);
+  append_integer__(std::int32_t{}); // flags
+  append_integer__(std::int32_t{}); // header extension length
+  is_finished_ = false;
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_encoder::append_field_size__(const std::size_t size)
+{
+  if (size > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+    throw std::runtime_error{"field is too large for COPY"};
+  append_integer__(static_cast<std::int32_t>(size));
+}
+
+// -----------------------------------------------------------------------------
+// Binary_copy_decoder
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE void Binary_copy_decoder::append(const std::string_view data)
+{
+  // Discard the consumed data to keep the buffer from growing infinitely.
+  if (offset_ && offset_ >= buffer_.size() / 2) {
+    buffer_.erase(0, offset_);
+    if (row_end_)
+      row_end_ -= offset_;
+    offset_ = 0;
+  }
+  buffer_.append(data);
+}
+
+DMITIGR_PGFE_INLINE bool Binary_copy_decoder::has_row()
+{
+  if (row_end_)
+    return true;
+  else if (is_finished_)
+    return false;
+
+  const auto available = [this](const std::size_t pos, const std::size_t size) noexcept
+  {
+    return pos <= buffer_.size() && size <= buffer_.size() - pos;
+  };
+
+  if (!is_header_read_) {
+    constexpr std::size_t header_size{binary_copy_signature.size() + 2*sizeof(std::int32_t)};
+    if (!available(offset_, header_size))
+      return false;
+    else if (std::memcmp(buffer_.data() + offset_, binary_copy_signature.data(),
+        binary_copy_signature.size()))
+      throw std::runtime_error{"invalid signature of binary COPY data"};
+
+    const auto ext_pos = offset_ + binary_copy_signature.size() + sizeof(std::int32_t);
+    const auto ext_size = net::conv<std::int32_t>(buffer_.data() + ext_pos, sizeof(std::int32_t));
+    if (ext_size < 0)
+      throw std::runtime_error{"invalid header extension length of binary COPY data"};
+    else if (!available(offset_ + header_size, static_cast<std::size_t>(ext_size)))
+      return false;
+
+    offset_ += header_size + static_cast<std::size_t>(ext_size);
+    is_header_read_ = true;
+  }
+
+  if (!available(offset_, sizeof(std::int16_t)))
+    return false;
+
+  const auto field_count = net::conv<std::int16_t>(buffer_.data() + offset_, sizeof(std::int16_t));
+  if (field_count == -1) {
+    offset_ += sizeof(std::int16_t);
+    is_finished_ = true;
+    return false;
+  } else if (field_count < 0)
+    throw std::runtime_error{"invalid field count of binary COPY row"};
+
+  auto pos = offset_ + sizeof(std::int16_t);
+  for (std::int16_t i{}; i < field_count; ++i) {
+    if (!available(pos, sizeof(std::int32_t)))
+      return false;
+    const auto size = net::conv<std::int32_t>(buffer_.data() + pos, sizeof(std::int32_t));
+    pos += sizeof(std::int32_t);
+    if (size > 0) {
+      if (!available(pos, static_cast<std::size_t>(size)))
+        return false;
+      pos += static_cast<std::size_t>(size);
+    } else if (size < -1)
+      throw std::runtime_error{"invalid field size of binary COPY row"};
+  }
+  row_end_ = pos;
+  return true;
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_decoder::begin_row__(const std::size_t field_count)
+{
+  assert(row_end_);
+  const auto count = net::conv<std::int16_t>(buffer_.data() + offset_, sizeof(std::int16_t));
+  if (static_cast<std::size_t>(count) != field_count)
+    throw std::runtime_error{"unexpected number of fields in binary COPY row"};
+  offset_ += sizeof(std::int16_t);
+  if (offset_ == row_end_)
+    row_end_ = 0;
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::string_view> Binary_copy_decoder::next_field__()
+{
+  assert(row_end_ && offset_ < row_end_);
+  const auto size = net::conv<std::int32_t>(buffer_.data() + offset_, sizeof(std::int32_t));
+  offset_ += sizeof(std::int32_t);
+  if (size < 0) {
+    if (offset_ == row_end_)
+      row_end_ = 0;
+    return std::nullopt;
+  }
+
+  const std::string_view result{buffer_.data() + offset_, static_cast<std::size_t>(size)};
+  offset_ += result.size();
+  if (offset_ == row_end_)
+    row_end_ = 0;
+  return result;
+}
+
+} // namespace dmitigr::pgfe
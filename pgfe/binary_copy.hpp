@@ -0,0 +1,424 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_BINARY_COPY_HPP
+#define DMITIGR_PGFE_BINARY_COPY_HPP
+
+#include "basics.hpp"
+#include "conversions.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup conversions
+ *
+ * @brief The conversions of the user type `T` to/from the row of the binary
+ * format of `COPY`.
+ *
+ * @details The specialization must provide:
+ *   -# the type `Tuple` - the `std::tuple` of the types of the fields to decode;
+ *   -# the function `static auto to_tuple(const T&)` which returns the tuple
+ *   of the fields to encode (for example, by using `std::tie()`);
+ *   -# the function `static T to_type(Tuple&&)`.
+ *
+ * @see Binary_copy_encoder, Binary_copy_decoder.
+ */
+template<typename> struct Binary_copy_conversions;
+
+namespace detail {
+
+template<typename>
+struct Is_tuple : std::false_type {};
+
+template<typename ... Types>
+struct Is_tuple<std::tuple<Types...>> : std::true_type {};
+
+template<typename>
+struct Is_optional : std::false_type {};
+
+template<typename T>
+struct Is_optional<std::optional<T>> : std::true_type {};
+
+template<typename T, typename = void>
+struct Has_binary_conversions : std::false_type {};
+
+template<typename T>
+struct Has_binary_conversions<T, std::void_t<decltype(Conversions<T>::append_binary(
+  std::declval<std::string&>(), std::declval<const T&>()))>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @ingroup main
+ *
+ * @brief The encoder of the data in the binary format of `COPY`.
+ *
+ * The fields are encoded directly into the buffer of the encoder without
+ * creating the intermediate Data objects for the types which provide
+ * `Conversions<T>::append_binary()` (all the numeric types, `bool`,
+ * `std::chrono::system_clock::time_point`, `std::vector<std::byte>` and
+ * `std::array<std::byte, 16>`) and for the strings. The values of the other
+ * types are converted by using `to_data(value, Data_format::binary)`.
+ *
+ * The buffer is intended to be reused: after sending its content by using
+ * Copier::send() it can be cleared by using clear() without deallocation.
+ *
+ * @par Example
+ * @code
+ * conn.execute("copy tab from stdin (format binary)");
+ * auto copier = conn.copier();
+ * Binary_copy_encoder encoder;
+ * for (...) {
+ *   encoder.append_row(id, value);
+ *   if (encoder.size() >= 65536) {
+ *     copier.send(encoder.data());
+ *     encoder.clear();
+ *   }
+ * }
+ * encoder.finish();
+ * copier.send(encoder.data());
+ * copier.end();
+ * @endcode
+ *
+ * @see Copier.
+ */
+class Binary_copy_encoder final {
+public:
+  /**
+   * @brief The default constructor.
+   *
+   * @par Effects
+   * `data()` contains the header of the binary format of `COPY`.
+   */
+  Binary_copy_encoder()
+  {
+    reset();
+  }
+
+  /// @returns The encoded data.
+  std::string_view data() const noexcept
+  {
+    return buffer_;
+  }
+
+  /// @returns The size of the encoded data in bytes.
+  std::size_t size() const noexcept
+  {
+    return buffer_.size();
+  }
+
+  /// @returns `true` if the trailer is appended.
+  bool is_finished() const noexcept
+  {
+    return is_finished_;
+  }
+
+  /**
+   * @brief Appends the row of the `values`.
+   *
+   * The values of type `std::nullptr_t` and the empty `std::optional` are
+   * encoded as `NULL`.
+   *
+   * @par Requires
+   * `(!is_finished())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename ... Types>
+  void append_row(Types&& ... values)
+  {
+    static_assert(sizeof...(Types) <= std::numeric_limits<std::int16_t>::max());
+    assert(!is_finished());
+    append_integer__(static_cast<std::int16_t>(sizeof...(Types)));
+    (append_field__(std::forward<Types>(values)), ...);
+  }
+
+  /**
+   * @brief Appends the row of the fields of the `value`.
+   *
+   * @tparam T Either `std::tuple` or the type for which the specialization
+   * of Binary_copy_conversions is provided.
+   *
+   * @par Requires
+   * `(!is_finished())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename T>
+  void append(const T& value)
+  {
+    if constexpr (detail::Is_tuple<T>::value)
+      std::apply([this](const auto& ... fields) { append_row(fields...); }, value);
+    else
+      append(Binary_copy_conversions<T>::to_tuple(value));
+  }
+
+  /**
+   * @brief Appends the trailer of the binary format of `COPY`.
+   *
+   * @par Requires
+   * `(!is_finished())`.
+   *
+   * @par Effects
+   * `is_finished()`.
+   */
+  DMITIGR_PGFE_API void finish();
+
+  /**
+   * @brief Clears the encoded data without releasing the memory.
+   *
+   * @par Effects
+   * `(size() == 0)`. The header is not appended again.
+   */
+  void clear() noexcept
+  {
+    buffer_.clear();
+  }
+
+  /**
+   * @brief Resets the encoder to the initial state in order to encode the
+   * data of the another `COPY` operation.
+   *
+   * @par Effects
+   * `data()` contains the header of the binary format of `COPY`.
+   */
+  DMITIGR_PGFE_API void reset();
+
+private:
+  std::string buffer_;
+  bool is_finished_{};
+
+  template<typename T>
+  void append_integer__(const T value)
+  {
+    const auto offset = buffer_.size();
+    buffer_.resize(offset + sizeof(T));
+    net::copy(buffer_.data() + offset, sizeof(T), value);
+  }
+
+  DMITIGR_PGFE_API void append_field_size__(std::size_t size);
+
+  void append_bytes__(const std::string_view bytes)
+  {
+    append_field_size__(bytes.size());
+    buffer_.append(bytes);
+  }
+
+  template<typename T>
+  void append_field__(T&& value)
+  {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, std::nullptr_t>) {
+      append_integer__(std::int32_t{-1});
+    } else if constexpr (detail::Is_optional<U>::value) {
+      if (value)
+        append_field__(*std::forward<T>(value));
+      else
+        append_integer__(std::int32_t{-1});
+    } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+      append_bytes__(value);
+    } else if constexpr (detail::Has_binary_conversions<U>::value) {
+      const auto offset = buffer_.size();
+      append_integer__(std::int32_t{});
+      Conversions<U>::append_binary(buffer_, value);
+      const auto size = buffer_.size() - offset - sizeof(std::int32_t);
+      if (size > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+        throw std::runtime_error{"field is too large for COPY"};
+      net::copy(buffer_.data() + offset, sizeof(std::int32_t), static_cast<std::int32_t>(size));
+    } else {
+      if (const auto data = to_data(std::forward<T>(value), Data_format::binary)) {
+        if (data->format() != Data_format::binary)
+          throw std::runtime_error{"no binary representation of the value for COPY"};
+        append_bytes__({static_cast<const char*>(data->bytes()), data->size()});
+      } else
+        append_integer__(std::int32_t{-1});
+    }
+  }
+};
+
+/**
+ * @ingroup main
+ *
+ * @brief The decoder of the data in the binary format of `COPY`.
+ *
+ * The data can be appended in the portions of arbitrary size (for example,
+ * as received by Copier::receive()). The fields are decoded by using `to()`
+ * from the views of the appended data, therefore the conversions must support
+ * the binary format for the types of the fields.
+ *
+ * @par Example
+ * @code
+ * conn.execute("copy tab to stdout (format binary)");
+ * auto copier = conn.copier();
+ * Binary_copy_decoder decoder;
+ * while (const auto data = copier.receive()) {
+ *   decoder.append(*data);
+ *   while (decoder.has_row()) {
+ *     const auto [id, value] = decoder.read_row<int, std::optional<std::string>>();
+ *     // ...
+ *   }
+ * }
+ * @endcode
+ *
+ * @see Copier.
+ */
+class Binary_copy_decoder final {
+public:
+  /**
+   * @brief Appends the portion of the data to decode.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  DMITIGR_PGFE_API void append(std::string_view data);
+
+  /// @overload
+  void append(const Data& data)
+  {
+    append({static_cast<const char*>(data.bytes()), data.size()});
+  }
+
+  /**
+   * @returns `true` if the appended data contains the whole row to read.
+   *
+   * @throws `std::runtime_error` if the data is not in the binary format of
+   * `COPY`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  DMITIGR_PGFE_API bool has_row();
+
+  /// @returns `true` if the trailer is decoded.
+  bool is_finished() const noexcept
+  {
+    return is_finished_;
+  }
+
+  /**
+   * @returns The next row of the fields of the types `Types`.
+   *
+   * @par Requires
+   * `has_row()`.
+   *
+   * @throws `std::runtime_error` if the number of the fields of the row is not
+   * equals to `sizeof...(Types)`, or if `NULL` is read into the field of type
+   * other than `std::optional`.
+   *
+   * @par Effects
+   * The row is consumed even if an exception is thrown.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename ... Types>
+  std::tuple<Types...> read_row()
+  {
+    try {
+      begin_row__(sizeof...(Types));
+      return std::tuple<Types...>{read_field__<Types>()...}; // left-to-right
+    } catch (...) {
+      skip_row__();
+      throw;
+    }
+  }
+
+  /**
+   * @returns The next row converted to the object of type `T`.
+   *
+   * @tparam T Either `std::tuple` or the type for which the specialization
+   * of Binary_copy_conversions is provided.
+   *
+   * @par Requires
+   * `has_row()`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename T>
+  T read()
+  {
+    if constexpr (detail::Is_tuple<T>::value)
+      return read_tuple__(static_cast<T*>(nullptr));
+    else
+      return Binary_copy_conversions<T>::to_type(read<typename Binary_copy_conversions<T>::Tuple>());
+  }
+
+private:
+  std::string buffer_;
+  std::size_t offset_{};
+  std::size_t row_end_{};
+  bool is_header_read_{};
+  bool is_finished_{};
+
+  /// Throws if the row doesn't consist of `field_count` fields.
+  DMITIGR_PGFE_API void begin_row__(std::size_t field_count);
+
+  /// Skips the rest of the current row.
+  void skip_row__() noexcept
+  {
+    if (row_end_) {
+      offset_ = row_end_;
+      row_end_ = 0;
+    }
+  }
+
+  /// @returns The bytes of the next field, or `std::nullopt` if `NULL`.
+  DMITIGR_PGFE_API std::optional<std::string_view> next_field__();
+
+  template<typename ... Types>
+  std::tuple<Types...> read_tuple__(std::tuple<Types...>*)
+  {
+    return read_row<Types...>();
+  }
+
+  template<typename T>
+  T read_field__()
+  {
+    const auto bytes = next_field__();
+    if constexpr (detail::Is_optional<T>::value) {
+      if (!bytes)
+        return std::nullopt;
+      return to_field__<typename T::value_type>(*bytes);
+    } else {
+      if (!bytes)
+        throw std::runtime_error{"unexpected NULL in COPY row"};
+      return to_field__<T>(*bytes);
+    }
+  }
+
+  template<typename T>
+  static T to_field__(const std::string_view bytes)
+  {
+    if constexpr (std::is_same_v<T, std::string>)
+      return T{bytes};
+    else
+      return to<T>(Data_view{bytes.data(), static_cast<int>(bytes.size()), Data_format::binary});
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#ifdef DMITIGR_PGFE_HEADER_ONLY
+#include "binary_copy.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_BINARY_COPY_HPP
@@ -45,6 +45,7 @@ public:
 
 private:
   friend Composite;
+  friend Flat_composite;
   friend Row;
   friend Row_info;
 
@@ -230,18 +230,28 @@ DMITIGR_PGFE_INLINE Response_status Connection::handle_input(const bool wait_res
   const auto handle_single_tuple = [this]
   {
     assert(response_status_ == Response_status::ready);
-    assert(response_.status() == PGRES_SINGLE_TUPLE);
+    assert(detail::pq::is_rows_portion(response_.status()));
     assert(!requests_.empty());
     assert(requests_.front() == Request_id::execute);
     if (!shared_field_names_)
       shared_field_names_ = Row_info::make_shared_field_names(response_);
+    trace_response__(false);
   };
 
   const auto dismiss_request = [this]() noexcept
   {
     if (!requests_.empty()) {
       last_processed_request_id_ = requests_.front();
-      requests_.pop();
+      pop_request_front__();
+
+      /*
+       * In pipeline mode libpq allows to switch to the single-row mode only
+       * the request which is currently processed. Thus, the mode is switched
+       * just after the next request becomes current.
+       */
+      if (!requests_.empty() && requests_.front() == Request_id::execute &&
+        pipeline_status() != Pipeline_status::disabled)
+        set_rows_mode();
     }
   };
 
@@ -251,7 +261,8 @@ DMITIGR_PGFE_INLINE Response_status Connection::handle_input(const bool wait_res
       status == PGRES_COMMAND_OK ||
       status == PGRES_TUPLES_OK ||
       status == PGRES_EMPTY_QUERY ||
-      status == PGRES_BAD_RESPONSE;
+      status == PGRES_BAD_RESPONSE ||
+      status == PGRES_PIPELINE_ABORTED;
   };
 
   if (wait_response) {
@@ -262,13 +273,17 @@ DMITIGR_PGFE_INLINE Response_status Connection::handle_input(const bool wait_res
       dismiss_request();
     } else {
       response_.reset(::PQgetResult(conn()));
-      if (response_.status() == PGRES_SINGLE_TUPLE) {
+      if (detail::pq::is_rows_portion(response_.status())) {
         response_status_ = Response_status::ready;
         handle_single_tuple();
         goto handle_notifications;
       } else if (is_completion_status(response_.status()))
         goto complete_response;
-      else if (response_)
+      else if (response_.status() == PGRES_PIPELINE_SYNC) {
+        // Note: there is no terminating nullptr after the synchronization point.
+        response_status_ = Response_status::ready;
+        dismiss_request();
+      } else if (response_)
         response_status_ = Response_status::ready;
       else
         response_status_ = Response_status::empty;
@@ -300,13 +315,16 @@ DMITIGR_PGFE_INLINE Response_status Connection::handle_input(const bool wait_res
     } else {
       if (!is_get_result_would_block(conn())) {
         response_.reset(::PQgetResult(conn()));
-        if (response_.status() == PGRES_SINGLE_TUPLE) {
+        if (detail::pq::is_rows_portion(response_.status())) {
           response_status_ = Response_status::ready;
           handle_single_tuple();
           goto handle_notifications;
         } else if (is_completion_status(response_.status())) {
           response_status_ = Response_status::unready;
           goto try_complete_response;
+        } else if (response_.status() == PGRES_PIPELINE_SYNC) {
+          response_status_ = Response_status::ready;
+          dismiss_request();
         } else if (response_)
           response_status_ = Response_status::ready;
         else
@@ -319,32 +337,39 @@ DMITIGR_PGFE_INLINE Response_status Connection::handle_input(const bool wait_res
   if (response_status_ == Response_status::ready) {
     const auto rstatus = response_.status();
     assert(rstatus != PGRES_NONFATAL_ERROR);
-    assert(rstatus != PGRES_SINGLE_TUPLE);
+    assert(!detail::pq::is_rows_portion(rstatus));
     if (rstatus == PGRES_TUPLES_OK) {
       assert(last_processed_request_id_ == Request_id::execute);
       shared_field_names_.reset();
-    } else if (rstatus == PGRES_FATAL_ERROR) {
+    } else if (rstatus == PGRES_FATAL_ERROR || rstatus == PGRES_PIPELINE_ABORTED) {
       shared_field_names_.reset();
-      request_prepared_statement_ = {};
-      request_prepared_statement_name_.reset();
+      if (last_processed_request_id_ == Request_id::prepare) {
+        if (!request_prepared_statements_.empty())
+          request_prepared_statements_.pop_front();
+      } else if (last_processed_request_id_ == Request_id::describe ||
+        last_processed_request_id_ == Request_id::unprepare) {
+        if (!request_prepared_statement_names_.empty())
+          request_prepared_statement_names_.pop_front();
+      }
     } else if (rstatus == PGRES_COMMAND_OK) {
-      assert(last_processed_request_id_ != Request_id::prepare || request_prepared_statement_);
-      assert(last_processed_request_id_ != Request_id::describe || request_prepared_statement_name_);
-      assert(last_processed_request_id_ != Request_id::unprepare || request_prepared_statement_name_);
+      assert(last_processed_request_id_ != Request_id::prepare || !request_prepared_statements_.empty());
+      assert(last_processed_request_id_ != Request_id::describe || !request_prepared_statement_names_.empty());
+      assert(last_processed_request_id_ != Request_id::unprepare || !request_prepared_statement_names_.empty());
       if (last_processed_request_id_ == Request_id::prepare) {
-        last_prepared_statement_ = register_ps(std::move(request_prepared_statement_));
-        assert(!request_prepared_statement_);
+        last_prepared_statement_ = register_ps(std::move(request_prepared_statements_.front()));
+        request_prepared_statements_.pop_front();
       } else if (last_processed_request_id_ == Request_id::describe) {
-        last_prepared_statement_ = ps(*request_prepared_statement_name_);
+        auto& name = request_prepared_statement_names_.front();
+        last_prepared_statement_ = ps(name);
         if (!last_prepared_statement_)
-          last_prepared_statement_ = register_ps(Prepared_statement{std::move(*request_prepared_statement_name_),
+          last_prepared_statement_ = register_ps(Prepared_statement{std::move(name),
             this, static_cast<std::size_t>(response_.field_count())});
         last_prepared_statement_->set_description(std::move(response_));
-        request_prepared_statement_name_.reset();
+        request_prepared_statement_names_.pop_front();
       } else if (last_processed_request_id_ == Request_id::unprepare) {
-        assert(request_prepared_statement_name_ && !std::strcmp(response_.command_tag(), "DEALLOCATE"));
-        unregister_ps(*request_prepared_statement_name_);
-        request_prepared_statement_name_.reset();
+        assert(!std::strcmp(response_.command_tag(), "DEALLOCATE"));
+        unregister_ps(request_prepared_statement_names_.front());
+        request_prepared_statement_names_.pop_front();
       }
     }
   } else if (response_status_ == Response_status::empty)
@@ -433,6 +458,9 @@ DMITIGR_PGFE_INLINE Completion Connection::completion() noexcept
       assert(false);
       std::terminate();
     }
+  case PGRES_PIPELINE_SYNC:
+    response_.reset();
+    return Completion{"sync"};
   case PGRES_EMPTY_QUERY:
     return Completion{""};
   case PGRES_BAD_RESPONSE:
@@ -445,17 +473,21 @@ DMITIGR_PGFE_INLINE Completion Connection::completion() noexcept
 DMITIGR_PGFE_INLINE void Connection::describe_nio(const std::string& name)
 {
   assert(is_ready_for_nio_request());
-  assert(!request_prepared_statement_name_);
 
-  requests_.push(Request_id::describe); // can throw
+  request_prepared_statement_names_.push_back(name); // can throw
   try {
-    auto name_copy = name;
-    const int send_ok = ::PQsendDescribePrepared(conn(), name.c_str());
-    if (!send_ok)
-      throw std::runtime_error{error_message()};
-    request_prepared_statement_name_ = std::move(name_copy); // cannot throw
+    push_request__(Request_id::describe, 0, name); // can throw
+    try {
+      const int send_ok = ::PQsendDescribePrepared(conn(), name.c_str());
+      if (!send_ok)
+        throw std::runtime_error{error_message()};
+    } catch (...) {
+      pop_request_back__(); // rollback
+      throw;
+    }
+    trace_send__({});
   } catch (...) {
-    requests_.pop(); // rollback
+    request_prepared_statement_names_.pop_back(); // rollback
     throw;
   }
 
@@ -465,14 +497,66 @@ DMITIGR_PGFE_INLINE void Connection::describe_nio(const std::string& name)
 DMITIGR_PGFE_INLINE void Connection::unprepare_nio(const std::string& name)
 {
   assert(!name.empty());
-  assert(!request_prepared_statement_name_);
 
-  auto name_copy = name; // can throw
-  const auto query = "DEALLOCATE " + to_quoted_identifier(name); // can throw
-  execute_nio(query); // can throw
-  assert(requests_.front() == Request_id::execute);
-  requests_.front() = Request_id::unprepare; // cannot throw
-  request_prepared_statement_name_ = std::move(name_copy); // cannot throw
+  const Sql_string statement{"DEALLOCATE " + to_quoted_identifier(name)}; // can throw
+  request_prepared_statement_names_.push_back(name); // can throw
+  try {
+    /*
+     * The statement is executed directly rather than by execute_nio() in
+     * order to never be tracked by the statement cache, since unprepare() is
+     * called upon the eviction from it.
+     */
+    Prepared_statement ps{"", this, &statement};
+    ps.execute_nio__(&statement, true); // can throw
+  } catch (...) {
+    request_prepared_statement_names_.pop_back(); // rollback
+    throw;
+  }
+  assert(requests_.back() == Request_id::unprepare);
+
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE Pipeline_status Connection::pipeline_status() const noexcept
+{
+  switch (::PQpipelineStatus(conn())) {
+  case PQ_PIPELINE_ON:      return Pipeline_status::enabled;
+  case PQ_PIPELINE_ABORTED: return Pipeline_status::aborted;
+  default:                  return Pipeline_status::disabled;
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection::set_pipeline_enabled(const bool value)
+{
+  assert(is_connected());
+  assert(value || !has_uncompleted_request());
+
+  const int ok = value ? ::PQenterPipelineMode(conn()) : ::PQexitPipelineMode(conn());
+  if (!ok)
+    throw std::runtime_error{error_message()};
+
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE void Connection::send_sync()
+{
+  assert(pipeline_status() != Pipeline_status::disabled);
+
+  push_request__(Request_id::sync); // can throw
+  if (!::PQpipelineSync(conn())) {
+    pop_request_back__(); // rollback
+    throw std::runtime_error{error_message()};
+  }
+
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE void Connection::send_flush()
+{
+  assert(pipeline_status() != Pipeline_status::disabled);
+
+  if (!::PQsendFlushRequest(conn()) || ::PQflush(conn()) == -1)
+    throw std::runtime_error{error_message()};
 
   assert(is_invariant_ok());
 }
@@ -529,27 +613,35 @@ DMITIGR_PGFE_INLINE bool Connection::is_invariant_ok() const noexcept
     (*polling_status_ == Status::establishment_reading) ||
     (*polling_status_ == Status::establishment_writing);
   const bool requests_ok = !is_connected() || is_ready_for_nio_request() || !requests_.empty();
-  const bool shared_field_names_ok = (!response_ || response_.status() != PGRES_SINGLE_TUPLE) || shared_field_names_;
+  const bool request_metrics_ok = request_metrics_.size() <= requests_.size();
+  const bool shared_field_names_ok = (!response_ || !detail::pq::is_rows_portion(response_.status())) || shared_field_names_;
   const bool session_start_time_ok = (status() == Status::connected) == static_cast<bool>(session_start_time_);
   const bool session_data_empty =
     !session_start_time_ &&
     !response_ &&
     (response_status_ == Response_status::empty) &&
     named_prepared_statements_.empty() &&
+    named_prepared_statements_index_.empty() &&
     !unnamed_prepared_statement_ &&
     !shared_field_names_ &&
     requests_.empty() &&
-    !request_prepared_statement_ &&
-    !request_prepared_statement_name_;
+    request_prepared_statements_.empty() &&
+    request_prepared_statement_names_.empty() &&
+    request_metrics_.empty();
   const bool session_data_ok = session_data_empty || (status() == Status::failure) || (status() == Status::connected);
   const bool trans_ok = !is_connected() || transaction_status();
   const bool sess_time_ok = !is_connected() || session_start_time();
   const bool pid_ok = !is_connected() || server_pid();
   const bool readiness_ok = is_ready_for_nio_request() || !is_ready_for_request();
+  const bool named_ps_index_ok = named_prepared_statements_.size() == named_prepared_statements_index_.size();
+  const bool statement_cache_ok =
+    (statement_cache_.size() == statement_cache_index_.size()) &&
+    (statement_cache_.size() <= statement_cache_capacity_);
 
   // std::clog << conn_ok << " "
   //           << polling_status_ok << " "
   //           << requests_ok << " "
+  //           << request_metrics_ok << " "
   //           << shared_field_names_ok << " "
   //           << session_start_time_ok << " "
   //           << session_data_ok << " "
@@ -557,19 +649,33 @@ DMITIGR_PGFE_INLINE bool Connection::is_invariant_ok() const noexcept
   //           << sess_time_ok << " "
   //           << pid_ok << " "
   //           << readiness_ok << " "
+  //           << named_ps_index_ok << " "
+  //           << statement_cache_ok << " "
   //           << std::endl;
 
   return
     conn_ok &&
     polling_status_ok &&
     requests_ok &&
+    request_metrics_ok &&
     shared_field_names_ok &&
     session_start_time_ok &&
     session_data_ok &&
     trans_ok &&
     sess_time_ok &&
     pid_ok &&
-    readiness_ok;
+    readiness_ok &&
+    named_ps_index_ok &&
+    statement_cache_ok;
+}
+
+DMITIGR_PGFE_INLINE bool Connection::set_rows_mode() noexcept
+{
+#ifdef LIBPQ_HAS_CHUNK_MODE
+  if (row_batch_size_ > 1)
+    return ::PQsetChunkedRowsMode(conn(), static_cast<int>(row_batch_size_));
+#endif
+  return ::PQsetSingleRowMode(conn());
 }
 
 DMITIGR_PGFE_INLINE void Connection::reset_session() noexcept
@@ -581,12 +687,13 @@ DMITIGR_PGFE_INLINE void Connection::reset_session() noexcept
   last_prepared_statement_ = {};
   shared_field_names_.reset();
 
-  named_prepared_statements_.clear();
+  unregister_named_ps();
   unnamed_prepared_statement_ = {};
 
-  requests_ = {};
-  request_prepared_statement_ = {};
-  request_prepared_statement_name_.reset();
+  requests_.clear();
+  request_prepared_statements_.clear();
+  request_prepared_statement_names_.clear();
+  request_metrics_.clear();
 }
 
 DMITIGR_PGFE_INLINE void Connection::notice_receiver(void* const arg, const ::PGresult* const r) noexcept
@@ -616,36 +723,149 @@ Connection::prepare_nio__(const char* const query, const char* const name, const
   assert(query);
   assert(name);
   assert(is_ready_for_nio_request());
-  assert(!request_prepared_statement_);
 
-  requests_.push(Request_id::prepare); // can throw
+  request_prepared_statements_.emplace_back(); // can throw
   try {
-    Prepared_statement ps{name, this, preparsed};
-    constexpr int n_params{0};
-    constexpr const ::Oid* const param_types{};
-    const int send_ok = ::PQsendPrepare(conn(), name, query, n_params, param_types);
-    if (!send_ok)
-      throw std::runtime_error{error_message()};
-    request_prepared_statement_ = std::move(ps); // cannot throw
+    const auto hash = query_hash(query);
+    push_request__(Request_id::prepare, hash, name); // can throw
+    try {
+      Prepared_statement ps{name, this, preparsed};
+      ps.query_hash_ = hash;
+      constexpr int n_params{0};
+      constexpr const ::Oid* const param_types{};
+      const int send_ok = ::PQsendPrepare(conn(), name, query, n_params, param_types);
+      if (!send_ok)
+        throw std::runtime_error{error_message()};
+      request_prepared_statements_.back() = std::move(ps); // cannot throw
+    } catch (...) {
+      pop_request_back__(); // rollback
+      throw;
+    }
+    trace_send__(query);
   } catch (...) {
-    requests_.pop(); // rollback
+    request_prepared_statements_.pop_back(); // rollback
     throw;
   }
 
   assert(is_invariant_ok());
 }
 
+DMITIGR_PGFE_INLINE void Connection::push_request__(const Request_id id,
+  const std::uint64_t query_hash, const std::string& statement_name)
+{
+  /*
+   * The metrics are collected for the last requests_. Once the collection is
+   * started it's continued until all of the traced requests are completed.
+   */
+  const bool is_traced = instrument_ || !request_metrics_.empty();
+  if (is_traced) {
+    Request_metrics metrics;
+    switch (id) {
+    case Request_id::execute: metrics.kind = Request_kind::execution; break;
+    case Request_id::prepare: metrics.kind = Request_kind::preparation; break;
+    case Request_id::describe: metrics.kind = Request_kind::description; break;
+    case Request_id::unprepare: metrics.kind = Request_kind::deallocation; break;
+    case Request_id::sync: metrics.kind = Request_kind::synchronization; break;
+    }
+    metrics.query_hash = query_hash;
+    metrics.statement_name = statement_name;
+    metrics.sent_at = Request_metrics::Clock::now();
+    request_metrics_.push_back(std::move(metrics)); // can throw
+  }
+  try {
+    requests_.push_back(id); // can throw
+  } catch (...) {
+    if (is_traced)
+      request_metrics_.pop_back(); // rollback
+    throw;
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection::pop_request_back__() noexcept
+{
+  assert(!requests_.empty());
+  if (!request_metrics_.empty())
+    request_metrics_.pop_back();
+  requests_.pop_back();
+}
+
+DMITIGR_PGFE_INLINE void Connection::pop_request_front__() noexcept
+{
+  assert(!requests_.empty());
+  if (!request_metrics_.empty() && request_metrics_.size() == requests_.size()) {
+    trace_response__(true);
+    request_metrics_.pop_front();
+  }
+  requests_.pop_front();
+}
+
+DMITIGR_PGFE_INLINE void Connection::trace_send__(const std::string_view query) noexcept
+{
+  if (!instrument_ || request_metrics_.empty())
+    return;
+
+  try {
+    instrument_->on_send(*this, request_metrics_.back(), query);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "Instrument thrown: %s\n", e.what());
+  } catch (...) {
+    std::fprintf(stderr, "Instrument thrown unknown error\n");
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection::trace_response__(const bool is_completion) noexcept
+{
+  if (request_metrics_.empty() || request_metrics_.size() != requests_.size())
+    return;
+
+  auto& metrics = request_metrics_.front();
+  const auto now = Request_metrics::Clock::now();
+  const bool is_first = !metrics.first_response_at;
+  if (is_first)
+    metrics.first_response_at = now;
+  if (is_completion)
+    metrics.completed_at = now;
+
+  if (response_) {
+    const auto status = response_.status();
+    if (detail::pq::is_rows_portion(status) || status == PGRES_TUPLES_OK) {
+      const int row_count = response_.row_count();
+      const int field_count = response_.field_count();
+      for (int i = 0; i < row_count; ++i) {
+        for (int j = 0; j < field_count; ++j)
+          metrics.byte_count += static_cast<std::size_t>(response_.data_size(i, j));
+      }
+      metrics.row_count += static_cast<std::size_t>(row_count);
+      if (!is_completion)
+        ++metrics.result_count;
+    } else if (status == PGRES_FATAL_ERROR)
+      metrics.sqlstate = response_.er_code(); // cannot throw (SSO)
+    else if (status == PGRES_PIPELINE_ABORTED)
+      metrics.is_aborted = true;
+  }
+
+  if (!instrument_ || metrics.kind == Request_kind::synchronization)
+    return;
+
+  try {
+    if (is_first)
+      instrument_->on_first_response(*this, metrics);
+    if (!is_completion)
+      instrument_->on_result(*this, metrics);
+    else
+      instrument_->on_complete(*this, metrics);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "Instrument thrown: %s\n", e.what());
+  } catch (...) {
+    std::fprintf(stderr, "Instrument thrown unknown error\n");
+  }
+}
+
 DMITIGR_PGFE_INLINE Prepared_statement* Connection::ps(const std::string& name) const noexcept
 {
   if (!name.empty()) {
-    const auto b = begin(named_prepared_statements_);
-    const auto e = end(named_prepared_statements_);
-    auto p = std::find_if(b, e,
-      [&name](const auto& ps)
-      {
-        return (ps.name() == name);
-      });
-    return (p != e) ? &*p : nullptr;
+    const auto p = named_prepared_statements_index_.find(name);
+    return (p != cend(named_prepared_statements_index_)) ? &*p->second : nullptr;
   } else
     return unnamed_prepared_statement_ ? &unnamed_prepared_statement_ : nullptr;
 }
@@ -653,8 +873,21 @@ DMITIGR_PGFE_INLINE Prepared_statement* Connection::ps(const std::string& name)
 DMITIGR_PGFE_INLINE Prepared_statement* Connection::register_ps(Prepared_statement&& ps) const noexcept
 {
   if (!ps.name().empty()) {
+    if (const auto p = named_prepared_statements_index_.find(ps.name());
+      p != cend(named_prepared_statements_index_)) {
+      // The key is the view of the name of the statement being replaced.
+      const auto i = p->second;
+      named_prepared_statements_index_.erase(p);
+      *i = std::move(ps);
+      named_prepared_statements_index_.emplace(i->name(), i);
+      return &*i;
+    }
+
     named_prepared_statements_.emplace_front();
-    return &(named_prepared_statements_.front() = std::move(ps));
+    const auto i = begin(named_prepared_statements_);
+    *i = std::move(ps);
+    named_prepared_statements_index_.emplace(i->name(), i);
+    return &*i;
   } else
     return &(unnamed_prepared_statement_ = std::move(ps));
 }
@@ -663,8 +896,103 @@ DMITIGR_PGFE_INLINE void Connection::unregister_ps(const std::string& name) noex
 {
   if (name.empty())
     unnamed_prepared_statement_ = {};
-  else
-    named_prepared_statements_.remove_if([&name](const auto& ps){ return ps.name() == name; });
+  else if (const auto p = named_prepared_statements_index_.find(name);
+    p != cend(named_prepared_statements_index_)) {
+    const auto i = p->second;
+    named_prepared_statements_index_.erase(p);
+    named_prepared_statements_.erase(i);
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection::set_statement_cache_capacity(const std::size_t capacity)
+{
+  shrink_statement_cache__(capacity);
+  statement_cache_capacity_ = capacity;
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE Prepared_statement* Connection::cached_ps__(const Sql_string& statement)
+{
+  assert(statement_cache_capacity_);
+  const auto ts = transaction_status();
+  if (!is_ready_for_request() || ts == Transaction_status::failed)
+    return nullptr;
+
+  auto query = statement.to_query_string();
+  Statement_cache::iterator e;
+  if (const auto i = statement_cache_index_.find(query); i != statement_cache_index_.end()) {
+    e = i->second;
+    statement_cache_.splice(statement_cache_.begin(), statement_cache_, e);
+  } else {
+    statement_cache_.push_front(Statement_cache_entry{std::move(query), {}, 0});
+    e = statement_cache_.begin();
+    try {
+      statement_cache_index_.emplace(e->query, e);
+    } catch (...) {
+      statement_cache_.pop_front();
+      throw;
+    }
+    // The new entry is the most recently used one so it's not evicted.
+    shrink_statement_cache__(statement_cache_capacity_);
+  }
+
+  auto& entry = *e;
+  if (entry.execution_count < statement_cache_threshold_)
+    ++entry.execution_count;
+  if (entry.execution_count < statement_cache_threshold_)
+    return nullptr;
+
+  if (!entry.name.empty()) {
+    if (auto* const result = ps(entry.name))
+      return result;
+  }
+
+  // Prepare outside the transaction block to not affect it on failure.
+  if (ts != Transaction_status::unstarted)
+    return nullptr;
+  else if (entry.name.empty())
+    entry.name = "pgfe_cached_" + std::to_string(++statement_cache_counter_);
+
+  try {
+    return prepare(statement, entry.name);
+  } catch (const Server_exception&) {
+    // Let the unnamed statement to report the error as usual.
+    entry.execution_count = 0;
+    return nullptr;
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection::execute_cached_ps_nio__(Prepared_statement& ps)
+{
+  const auto unbind = [&ps]() noexcept
+  {
+    for (auto& parameter : ps.parameters_)
+      parameter.data.reset();
+  };
+  ps.set_result_format(result_format());
+  try {
+    ps.execute_nio();
+  } catch (...) {
+    unbind();
+    throw;
+  }
+  unbind();
+}
+
+DMITIGR_PGFE_INLINE void Connection::shrink_statement_cache__(const std::size_t size)
+{
+  while (statement_cache_.size() > size) {
+    auto& entry = statement_cache_.back();
+    statement_cache_index_.erase(entry.query);
+    const auto name = std::move(entry.name);
+    statement_cache_.pop_back();
+    if (!name.empty() && ps(name)) {
+      if (is_ready_for_request())
+        unprepare(name);
+      else
+        unregister_ps(name); // it's left on the server
+    }
+  }
 }
 
 DMITIGR_PGFE_INLINE void Connection::throw_if_error()
@@ -8,26 +8,34 @@
 #include "basics.hpp"
 #include "completion.hpp"
 #include "connection_options.hpp"
+#include "copier.hpp"
 #include "data.hpp"
 #include "dll.hpp"
 #include "error.hpp"
+#include "instrumentation.hpp"
 #include "notice.hpp"
 #include "notification.hpp"
 #include "pq.hpp"
 #include "prepared_statement.hpp"
+#include "row.hpp"
+#include "row_batch.hpp"
 #include "sql_string.hpp"
 #include "types_fwd.hpp"
 
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <optional>
-#include <queue>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace dmitigr::pgfe {
@@ -35,6 +43,9 @@ namespace dmitigr::pgfe {
 /// Convenience function to use as row handler.
 inline void ignore_row(Row&&) noexcept {}
 
+/// Convenience function to use as row batch handler.
+inline void ignore_row_batch(Row_batch&&) noexcept {}
+
 /**
  * @ingroup main
  *
@@ -89,7 +100,14 @@ public:
     swap(error_handler_, rhs.error_handler_);
     swap(notice_handler_, rhs.notice_handler_);
     swap(notification_handler_, rhs.notification_handler_);
+    swap(instrument_, rhs.instrument_);
     swap(default_result_format_, rhs.default_result_format_);
+    swap(row_batch_size_, rhs.row_batch_size_);
+    swap(statement_cache_capacity_, rhs.statement_cache_capacity_);
+    swap(statement_cache_threshold_, rhs.statement_cache_threshold_);
+    swap(statement_cache_counter_, rhs.statement_cache_counter_);
+    swap(statement_cache_, rhs.statement_cache_);
+    swap(statement_cache_index_, rhs.statement_cache_index_);
     swap(conn_, rhs.conn_);
     swap(polling_status_, rhs.polling_status_);
     swap(session_start_time_, rhs.session_start_time_);
@@ -99,10 +117,12 @@ public:
     swap(last_prepared_statement_, rhs.last_prepared_statement_);
     swap(shared_field_names_, rhs.shared_field_names_);
     swap(named_prepared_statements_, rhs.named_prepared_statements_);
+    swap(named_prepared_statements_index_, rhs.named_prepared_statements_index_);
     unnamed_prepared_statement_.swap(rhs.unnamed_prepared_statement_);
     swap(requests_, rhs.requests_);
-    request_prepared_statement_.swap(rhs.request_prepared_statement_);
-    swap(request_prepared_statement_name_, rhs.request_prepared_statement_name_);
+    swap(request_prepared_statements_, rhs.request_prepared_statements_);
+    swap(request_prepared_statement_names_, rhs.request_prepared_statement_names_);
+    swap(request_metrics_, rhs.request_metrics_);
   }
 
   /// @name General observers
@@ -238,6 +258,7 @@ public:
   void disconnect() noexcept
   {
     reset_session();
+    polling_status_.reset(); // the establishment can be in progress
     conn_.reset(); // discarding unhandled notifications btw.
     assert(status() == Status::disconnected);
     assert(is_invariant_ok());
@@ -378,6 +399,35 @@ public:
 
   // ---------------------------------------------------------------------------
 
+  /// @name Instrumentation
+  /// @{
+
+  /**
+   * @brief Sets the instrument which observes the requests.
+   *
+   * By default, an instrument isn't set, and the requests are not observed.
+   *
+   * @param instrument An instrument to set. It affects the requests which
+   * are sent after the call.
+   *
+   * @see Instrument, Statement_statistics.
+   */
+  void set_instrument(std::shared_ptr<Instrument> instrument) noexcept
+  {
+    instrument_ = std::move(instrument);
+    assert(is_invariant_ok());
+  }
+
+  /// @returns The current instrument.
+  const std::shared_ptr<Instrument>& instrument() const noexcept
+  {
+    return instrument_;
+  }
+
+  ///@}
+
+  // ---------------------------------------------------------------------------
+
   /// @name Responses
   /// @{
 
@@ -489,6 +539,23 @@ public:
     return (response_.status() == PGRES_SINGLE_TUPLE) ? Row{std::move(response_), shared_field_names_} : Row{};
   }
 
+  /**
+   * @returns The released instance if available.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks Both the chunk of rows and the single row are released by this
+   * method, while the chunk of rows cannot be released by row().
+   *
+   * @see wait_response(), set_row_batch_size(), row().
+   */
+  Row_batch row_batch() noexcept
+  {
+    return detail::pq::is_rows_portion(response_.status()) ?
+      Row_batch{std::move(response_), shared_field_names_} : Row_batch{};
+  }
+
   /**
    * @returns The released instance if available.
    *
@@ -499,6 +566,32 @@ public:
    */
   DMITIGR_PGFE_API Completion completion() noexcept;
 
+  /**
+   * @returns The released instance if available.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks The instance of Copier is available after the execution of the
+   * `COPY` command with either `FROM STDIN` or `TO STDOUT` clause, for example:
+   * @code
+   * conn.execute("copy tab from stdin");
+   * auto copier = conn.copier();
+   * copier.send_row(1, "one");
+   * copier.end();
+   * conn.wait_response_throw();
+   * auto comp = conn.completion(); // COPY 1
+   * @endcode
+   *
+   * @see wait_response(), Copier.
+   */
+  Copier copier() noexcept
+  {
+    const auto s = response_.status();
+    return (s == PGRES_COPY_IN || s == PGRES_COPY_OUT || s == PGRES_COPY_BOTH) ?
+      Copier{*this, std::move(response_)} : Copier{};
+  }
+
   /**
    * @brief Processes the responses.
    *
@@ -506,9 +599,14 @@ public:
    *
    * @tparam on_exception What to do when the callback throws an exception.
    *
-   * @param callback A function to be called for each retrieved row. The callback:
+   * @param callback A function to be called for each retrieved row (or batch
+   * of rows). The callback:
    *   -# can be defined with a parameter of type `Row&&`. An exception will be
-   *   thrown on error in this case.
+   *   thrown on error in this case. Also, an exception will be thrown if the
+   *   chunk of rows is retrieved (see set_row_batch_size());
+   *   -# can be defined with a parameter of type `Row_batch&&` instead of `Row&&`
+   *   in order to process the rows by batches. (Each of the variants listed
+   *   here is applicable to `Row_batch&&` as well);
    *   -# can be defined with two parameters of type `Row&&` and `Error&&`.
    *   In case of error an instance of type Error will be passed as the second
    *   argument of the callback instead of throwing exception and method will
@@ -536,7 +634,7 @@ public:
           std::runtime_error process_responses_error{""};
           try {
             // std::function is used as the workaround for GCC 7.5
-            std::function<void(Row&&, Error&&)> f = [&err](auto&&, auto&& e)
+            std::function<void(Row_batch&&, Error&&)> f = [&err](auto&&, auto&& e)
             {
               if (e)
                 err = std::move(e);
@@ -572,9 +670,9 @@ public:
       if constexpr (Traits::has_error_parameter) {
         wait_response();
         if (auto e = error()) {
-          callback(Row{}, std::move(e));
+          callback(typename Traits::Row_type{}, std::move(e));
           return Completion{};
-        } else if (auto r = row()) {
+        } else if (auto r = release_rows__<typename Traits::Row_type>()) {
           with_complete_on_exception([this, &callback, &rowpro, &r]
           {
             if constexpr (!Traits::is_result_void)
@@ -586,7 +684,7 @@ public:
           return completion();
       } else {
         wait_response_throw();
-        if (auto r = row()) {
+        if (auto r = release_rows__<typename Traits::Row_type>()) {
           with_complete_on_exception([this, &callback, &rowpro, &r]
           {
             if constexpr (!Traits::is_result_void)
@@ -599,7 +697,7 @@ public:
       }
 
       if (rowpro == Row_processing::complete)
-        return process_responses(ignore_row);
+        return process_responses(ignore_row_batch);
       else if (rowpro == Row_processing::suspend)
         return Completion{};
     }
@@ -654,20 +752,94 @@ public:
   bool is_ready_for_nio_request() const noexcept
   {
     const auto ts = transaction_status();
-    return ts && ts != Transaction_status::active;
+    return ts && (ts != Transaction_status::active || pipeline_status() != Pipeline_status::disabled);
   }
 
   /**
    * @returns `true` if the connection is ready for requesting a server.
    *
-   * @see is_ready_for_nio_request().
+   * @remarks Always returns `false` in pipeline mode, since the methods which
+   * waits for a response cannot be used in this mode.
+   *
+   * @see is_ready_for_nio_request(), pipeline_status().
    */
   bool is_ready_for_request() const noexcept
   {
-    // Same as is_ready_for_nio_request() at the moment.
-    return is_ready_for_nio_request();
+    return (pipeline_status() == Pipeline_status::disabled) && is_ready_for_nio_request();
   }
 
+  /**
+   * @returns The pipeline status.
+   *
+   * @see set_pipeline_enabled().
+   */
+  DMITIGR_PGFE_API Pipeline_status pipeline_status() const noexcept;
+
+  /**
+   * @brief Enables or disables the pipeline mode.
+   *
+   * In pipeline mode the requests are submitted without waiting for the
+   * responses to the previously submitted ones. The server doesn't begin to
+   * send the responses until either send_sync() or send_flush() is called.
+   * The responses are processed strictly in order of the requests (e.g. by
+   * using wait_response() or process_responses() for each request). If a
+   * request provokes an error, the responses to all the subsequent requests
+   * up to the next synchronization point are invalid instances of type
+   * Completion, and `(pipeline_status() == Pipeline_status::aborted)` until
+   * the response to the synchronization point is processed.
+   *
+   * @par Requires
+   * `is_connected()`. Also, `!has_uncompleted_request()` in order to disable
+   * the pipeline mode.
+   *
+   * @par Effects
+   * `(pipeline_status() != Pipeline_status::disabled) == value`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks Only the methods with the suffix "_nio" can be used to submit
+   * requests in pipeline mode.
+   *
+   * @see pipeline_status(), send_sync(), send_flush().
+   */
+  DMITIGR_PGFE_API void set_pipeline_enabled(bool value = true);
+
+  /**
+   * @brief Submits a request to a server to establish the synchronization
+   * point in the pipeline and flushes the pending requests.
+   *
+   * @par Responses
+   * Completion with the operation name "sync".
+   *
+   * @par Effects
+   * `has_uncompleted_request()`.
+   *
+   * @par Requires
+   * `(pipeline_status() != Pipeline_status::disabled)`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks This is the only way to recover from the aborted state of the
+   * pipeline. Also, the server commits an implicit transaction (if any) upon
+   * the synchronization point.
+   *
+   * @see set_pipeline_enabled().
+   */
+  DMITIGR_PGFE_API void send_sync();
+
+  /**
+   * @brief Requests a server to send the responses to the requests submitted
+   * so far without establishing the synchronization point.
+   *
+   * @par Requires
+   * `(pipeline_status() != Pipeline_status::disabled)`.
+   *
+   * @see send_sync().
+   */
+  DMITIGR_PGFE_API void send_flush();
+
   /**
    * @brief Submits a request to a server to prepare the statement.
    *
@@ -838,6 +1010,8 @@ public:
    * @par Exception safety guarantee
    * Strong.
    *
+   * @remarks The statement cache is not used. See set_statement_cache_capacity().
+   *
    * @see execute().
    */
   template<typename ... Types>
@@ -874,7 +1048,11 @@ public:
   std::enable_if_t<detail::Response_callback_traits<F>::is_valid, Completion>
   execute(F&& callback, const Sql_string& statement, Types&& ... parameters)
   {
-    execute_nio(statement, std::forward<Types>(parameters)...);
+    if (auto* const cached = statement_cache_capacity_ ? cached_ps__(statement) : nullptr) {
+      cached->bind_many(std::forward<Types>(parameters)...);
+      execute_cached_ps_nio__(*cached);
+    } else
+      execute_nio(statement, std::forward<Types>(parameters)...);
     return process_responses<on_exception>(std::forward<F>(callback));
   }
 
@@ -882,7 +1060,7 @@ public:
   template<Row_processing on_exception = Row_processing::complete, typename ... Types>
   Completion execute(const Sql_string& statement, Types&& ... parameters)
   {
-    return execute<on_exception>([](auto&&){}, statement, std::forward<Types>(parameters)...);
+    return execute<on_exception>(ignore_row_batch, statement, std::forward<Types>(parameters)...);
   }
 
   /**
@@ -954,7 +1132,7 @@ public:
   template<Row_processing on_exception = Row_processing::complete, typename ... Types>
   Completion invoke(std::string_view function, Types&& ... arguments)
   {
-    return invoke<on_exception>([](auto&&){}, function, std::forward<Types>(arguments)...);
+    return invoke<on_exception>(ignore_row_batch, function, std::forward<Types>(arguments)...);
   }
 
   /**
@@ -982,7 +1160,7 @@ public:
   template<Row_processing on_exception = Row_processing::complete, typename ... Types>
   Completion invoke_unexpanded(std::string_view function, Types&& ... arguments)
   {
-    return invoke_unexpanded<on_exception>([](auto&&){}, function, std::forward<Types>(arguments)...);
+    return invoke_unexpanded<on_exception>(ignore_row_batch, function, std::forward<Types>(arguments)...);
   }
 
   /**
@@ -1010,7 +1188,7 @@ public:
   template<Row_processing on_exception = Row_processing::complete, typename ... Types>
   Completion call(std::string_view procedure, Types&& ... arguments)
   {
-    return call<on_exception>([](auto&&){}, procedure, std::forward<Types>(arguments)...);
+    return call<on_exception>(ignore_row_batch, procedure, std::forward<Types>(arguments)...);
   }
 
   /**
@@ -1031,6 +1209,99 @@ public:
     return default_result_format_;
   }
 
+  /**
+   * @brief Sets the maximum number of rows of the result set to be retrieved
+   * from the server at once.
+   *
+   * If `(size > 1)` the rows of the result sets of the subsequently submitted
+   * requests are retrieved in chunks of up to `size` rows, which are available
+   * as instances of type Row_batch. Otherwise, the rows are retrieved one by
+   * one as instances of type Row.
+   *
+   * @par Requires
+   * `(0 < size && size <= std::numeric_limits<int>::max())`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks The chunked rows mode requires libpq 17+. If it's unavailable,
+   * the rows are retrieved one by one regardless of the `size`, and each of
+   * them is available either as Row or as Row_batch of size 1.
+   *
+   * @see row_batch(), process_responses().
+   */
+  void set_row_batch_size(const std::size_t size) noexcept
+  {
+    assert(0 < size && size <= static_cast<std::size_t>(std::numeric_limits<int>::max()));
+    row_batch_size_ = size;
+    assert(is_invariant_ok());
+  }
+
+  /// @returns The maximum number of rows of the result set to be retrieved at once.
+  std::size_t row_batch_size() const noexcept
+  {
+    return row_batch_size_;
+  }
+
+  /**
+   * @brief Sets the maximum number of queries tracked by the statement cache.
+   *
+   * If `(capacity > 0)`, the queries executed by execute() (and thus by
+   * invoke() and call()) are tracked by their text, and the query
+   * executed statement_cache_threshold() times is prepared as the named
+   * statement which is used instead of the unnamed one by the subsequent
+   * executions of the same query. When the capacity is exceeded the least
+   * recently used query is evicted from the cache and its statement is
+   * deallocated.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @remarks The statements are prepared and deallocated synchronously, only
+   * if is_ready_for_request(). The statement is prepared outside the
+   * transaction block only.
+   * @remarks The non-blocking execute_nio() never uses the cache, since it
+   * would have to wait for the preparation or for the deallocation.
+   * @remarks Since the types of the parameters are deduced by the server, the
+   * queries are keyed by their text only.
+   *
+   * @see set_statement_cache_threshold(), statement_cache_size().
+   */
+  DMITIGR_PGFE_API void set_statement_cache_capacity(std::size_t capacity);
+
+  /// @returns The maximum number of queries tracked by the statement cache.
+  std::size_t statement_cache_capacity() const noexcept
+  {
+    return statement_cache_capacity_;
+  }
+
+  /**
+   * @brief Sets the number of the executions of the query after which it's
+   * prepared as the named statement.
+   *
+   * @par Requires
+   * `(threshold > 0)`.
+   *
+   * @see set_statement_cache_capacity().
+   */
+  void set_statement_cache_threshold(const std::size_t threshold) noexcept
+  {
+    assert(threshold > 0);
+    statement_cache_threshold_ = threshold;
+  }
+
+  /// @returns The number of the executions of the query after which it's prepared.
+  std::size_t statement_cache_threshold() const noexcept
+  {
+    return statement_cache_threshold_;
+  }
+
+  /// @returns The number of queries tracked by the statement cache.
+  std::size_t statement_cache_size() const noexcept
+  {
+    return statement_cache_.size();
+  }
+
   ///@}
 
   // ---------------------------------------------------------------------------
@@ -1207,8 +1478,11 @@ public:
 
   ///@}
 private:
+  friend Connection_pool;
+  friend Copier;
   friend Large_object;
   friend Prepared_statement;
+  friend Reactor;
 
   // ---------------------------------------------------------------------------
   // Persistent data
@@ -1221,13 +1495,27 @@ private:
   Error_handler error_handler_;
   Notice_handler notice_handler_{&default_notice_handler};
   Notification_handler notification_handler_;
+  std::shared_ptr<Instrument> instrument_;
   Data_format default_result_format_{Data_format::text};
+  std::size_t row_batch_size_{1};
+  std::size_t statement_cache_capacity_{};
+  std::size_t statement_cache_threshold_{5};
 
   // Persistent data / private-modifiable data
   std::unique_ptr< ::PGconn> conn_;
   std::optional<Status> polling_status_;
   ::PGconn* conn() const noexcept { return conn_.get(); }
 
+  struct Statement_cache_entry final {
+    std::string query;
+    std::string name; // of the prepared statement
+    std::size_t execution_count{};
+  };
+  using Statement_cache = std::list<Statement_cache_entry>; // the most recently used first
+  std::size_t statement_cache_counter_{};
+  Statement_cache statement_cache_;
+  std::unordered_map<std::string_view, Statement_cache::iterator> statement_cache_index_;
+
   // ---------------------------------------------------------------------------
   // Session data / requests data
   // ---------------------------------------------------------------------------
@@ -1236,7 +1524,8 @@ private:
     execute = 1,
     prepare,
     describe,
-    unprepare
+    unprepare,
+    sync
   };
 
   std::optional<std::chrono::system_clock::time_point> session_start_time_;
@@ -1245,17 +1534,66 @@ private:
   Response_status response_status_{}; // status last assigned by handle_input()
   Request_id last_processed_request_id_{}; // type last assigned by handle_input()
   Prepared_statement* last_prepared_statement_{};
-  std::shared_ptr<std::vector<std::string>> shared_field_names_;
+  std::shared_ptr<detail::Field_names> shared_field_names_;
 
   mutable std::list<Prepared_statement> named_prepared_statements_;
+  mutable std::unordered_map<std::string_view,
+    std::list<Prepared_statement>::iterator> named_prepared_statements_index_;
   mutable Prepared_statement unnamed_prepared_statement_;
 
-  std::queue<Request_id> requests_; // for batch mode
-  Prepared_statement request_prepared_statement_;
-  std::optional<std::string> request_prepared_statement_name_;
+  std::deque<Request_id> requests_; // for pipeline mode
+  std::deque<Prepared_statement> request_prepared_statements_;
+  std::deque<std::string> request_prepared_statement_names_;
+  std::deque<Request_metrics> request_metrics_; // of the last requests_ if instrumented
+
+  /**
+   * @brief Appends the request to the queue of requests.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void push_request__(Request_id id, std::uint64_t query_hash = 0,
+    const std::string& statement_name = {});
+
+  /// Removes the last request from the queue of requests.
+  void pop_request_back__() noexcept;
+
+  /// Removes the first request from the queue of requests.
+  void pop_request_front__() noexcept;
+
+  /// Reports the sending of the last request to the instrument.
+  void trace_send__(std::string_view query) noexcept;
+
+  /// Reports the receiving of the response of the first request to the instrument.
+  void trace_response__(bool is_completion) noexcept;
 
   bool is_invariant_ok() const noexcept;
 
+  /**
+   * @brief Switches the currently processed request either to the single-row
+   * mode or to the chunked rows mode depending on `row_batch_size()`.
+   *
+   * @returns `true` on success.
+   */
+  bool set_rows_mode() noexcept;
+
+  /**
+   * @returns The released instance of type `R` if available.
+   *
+   * @throws `std::runtime_error` if `R` is Row but the chunk of rows is available.
+   */
+  template<class R>
+  R release_rows__()
+  {
+    if constexpr (std::is_same_v<R, Row>) {
+      if (detail::pq::is_rows_portion(response_.status()) &&
+        response_.status() != PGRES_SINGLE_TUPLE)
+        throw std::runtime_error{"cannot release chunk of rows as Row"};
+      return row();
+    } else
+      return row_batch();
+  }
+
   // ---------------------------------------------------------------------------
   // Session data helpers
   // ---------------------------------------------------------------------------
@@ -1310,6 +1648,31 @@ private:
   // Unregisters the prepared statement.
   void unregister_ps(const std::string& name) noexcept;
 
+  // Unregisters all the named prepared statements.
+  void unregister_named_ps() noexcept
+  {
+    named_prepared_statements_index_.clear();
+    named_prepared_statements_.clear();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Statement cache helpers
+  // ---------------------------------------------------------------------------
+
+  /*
+   * Tracks the execution of the `statement`.
+   *
+   * @returns The cached prepared statement to execute, or `nullptr` if the
+   * unnamed statement should be used.
+   */
+  DMITIGR_PGFE_API Prepared_statement* cached_ps__(const Sql_string& statement);
+
+  // Executes the cached prepared statement and unbinds its parameters.
+  DMITIGR_PGFE_API void execute_cached_ps_nio__(Prepared_statement& ps);
+
+  // Evicts the least recently used entries until `(statement_cache_.size() <= size)`.
+  void shrink_statement_cache__(std::size_t size);
+
   // ---------------------------------------------------------------------------
   // Utilities helpers
   // ---------------------------------------------------------------------------
@@ -1408,7 +1771,7 @@ private:
   }
 };
 
-template<Row_processing on_exception = Row_processing::complete, typename F, typename ... Types>
+template<Row_processing on_exception, typename F, typename ... Types>
 std::enable_if_t<detail::Response_callback_traits<F>::is_valid, Completion>
 Prepared_statement::execute(F&& callback, Types&& ... parameters)
 {
@@ -1429,6 +1792,7 @@ inline void swap(Connection& lhs, Connection& rhs) noexcept
 
 #ifdef DMITIGR_PGFE_HEADER_ONLY
 #include "connection.cpp"
+#include "copier.cpp"
 #include "prepared_statement.cpp"
 #endif
 
@@ -3,10 +3,20 @@
 // For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
 
 #include "connection_pool.hpp"
+#include "exceptions.hpp"
+#include "../net/socket.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdio>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
 
 namespace dmitigr::pgfe {
 
@@ -39,19 +49,36 @@ DMITIGR_PGFE_INLINE Connection_pool::Handle::Handle(Connection_pool* const pool,
   assert(connection_index_ < pool_->connections_.size());
 }
 
+DMITIGR_PGFE_INLINE Prepared_statement* Connection_pool::Handle::prepared_statement(const std::string& name)
+{
+  assert(is_valid() && connection_->is_ready_for_request());
+  if (auto* const result = connection_->prepared_statement(name))
+    return result;
+
+  std::unique_lock lk{pool_->mutex_};
+  const auto i = pool_->prepared_statements_.find(name);
+  if (i == pool_->prepared_statements_.cend())
+    return nullptr;
+  const auto statement = i->second;
+  lk.unlock();
+
+  return connection_->prepare(statement, name);
+}
+
 // -----------------------------------------------------------------------------
 // Connection_pool
 // -----------------------------------------------------------------------------
 
 DMITIGR_PGFE_INLINE Connection_pool::Connection_pool(std::size_t count, const Connection_options& options)
-  : release_handler_{[](Connection& conn)
-  {
-    conn.process_responses([](auto&&){});
-    conn.execute("DISCARD ALL");
-  }}
+  : min_size_{count}
+  , release_handler_{&discard_all}
 {
-  for (; count > 0; --count)
-    connections_.emplace_back(std::make_unique<Connection>(options), false);
+  connections_.resize(count);
+  unconnected_indexes_.reserve(count);
+  for (std::size_t i{}; i < count; ++i) {
+    connections_[i].connection = std::make_unique<Connection>(options);
+    unconnected_indexes_.push_back(count - i - 1); // the first is on top
+  }
 }
 
 DMITIGR_PGFE_INLINE void Connection_pool::set_connect_handler(std::function<void(Connection&)> handler) noexcept
@@ -66,6 +93,95 @@ DMITIGR_PGFE_INLINE void Connection_pool::set_release_handler(std::function<void
   release_handler_ = std::move(handler);
 }
 
+DMITIGR_PGFE_INLINE void Connection_pool::discard_all(Connection& conn)
+{
+  conn.process_responses(ignore_row_batch);
+  conn.execute("DISCARD ALL");
+  conn.unregister_named_ps(); // deallocated by DISCARD ALL
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::reset_preserving_statements(Connection& conn)
+{
+  conn.process_responses(ignore_row_batch);
+  if (conn.transaction_status() != Transaction_status::unstarted)
+    conn.execute("ROLLBACK");
+
+  static const Sql_string queries[] = {
+    "CLOSE ALL",
+    "SET SESSION AUTHORIZATION DEFAULT",
+    "RESET ALL",
+    "UNLISTEN *",
+    "SELECT pg_advisory_unlock_all()",
+    "DISCARD TEMP",
+    "DISCARD SEQUENCES"
+  };
+  conn.set_pipeline_enabled();
+  for (const auto& query : queries)
+    conn.execute_nio(query);
+  conn.send_sync();
+  for (std::size_t i{}; i <= std::size(queries); ++i) // including the sync
+    conn.process_responses(ignore_row_batch);
+  conn.set_pipeline_enabled(false);
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::register_prepared_statement(std::string name,
+  Sql_string statement)
+{
+  assert(!name.empty() && !statement.has_missing_parameters());
+  const std::lock_guard lg{mutex_};
+  prepared_statements_.insert_or_assign(std::move(name), std::move(statement));
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::unregister_prepared_statement(const std::string& name) noexcept
+{
+  const std::lock_guard lg{mutex_};
+  if (const auto i = prepared_statements_.find(name); i != prepared_statements_.cend())
+    prepared_statements_.erase(i);
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::set_min_size(const std::size_t value) noexcept
+{
+  const std::lock_guard lg{mutex_};
+  assert(value <= connections_.size());
+  min_size_ = value;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::min_size() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return min_size_;
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::set_max_idle_time(
+  const std::optional<std::chrono::milliseconds> value) noexcept
+{
+  assert(!value || value->count() >= 0);
+  const std::lock_guard lg{mutex_};
+  max_idle_time_ = value;
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::chrono::milliseconds>
+Connection_pool::max_idle_time() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return max_idle_time_;
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::set_max_lifetime(
+  const std::optional<std::chrono::milliseconds> value) noexcept
+{
+  assert(!value || value->count() >= 0);
+  const std::lock_guard lg{mutex_};
+  max_lifetime_ = value;
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::chrono::milliseconds>
+Connection_pool::max_lifetime() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return max_lifetime_;
+}
+
 DMITIGR_PGFE_INLINE void Connection_pool::connect()
 {
   const std::lock_guard lg{mutex_};
@@ -73,29 +189,82 @@ DMITIGR_PGFE_INLINE void Connection_pool::connect()
   if (is_connected_)
     return;
 
-  for (const auto& connection : connections_) {
-    auto& conn = connection.first;
-    conn->connect();
-    if (connect_handler_)
-      connect_handler_(*conn);
+  // Take the closed connections from the top.
+  const auto count = std::min(min_size_ > connected_count__() ?
+    min_size_ - connected_count__() : 0, unconnected_indexes_.size());
+  const auto first = unconnected_indexes_.end() - static_cast<std::ptrdiff_t>(count);
+  std::vector<Connection*> connections;
+  connections.reserve(count);
+  std::for_each(first, unconnected_indexes_.end(), [&](const auto index)
+  {
+    connections.push_back(connections_[index].connection.get());
+  });
+
+  try {
+    if (!connections.empty())
+      connect_nio__(connections, connections.front()->options().connect_timeout());
+    if (connect_handler_) {
+      for (auto* const connection : connections)
+        connect_handler_(*connection);
+    }
+  } catch (...) {
+    for (auto* const connection : connections)
+      connection->disconnect();
+    throw;
+  }
+
+  // Make the first connection the hottest one.
+  const auto now = Clock::now();
+  for (auto i = first; i != unconnected_indexes_.end(); ++i) {
+    auto& slot = connections_[*i];
+    slot.connected_at = slot.released_at = now;
+    free_connection_indexes_.push_front(*i);
   }
+  unconnected_indexes_.erase(first, unconnected_indexes_.end());
 
   is_connected_ = is_valid();
 }
 
 DMITIGR_PGFE_INLINE void Connection_pool::disconnect() noexcept
 {
-  const std::lock_guard lg{mutex_};
+  std::unique_lock lk{mutex_};
 
   if (!is_connected_)
     return;
 
-  for (const auto& connection : connections_) {
-    if (!connection.second)
-      connection.first->disconnect();
+  for (const auto index : free_connection_indexes_) {
+    connections_[index].connection->disconnect();
+    unconnected_indexes_.push_back(index);
   }
+  free_connection_indexes_.clear();
 
   is_connected_ = false;
+
+  /*
+   * The waiters are dequeued right away, so they cannot be mixed up with the
+   * free connections appeared if the pool is connected again before they
+   * wake up.
+   */
+  Waiter* async_waiters{};
+  auto** async_waiters_tail = &async_waiters;
+  for (auto* const waiter : waiters_) {
+    waiter->is_cancelled = true;
+    if (waiter->notify) {
+      *async_waiters_tail = waiter;
+      async_waiters_tail = &waiter->next_async;
+    } else
+      waiter->cv.notify_one();
+  }
+  *async_waiters_tail = nullptr;
+  waiters_.clear();
+
+  // The asynchronous waiters are notified without locking.
+  lk.unlock();
+  while (async_waiters) {
+    auto* const waiter = async_waiters;
+    async_waiters = waiter->next_async; // the waiter can be gone after notify()
+    waiter->notify();
+  }
 }
 
 DMITIGR_PGFE_INLINE bool Connection_pool::is_connected() const noexcept
@@ -104,24 +273,126 @@ DMITIGR_PGFE_INLINE bool Connection_pool::is_connected() const noexcept
   return is_connected_;
 }
 
-DMITIGR_PGFE_INLINE auto Connection_pool::connection() -> Handle
+DMITIGR_PGFE_INLINE auto Connection_pool::connection(
+  const std::optional<std::chrono::milliseconds> timeout) -> Handle
 {
-  const std::lock_guard lg{mutex_};
+  assert(!timeout || timeout->count() >= 0);
+
+  std::unique_lock lk{mutex_};
   if (!is_connected_)
     return {};
-  const auto b = begin(connections_);
-  const auto e = end(connections_);
-  const auto i = std::find_if(b, e, [](const auto& pair) { return !pair.second; });
-  if (i != e) {
-    i->second = true;
-    auto& conn = i->first;
-    conn->connect();
-    if (conn->is_ready_for_request())
-      return {this, std::move(conn), static_cast<std::size_t>(i - b)};
+
+  close_idle__(Clock::now());
+
+  std::size_t index{};
+  if (const auto free_index = pop_free_index__()) {
+    index = *free_index;
+  } else if (timeout && !timeout->count()) {
+    return {};
+  } else {
+    Waiter waiter;
+    waiters_.push_back(&waiter);
+    const auto is_done = [&waiter]
+    {
+      return waiter.connection_index || waiter.is_cancelled;
+    };
+    if (timeout)
+      waiter.cv.wait_for(lk, *timeout, is_done);
     else
-      throw std::runtime_error{"connection isn't ready for request"};
-  } else
+      waiter.cv.wait(lk, is_done);
+
+    if (waiter.is_cancelled) {
+      // The pool is disconnected. (The waiter is dequeued by disconnect().)
+      assert(!waiter.connection_index);
+      return {};
+    } else if (!waiter.connection_index) {
+      // Timeout expired.
+      const auto i = std::find(cbegin(waiters_), cend(waiters_), &waiter);
+      assert(i != cend(waiters_));
+      waiters_.erase(i);
+      return {};
+    } else if (!is_connected_) {
+      // The pool is disconnected after passing the connection to this waiter.
+      connections_[*waiter.connection_index].connection->disconnect();
+      unconnected_indexes_.push_back(*waiter.connection_index);
+      return {};
+    }
+    index = *waiter.connection_index;
+  }
+
+  return acquire__(lk, index);
+}
+
+DMITIGR_PGFE_INLINE bool Connection_pool::enqueue(Async_waiter& waiter)
+{
+  auto& w = waiter.waiter_;
+  const std::lock_guard lg{mutex_};
+  assert(std::find(cbegin(waiters_), cend(waiters_), &w) == cend(waiters_));
+  w.connection_index.reset();
+  w.is_cancelled = !is_connected_;
+  if (w.is_cancelled)
+    return false;
+
+  close_idle__(Clock::now());
+
+  if ((w.connection_index = pop_free_index__()))
+    return false;
+
+  waiters_.push_back(&w);
+  return true;
+}
+
+DMITIGR_PGFE_INLINE auto Connection_pool::connection(Async_waiter& waiter) -> Handle
+{
+  auto& w = waiter.waiter_;
+  std::unique_lock lk{mutex_};
+  assert(std::find(cbegin(waiters_), cend(waiters_), &w) == cend(waiters_));
+  assert(w.connection_index || w.is_cancelled);
+  if (!w.connection_index)
     return {};
+
+  const auto index = *w.connection_index;
+  w.connection_index.reset();
+  if (!is_connected_) {
+    // The pool is disconnected after passing the connection to this waiter.
+    connections_[index].connection->disconnect();
+    unconnected_indexes_.push_back(index);
+    return {};
+  }
+  return acquire__(lk, index);
+}
+
+DMITIGR_PGFE_INLINE auto Connection_pool::acquire__(std::unique_lock<std::mutex>& lk,
+  const std::size_t index) -> Handle
+{
+  // Attention! mutex_ must be locked here!
+  assert(lk.owns_lock());
+
+  auto& slot = connections_[index];
+  assert(!slot.is_busy);
+  slot.is_busy = true;
+  Handle result{this, std::move(slot.connection), index};
+  const auto max_lifetime = max_lifetime_;
+  const auto connect_handler = connect_handler_;
+  lk.unlock();
+
+  /*
+   * (Re)connect if necessary without locking the pool. The fields of the busy
+   * slot are not accessed by the others until the release.
+   */
+  if (max_lifetime && result->is_connected() &&
+    Clock::now() - slot.connected_at >= *max_lifetime)
+    result->disconnect();
+  if (!result->is_connected()) {
+    result->connect();
+    slot.connected_at = Clock::now();
+    if (connect_handler)
+      connect_handler(*result);
+  }
+  if (!result->is_ready_for_request())
+    throw std::runtime_error{"connection isn't ready for request"};
+
+  return result;
 }
 
 DMITIGR_PGFE_INLINE void Connection_pool::release(Handle& handle) noexcept
@@ -129,32 +400,62 @@ DMITIGR_PGFE_INLINE void Connection_pool::release(Handle& handle) noexcept
   if (!handle.is_valid())
     return;
 
-  const std::lock_guard lg{mutex_};
-
   assert(handle.connection_);
   auto& conn = *handle.connection_;
   const auto index = handle.connection_index_;
-  assert(index < connections_.size());
 
-  if (release_handler_) {
-    try {
-      release_handler_(conn); // kinda of DISCARD ALL
-    } catch (const std::exception& e) {
-      std::fprintf(stderr, "connection pool's release handler thrown: %s\n", e.what());
-    } catch (...) {
-      std::fprintf(stderr, "connection pool's release handler thrown unknown\n");
-    }
+  try {
+    std::unique_lock lk{mutex_};
+    const auto handler = release_handler_;
+    lk.unlock();
+    if (handler && conn.is_connected())
+      handler(conn); // kinda of DISCARD ALL
+  } catch (const std::exception& e) {
+    conn.disconnect(); // the state of the session is unknown
+    std::fprintf(stderr, "connection pool's release handler thrown: %s\n", e.what());
+  } catch (...) {
+    conn.disconnect(); // the state of the session is unknown
+    std::fprintf(stderr, "connection pool's release handler thrown unknown\n");
   }
 
-  if (!is_connected_)
+  std::unique_lock lk{mutex_};
+  assert(index < connections_.size());
+
+  const auto now = Clock::now();
+  auto& slot = connections_[index];
+  if (!is_connected_ || (max_lifetime_ && now - slot.connected_at >= *max_lifetime_))
     conn.disconnect();
 
-  connections_[index].first = std::move(handle.connection_);
-  connections_[index].second = false;
+  slot.connection = std::move(handle.connection_);
+  slot.is_busy = false;
+  slot.released_at = now;
+  Waiter* async_waiter{};
+  if (is_connected_ && !waiters_.empty()) {
+    // Pass the connection to the longest waiting caller.
+    auto* const waiter = waiters_.front();
+    waiters_.pop_front();
+    waiter->connection_index = index;
+    if (waiter->notify)
+      async_waiter = waiter;
+    else
+      waiter->cv.notify_one();
+  } else if (slot.connection->is_connected())
+    free_connection_indexes_.push_back(index);
+  else
+    unconnected_indexes_.push_back(index);
+
+  close_idle__(now);
+
   handle.pool_ = {};
   handle.connection_ = {};
   handle.connection_index_ = {};
   assert(!handle.is_valid());
+
+  // The asynchronous waiter is notified without locking.
+  if (async_waiter) {
+    lk.unlock();
+    async_waiter->notify();
+  }
 }
 
 DMITIGR_PGFE_INLINE std::size_t Connection_pool::size() const noexcept
@@ -163,4 +464,143 @@ DMITIGR_PGFE_INLINE std::size_t Connection_pool::size() const noexcept
   return connections_.size();
 }
 
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::connected_count() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return connected_count__();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::free_count() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return is_connected_ ? free_connection_indexes_.size() + unconnected_indexes_.size() : 0;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::busy_count() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return static_cast<std::size_t>(std::count_if(connections_.begin(),
+    connections_.end(), [](const auto& slot){ return slot.is_busy; }));
+}
+
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::waiter_count() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return waiters_.size();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Connection_pool::connected_count__() const noexcept
+{
+  // Attention! mutex_ must be locked here!
+  return connections_.size() - unconnected_indexes_.size();
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::size_t> Connection_pool::pop_free_index__() noexcept
+{
+  // Attention! mutex_ must be locked here!
+  std::optional<std::size_t> result;
+  if (!free_connection_indexes_.empty()) {
+    assert(waiters_.empty());
+    result = free_connection_indexes_.back();
+    free_connection_indexes_.pop_back();
+  } else if (!unconnected_indexes_.empty()) {
+    assert(waiters_.empty());
+    result = unconnected_indexes_.back();
+    unconnected_indexes_.pop_back();
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::close_idle__(const Clock::time_point now) noexcept
+{
+  // Attention! mutex_ must be locked here!
+  if (!max_idle_time_)
+    return;
+
+  // The least recently released connections are at the front.
+  while (!free_connection_indexes_.empty() && connected_count__() > min_size_) {
+    const auto index = free_connection_indexes_.front();
+    auto& slot = connections_[index];
+    if (now - slot.released_at < *max_idle_time_)
+      break;
+    slot.connection->disconnect();
+    free_connection_indexes_.pop_front();
+    unconnected_indexes_.push_back(index);
+  }
+}
+
+DMITIGR_PGFE_INLINE void Connection_pool::connect_nio__(const std::vector<Connection*>& connections,
+  std::optional<std::chrono::milliseconds> timeout)
+{
+#ifdef _WIN32
+  using Pollfd = WSAPOLLFD;
+  const auto poll = [](Pollfd* const fds, const std::size_t size, const int timeout)
+  {
+    const int result = ::WSAPoll(fds, static_cast<ULONG>(size), timeout);
+    return result != SOCKET_ERROR ? result : (errno = ::WSAGetLastError(), -1);
+  };
+#else
+  using Pollfd = ::pollfd;
+  const auto poll = [](Pollfd* const fds, const std::size_t size, const int timeout)
+  {
+    return ::poll(fds, static_cast<::nfds_t>(size), timeout);
+  };
+#endif
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  using std::chrono::steady_clock;
+  using Status = Connection_status;
+
+  for (auto* const connection : connections)
+    connection->connect_nio();
+
+  std::vector<Pollfd> fds;
+  std::vector<Connection*> pending;
+  fds.reserve(connections.size());
+  pending.reserve(connections.size());
+  while (true) {
+    fds.clear();
+    pending.clear();
+    for (auto* const connection : connections) {
+      Pollfd fd{};
+      switch (connection->status()) {
+      case Status::connected:
+        continue;
+      case Status::establishment_reading:
+        fd.events = POLLIN;
+        break;
+      case Status::establishment_writing:
+        fd.events = POLLOUT;
+        break;
+      case Status::disconnected:
+      case Status::failure:
+        throw std::runtime_error{connection->error_message()};
+      }
+      fd.fd = connection->socket();
+      fds.push_back(fd);
+      pending.push_back(connection);
+    }
+    if (pending.empty())
+      return;
+
+    const auto timepoint1 = steady_clock::now();
+    const int r = poll(fds.data(), fds.size(), timeout ? static_cast<int>(timeout->count()) : -1);
+    if (r < 0 && errno != EINTR)
+      throw std::system_error{errno, std::system_category()};
+
+    if (timeout) {
+      *timeout -= duration_cast<milliseconds>(steady_clock::now() - timepoint1);
+      if (!r || *timeout <= milliseconds::zero())
+        throw Client_exception{Client_errc::timed_out, "connection timeout"};
+    }
+
+    if (r > 0) {
+      for (std::size_t i{}; i < fds.size(); ++i) {
+        if (fds[i].revents)
+          pending[i]->connect_nio();
+      }
+    }
+  }
+}
+
 } // namespace dmitigr::pgfe
@@ -9,9 +9,15 @@
 #include "dll.hpp"
 
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace dmitigr::pgfe {
@@ -106,8 +112,25 @@ public:
         pool_->release(*this);
     }
 
+    /**
+     * @returns The prepared statement of the specified `name`. If the statement
+     * is not prepared on the connection yet, it's prepared by using the
+     * statement registered in the pool, or `nullptr` is returned if there is
+     * no such a registered statement.
+     *
+     * @par Requires
+     * `(is_valid() && (*this)->is_ready_for_request())`.
+     *
+     * @par Exception safety guarantee
+     * Basic.
+     *
+     * @see Connection_pool::register_prepared_statement().
+     */
+    DMITIGR_PGFE_API Prepared_statement* prepared_statement(const std::string& name);
+
   private:
     friend Connection_pool;
+    friend Routing_pool;
 
     /// Default-constructible. (Constructs invalid instance.)
     Handle();
@@ -121,14 +144,19 @@ public:
     std::size_t connection_index_{};
   };
 
+  class Async_waiter;
+
   /// Default-constructible. (Constructs invalid instance.)
   Connection_pool() = default;
 
   /**
    * @brief The constructor.
    *
-   * @param count A number of connections in the pool.
+   * @param count A maximum number of connections in the pool.
    * @param options A connection options to be used for connections of pool.
+   *
+   * @par Effects
+   * `(min_size() == size())`.
    */
   explicit DMITIGR_PGFE_API Connection_pool(std::size_t count, const Connection_options& options = {});
 
@@ -168,9 +196,10 @@ public:
    * @brief Sets the handler which will be called just after returning a connection
    * to the pool.
    *
-   * By default, it executes the `DISCARD ALL` statement.
+   * By default, it's discard_all(). If the handler throws, the connection
+   * is closed.
    *
-   * @see release_handler().
+   * @see release_handler(), reset_preserving_statements().
    */
   DMITIGR_PGFE_API void set_release_handler(std::function<void(Connection&)> handler) noexcept;
 
@@ -181,16 +210,126 @@ public:
   }
 
   /**
-   * @brief Opens the connections to the server.
+   * @brief The release handler which executes `DISCARD ALL`.
+   *
+   * @details All the prepared statements of the `conn` are deallocated.
+   */
+  static DMITIGR_PGFE_API void discard_all(Connection& conn);
+
+  /**
+   * @brief The release handler which resets the session state as `DISCARD ALL`
+   * but preserves the prepared statements.
+   *
+   * @details The uncommitted transaction is rolled back. Then `CLOSE ALL`,
+   * `SET SESSION AUTHORIZATION DEFAULT`, `RESET ALL`, `UNLISTEN *`,
+   * `SELECT pg_advisory_unlock_all()`, `DISCARD TEMP` and `DISCARD SEQUENCES`
+   * are executed in the pipeline, i.e. in one round trip.
+   *
+   * @see set_release_handler(), register_prepared_statement().
+   */
+  static DMITIGR_PGFE_API void reset_preserving_statements(Connection& conn);
+
+  /**
+   * @brief Registers the statement to be prepared on demand on each connection
+   * of the pool by Handle::prepared_statement().
+   *
+   * @par Requires
+   * `(!name.empty() && !statement.has_missing_parameters())`.
+   *
+   * @remarks The prepared statements are preserved across the handles only
+   * if the release handler doesn't deallocate them (see
+   * reset_preserving_statements()).
+   *
+   * @see unregister_prepared_statement().
+   */
+  DMITIGR_PGFE_API void register_prepared_statement(std::string name, Sql_string statement);
+
+  /**
+   * @brief Unregisters the statement.
+   *
+   * @remarks The statements already prepared on the connections of the pool
+   * are not affected.
+   *
+   * @see register_prepared_statement().
+   */
+  DMITIGR_PGFE_API void unregister_prepared_statement(const std::string& name) noexcept;
+
+  /**
+   * @brief Sets the minimum number of connections to be open.
+   *
+   * This number of connections is opened by connect(). The rest connections
+   * are opened on demand by connection(). The connections which are idle
+   * longer than max_idle_time() are closed as long as more than `value`
+   * connections are open.
+   *
+   * @par Requires
+   * `(value <= size())`.
+   *
+   * @see min_size(), set_max_idle_time().
+   */
+  DMITIGR_PGFE_API void set_min_size(std::size_t value) noexcept;
+
+  /// @returns The minimum number of connections to be open.
+  DMITIGR_PGFE_API std::size_t min_size() const noexcept;
+
+  /**
+   * @brief Sets the maximum amount of time the connection can be idle in the
+   * pool before it will be closed.
+   *
+   * @param value The value of `std::nullopt` means *eternity*.
+   *
+   * @par Requires
+   * `(!value || value->count() >= 0)`.
+   *
+   * @see max_idle_time(), set_min_size().
+   */
+  DMITIGR_PGFE_API void set_max_idle_time(std::optional<std::chrono::milliseconds> value) noexcept;
+
+  /// @returns The maximum amount of time the connection can be idle.
+  DMITIGR_PGFE_API std::optional<std::chrono::milliseconds> max_idle_time() const noexcept;
+
+  /**
+   * @brief Sets the maximum lifetime of the connection.
+   *
+   * The connection which is open longer than the `value` is closed upon its
+   * release and reopened upon its acquisition.
+   *
+   * @param value The value of `std::nullopt` means *eternity*.
+   *
+   * @par Requires
+   * `(!value || value->count() >= 0)`.
+   *
+   * @see max_lifetime().
+   */
+  DMITIGR_PGFE_API void set_max_lifetime(std::optional<std::chrono::milliseconds> value) noexcept;
+
+  /// @returns The maximum lifetime of the connection.
+  DMITIGR_PGFE_API std::optional<std::chrono::milliseconds> max_lifetime() const noexcept;
+
+  /**
+   * @brief Opens `min_size()` connections to the server simultaneously.
+   *
+   * The connections are established by using Connection::connect_nio() with
+   * multiplexing of their sockets, so the total time of this operation is
+   * about the time of opening the single connection.
    *
    * @par Effects
    * `(is_connected() == is_valid())` on success.
+   *
+   * @throws An instance of type Client_exception with the code
+   * `Client_errc::timed_out` if the connections are not established within
+   * the connect timeout of the connection options.
    */
   DMITIGR_PGFE_API void connect();
 
   /**
    * Closes the connections to the server.
    *
+   * @par Effects
+   * The callers of connection() which are waiting for a free connection get
+   * the invalid handles (even if the pool is connected again before they
+   * wake up).
+   *
    * @remarks Connections which are busy will not be affected by calling this method.
    */
   DMITIGR_PGFE_API void disconnect() noexcept;
@@ -200,13 +339,57 @@ public:
 
   /**
    * @returns The connection handle `h`. If `!is_connected()` or there is no free
-   * connections in the pool at the time of call then `(h.is_valid() == false)`.
+   * connection in the pool within the specified `timeout` then
+   * `(h.is_valid() == false)`.
+   *
+   * @param timeout A maximum amount of time to wait for a free connection. The
+   * value of `std::nullopt` means *eternity*. The zero value means no waiting.
+   *
+   * @par Requires
+   * `(!timeout || timeout->count() >= 0)`.
+   *
+   * @remarks The callers which are waiting for a free connection are served in
+   * the order of arrival: the connection released while there are waiters is
+   * passed to the longest waiting one.
+   *
+   * @see release().
+   */
+  DMITIGR_PGFE_API Handle connection(std::optional<std::chrono::milliseconds> timeout =
+    std::chrono::milliseconds{});
+
+  /**
+   * @brief Starts the waiting of the `waiter` for a free connection without
+   * blocking the calling thread.
+   *
+   * If there is no free connection, the `waiter` is enqueued along with the
+   * callers of connection() and is notified when the connection is released
+   * or when the pool is disconnected.
+   *
+   * @returns `true` if the `waiter` is enqueued, or `false` if the waiting is
+   * done right away. In either case, the connection is taken by
+   * connection(Async_waiter&) when the waiting is done.
+   *
+   * @par Requires
+   * The `waiter` is not enqueued.
+   *
+   * @par Exception safety guarantee
+   * Strong.
    */
-  DMITIGR_PGFE_API Handle connection();
+  DMITIGR_PGFE_API bool enqueue(Async_waiter& waiter);
+
+  /**
+   * @returns The connection handle `h` the waiting of the `waiter` is resulted
+   * to. If the pool is disconnected meanwhile then `(h.is_valid() == false)`.
+   *
+   * @par Requires
+   * The waiting of the `waiter` started by enqueue() is done.
+   */
+  DMITIGR_PGFE_API Handle connection(Async_waiter& waiter);
 
   /**
    * Returns the connection of `handle` back to the pool if `is_connected()`,
-   * or closes it otherwise.
+   * or closes it otherwise. The release handler is called without locking
+   * the pool.
    *
    * @par Effects
    *   -# `(!handle.pool() && !handle.connection())`;
@@ -216,17 +399,106 @@ public:
    */
   DMITIGR_PGFE_API void release(Handle& handle) noexcept;
 
-  /// @returns The size of the pool.
+  /// @returns The size (maximum number of connections) of the pool.
   DMITIGR_PGFE_API std::size_t size() const noexcept;
 
+  /// @returns The number of open connections (including the busy ones).
+  DMITIGR_PGFE_API std::size_t connected_count() const noexcept;
+
+  /// @returns The number of free connections in the pool.
+  DMITIGR_PGFE_API std::size_t free_count() const noexcept;
+
+  /// @returns The number of connections acquired by connection() and not released yet.
+  DMITIGR_PGFE_API std::size_t busy_count() const noexcept;
+
+  /// @returns The number of callers which are waiting for a free connection.
+  DMITIGR_PGFE_API std::size_t waiter_count() const noexcept;
+
 private:
   friend Handle;
 
+  using Clock = std::chrono::steady_clock;
+
+  /// A slot of the connection.
+  struct Slot final {
+    std::unique_ptr<Connection> connection;
+    bool is_busy{};
+    Clock::time_point connected_at;
+    Clock::time_point released_at;
+  };
+
+  /// A caller of connection() waiting for a free connection.
+  struct Waiter final {
+    std::condition_variable cv;
+    std::function<void()> notify; // of the asynchronous waiter (instead of cv)
+    Waiter* next_async{}; // in the list of the cancelled asynchronous waiters
+    std::optional<std::size_t> connection_index;
+    bool is_cancelled{}; // by disconnect()
+  };
+
   mutable std::mutex mutex_;
   bool is_connected_{};
-  std::vector<std::pair<std::unique_ptr<Connection>, bool>> connections_;
+  std::size_t min_size_{};
+  std::optional<std::chrono::milliseconds> max_idle_time_;
+  std::optional<std::chrono::milliseconds> max_lifetime_;
+  std::vector<Slot> connections_;
+  std::deque<std::size_t> free_connection_indexes_; // open; the last is the hottest
+  std::vector<std::size_t> unconnected_indexes_; // free and closed
+  std::deque<Waiter*> waiters_;
   std::function<void(Connection&)> connect_handler_;
   std::function<void(Connection&)> release_handler_;
+  std::map<std::string, Sql_string, std::less<>> prepared_statements_;
+
+  std::size_t connected_count__() const noexcept;
+  void close_idle__(Clock::time_point now) noexcept;
+  std::optional<std::size_t> pop_free_index__() noexcept;
+  Handle acquire__(std::unique_lock<std::mutex>& lk, std::size_t index);
+
+  /**
+   * Establishes the `connections` simultaneously by multiplexing their sockets.
+   *
+   * @par Requires
+   * `!connection->is_connected()` for each of `connections`.
+   */
+  static void connect_nio__(const std::vector<Connection*>& connections,
+    std::optional<std::chrono::milliseconds> timeout);
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A waiter for a free connection of Connection_pool which doesn't block
+ * the thread.
+ *
+ * @warning The behavior is undefined if the enqueued instance is destroyed
+ * before the notification.
+ *
+ * @see Connection_pool::enqueue().
+ */
+class Connection_pool::Async_waiter final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param notify The function to be called when the waiting is done. It's
+   * called from the thread which calls Connection_pool::release() or
+   * Connection_pool::disconnect() without locking the pool, and must not throw.
+   */
+  explicit Async_waiter(std::function<void()> notify)
+  {
+    waiter_.notify = std::move(notify);
+  }
+
+  /// Non copy-constructible.
+  Async_waiter(const Async_waiter&) = delete;
+
+  /// Non copy-assignable.
+  Async_waiter& operator=(const Async_waiter&) = delete;
+
+private:
+  friend Connection_pool;
+
+  Waiter waiter_;
 };
 
 } // namespace dmitigr::pgfe
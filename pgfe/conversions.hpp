@@ -14,13 +14,23 @@
 #include "types_fwd.hpp"
 #include "../net/conversions.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace dmitigr::pgfe::detail {
 
@@ -85,140 +95,107 @@ struct Generic_data_conversions final {
 // Optimized numeric to/from std::string conversions
 // -----------------------------------------------------------------------------
 
-/// The common implementation of numeric to/from `std::string` conversions.
+/**
+ * @brief The implementation of numeric to/from `std::string` conversions.
+ *
+ * @details The conversions are locale-independent and performed without
+ * memory allocations (except the allocation of the resulting `std::string`)
+ * by using `std::from_chars()` and `std::to_chars()`. (The conversions of the
+ * floating point numbers are performed by using the standard streams if these
+ * functions are not supported for the floating point types.)
+ */
 template<typename T>
-struct Numeric_string_conversions_base {
+struct Numeric_string_conversions final {
+  static_assert(std::is_arithmetic_v<T>);
   using Type = T;
 
-  template<typename ... Types>
-  static std::string to_string(Type value, Types&& ... args)
-  {
-    if constexpr (std::is_floating_point_v<Type>)
-      return Generic_string_conversions<Type>::to_string(value, std::forward<Types>(args)...);
-    else
-      return std::to_string(value);
-  }
-
-protected:
-  template<typename R, typename ... Types>
-  static Type to_numeric__(const std::string& text, R(*converter)(const std::string&, std::size_t*, Types ...))
-  {
-    Type result;
-    std::size_t idx;
-    if constexpr (std::is_floating_point_v<R>) // workaround for GCC 7.5
-      result = converter(text, &idx);
-    else
-      result = converter(text, &idx, 10);
-
-    if (idx != text.size())
-      throw std::runtime_error{"the input string contains symbols not convertible to numeric"};
-
-    return result;
-  }
-};
-
-// -----------------------------------------------------------------------------
-
-/// The implementation of `short int` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<short int> final
-  : private Numeric_string_conversions_base<int> {
-  using Type = short int;
-  using Numeric_string_conversions_base::to_string;
-
-  template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
-  {
-    const int result = to_numeric__(text, &std::stoi);
-    constexpr auto max = std::numeric_limits<short int>::max();
-    if (result > max)
-      throw std::runtime_error("numeric value " + text + " > " + std::to_string(max));
-
-    return static_cast<Type>(result);
-  }
-};
-
-/// The implementation of `int` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<int> final
-  : private Numeric_string_conversions_base<int> {
-  using Type = int;
-  using Numeric_string_conversions_base::to_string;
-
-  template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
-  {
-    return to_numeric__(text, &std::stoi);
-  }
-};
-
-/// The implementation of `long int` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<long int> final
-  : private Numeric_string_conversions_base<long int> {
-  using Type = long int;
-  using Numeric_string_conversions_base::to_string;
+  /// The maximum size of the text representation of the `Type`.
+  static constexpr std::size_t max_size{std::is_integral_v<Type> ?
+    std::numeric_limits<Type>::digits10 + 3 : 64};
 
   template<typename ... Types>
   static Type to_type(const std::string& text, Types&& ...)
   {
-    return to_numeric__(text, &std::stol);
+    return to_type(text.data(), text.size());
   }
-};
-
-/// The implementation of `long long int` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<long long int> final
-  : private Numeric_string_conversions_base<long long int> {
-  using Type = long long int;
-  using Numeric_string_conversions_base::to_string;
 
-  template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
+  /**
+   * @returns The value of type `Type` converted from the text of the specified
+   * size. (The text doesn't need to be null-terminated.)
+   */
+  static Type to_type(const char* text, std::size_t size)
   {
-    return to_numeric__(text, &std::stoll);
+    assert(text);
+    if (size > 1 && *text == '+') {
+      ++text;
+      --size;
+    }
+
+    const auto* const end = text + size;
+#ifndef __cpp_lib_to_chars
+    if constexpr (std::is_floating_point_v<Type>) {
+      const std::string str{text, size};
+      std::size_t idx{};
+      Type result;
+      if constexpr (std::is_same_v<Type, float>)
+        result = std::stof(str, &idx);
+      else if constexpr (std::is_same_v<Type, double>)
+        result = std::stod(str, &idx);
+      else
+        result = std::stold(str, &idx);
+      if (idx != size)
+        throw std::runtime_error{"the input string contains symbols not convertible to numeric"};
+      return result;
+    } else {
+#endif
+      Type result{};
+      const auto [ptr, ec] = std::from_chars(text, end, result);
+      if (ec == std::errc::result_out_of_range)
+        throw std::runtime_error{"numeric value " + std::string{text, size} + " is out of range"};
+      else if (ec != std::errc{} || ptr != end)
+        throw std::runtime_error{"the input string contains symbols not convertible to numeric"};
+      return result;
+#ifndef __cpp_lib_to_chars
+    }
+#endif
   }
-};
-
-/// The implementation of `float` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<float> final
-  : private Numeric_string_conversions_base<float> {
-  using Type = float;
-  using Numeric_string_conversions_base::to_string;
 
   template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
+  static std::string to_string(const Type value, Types&& ...)
   {
-    return to_numeric__(text, &std::stof);
+    char buf[max_size];
+    return std::string(buf, to_chars(buf, buf + sizeof(buf), value));
   }
-};
 
-/// The implementation of `double` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<double> final
-  : private Numeric_string_conversions_base<double> {
-  using Type = double;
-  using Numeric_string_conversions_base::to_string;
-
-  template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
+  /**
+   * @brief Writes the text representation of the `value` into the character
+   * range `[first, last)`.
+   *
+   * @returns The pointer past the last character written.
+   *
+   * @par Requires
+   * `(first && first <= last)`.
+   *
+   * @remarks The range of size `max_size` is always enough.
+   */
+  static char* to_chars(char* const first, char* const last, const Type value)
   {
-    return to_numeric__(text, &std::stod);
-  }
-};
-
-/// The implementation of `long double` to/from `std::string` conversions.
-template<>
-struct Numeric_string_conversions<long double> final
-  : private Numeric_string_conversions_base<long double> {
-  using Type = long double;
-  using Numeric_string_conversions_base::to_string;
-
-  template<typename ... Types>
-  static Type to_type(const std::string& text, Types&& ...)
-  {
-    return to_numeric__(text, &std::stold);
+    assert(first && first <= last);
+#ifndef __cpp_lib_to_chars
+    if constexpr (std::is_floating_point_v<Type>) {
+      const auto str = Generic_string_conversions<Type>::to_string(value);
+      if (str.size() > static_cast<std::size_t>(last - first))
+        throw std::runtime_error{"not enough space for numeric representation"};
+      return std::copy(str.cbegin(), str.cend(), first);
+    } else {
+#endif
+      const auto [ptr, ec] = std::to_chars(first, last, value);
+      if (ec != std::errc{})
+        throw std::runtime_error{"not enough space for numeric representation"};
+      return ptr;
+#ifndef __cpp_lib_to_chars
+    }
+#endif
   }
 };
 
@@ -236,7 +213,9 @@ struct Numeric_data_conversions final {
   {
     assert(data);
     if (data->format() == Data_format::binary)
-      return net::conv<Type>(data->bytes(), data->size());
+      return from_binary__(data->bytes(), data->size());
+    else if constexpr (std::is_same_v<StringConversions, Numeric_string_conversions<Type>>)
+      return StringConversions::to_type(static_cast<const char*>(data->bytes()), data->size());
     else
       return Generic_data_conversions<Type, StringConversions>::to_type(data, std::forward<Types>(args)...);
   }
@@ -252,6 +231,82 @@ struct Numeric_data_conversions final {
   {
     return Generic_data_conversions<Type, StringConversions>::to_data(value, std::forward<Types>(args)...);
   }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type value, const Data_format format, Types&& ... args)
+  {
+    if (format == Data_format::binary) {
+      std::string result;
+      append_binary(result, value);
+      return Data::make(std::move(result), Data_format::binary);
+    } else
+      return to_data(value, std::forward<Types>(args)...);
+  }
+
+  /// Appends the binary representation of the `value` to the `result`.
+  static void append_binary(std::string& result, const Type value)
+  {
+    if constexpr (std::is_integral_v<Type>) {
+      if constexpr (sizeof(Type) <= sizeof(std::int16_t))
+        append_binary__(result, static_cast<std::int16_t>(value));
+      else if constexpr (sizeof(Type) <= sizeof(std::int32_t))
+        append_binary__(result, static_cast<std::int32_t>(value));
+      else
+        append_binary__(result, static_cast<std::int64_t>(value));
+    } else {
+      if constexpr (sizeof(Type) <= sizeof(float))
+        append_binary__(result, static_cast<float>(value));
+      else
+        append_binary__(result, static_cast<double>(value));
+    }
+  }
+
+private:
+  /*
+   * The integers are decoded from int2, int4 or int8, and the floating point
+   * numbers are decoded from float4 or float8 depending on the size of the
+   * data. The data wider than the representation of Type is rejected, since
+   * it's of the other type (for example, int8, float8 or timestamp for int).
+   * (The types of the same size, such as int4, float4 and date, cannot be
+   * distinguished by the size though.)
+   */
+  static Type from_binary__(const void* const bytes, const std::size_t size)
+  {
+    if constexpr (std::is_integral_v<Type>) {
+      static_assert(std::is_signed_v<Type> && sizeof(Type) >= sizeof(std::int16_t));
+      switch (size) {
+      case sizeof(std::int16_t):
+        return static_cast<Type>(net::conv<std::int16_t>(bytes, size));
+      case sizeof(std::int32_t):
+        if constexpr (sizeof(Type) >= sizeof(std::int32_t))
+          return static_cast<Type>(net::conv<std::int32_t>(bytes, size));
+        break;
+      case sizeof(std::int64_t):
+        if constexpr (sizeof(Type) >= sizeof(std::int64_t))
+          return static_cast<Type>(net::conv<std::int64_t>(bytes, size));
+        break;
+      }
+    } else {
+      switch (size) {
+      case sizeof(float):
+        return static_cast<Type>(net::conv<float>(bytes, size));
+      case sizeof(double):
+        if constexpr (sizeof(Type) >= sizeof(double))
+          return static_cast<Type>(net::conv<double>(bytes, size));
+        break;
+      }
+    }
+    throw std::runtime_error{"binary numeric representation of size "
+      + std::to_string(size) + " is not convertible to the requested type"};
+  }
+
+  template<typename U>
+  static void append_binary__(std::string& result, const U value)
+  {
+    const auto offset = result.size();
+    result.resize(offset + sizeof(U));
+    net::copy(result.data() + offset, sizeof(U), value);
+  }
 };
 
 // -----------------------------------------------------------------------------
@@ -393,6 +448,20 @@ struct Bool_data_conversions final {
   {
     return Data::make(Bool_string_conversions::to_string(value), Data_format::text);
   }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type value, const Data_format format, Types&& ...)
+  {
+    return format == Data_format::binary ?
+      Data::make(std::string(1, static_cast<char>(value ? 1 : 0)), Data_format::binary) :
+      to_data(value);
+  }
+
+  /// Appends the binary representation of the `value` to the `result`.
+  static void append_binary(std::string& result, const Type value)
+  {
+    result += static_cast<char>(value ? 1 : 0);
+  }
 };
 
 // -----------------------------------------------------------------------------
@@ -423,6 +492,489 @@ struct String_view_data_conversions final {
   }
 };
 
+// -----------------------------------------------------------------------------
+// Hex helpers
+// -----------------------------------------------------------------------------
+
+/// @returns The value of the hex digit `c`, or `-1` if `c` is not a hex digit.
+inline int hex_digit_value(const char c) noexcept
+{
+  if ('0' <= c && c <= '9')
+    return c - '0';
+  else if ('a' <= c && c <= 'f')
+    return c - 'a' + 10;
+  else if ('A' <= c && c <= 'F')
+    return c - 'A' + 10;
+  else
+    return -1;
+}
+
+/// Appends the hex representation of the `size` bytes to the `result`.
+inline void append_hex(std::string& result, const std::byte* const bytes, const std::size_t size)
+{
+  constexpr const char* digits{"0123456789abcdef"};
+  for (std::size_t i = 0; i < size; ++i) {
+    const auto b = std::to_integer<unsigned>(bytes[i]);
+    result += digits[b >> 4];
+    result += digits[b & 0xf];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// std::chrono::system_clock::time_point conversions
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief The implementation of `std::chrono::system_clock::time_point`
+ * to/from `std::string` conversions.
+ *
+ * @details The text representation is compliant to the ISO 8601 style used
+ * by PostgreSQL (DateStyle ISO), e.g. `2000-01-02 03:04:05.123456+03`. The
+ * time zone offset and the time parts are optional for input. The output is
+ * always in UTC.
+ */
+struct Time_point_string_conversions final {
+  using Type = std::chrono::system_clock::time_point;
+
+  template<typename ... Types>
+  static Type to_type(const std::string& text, Types&& ...)
+  {
+    return to_type__(text);
+  }
+
+  template<typename ... Types>
+  static std::string to_string(const Type value, Types&& ...)
+  {
+    namespace chrono = std::chrono;
+    constexpr std::int64_t us_per_second{1000000};
+    constexpr std::int64_t us_per_day{us_per_second * 86400};
+    const std::int64_t us = chrono::floor<chrono::microseconds>(value.time_since_epoch()).count();
+    std::int64_t days = us / us_per_day;
+    std::int64_t us_of_day = us % us_per_day;
+    if (us_of_day < 0) {
+      us_of_day += us_per_day;
+      --days;
+    }
+
+    std::int64_t y{};
+    unsigned m{}, d{};
+    civil_from_days(days, y, m, d);
+    if (y < 1 || y > 9999)
+      throw std::runtime_error{"timestamp is out of range"};
+
+    const auto s = us_of_day / us_per_second;
+    const auto frac = us_of_day % us_per_second;
+    char buf[40];
+    int size = std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u %02d:%02d:%02d",
+      static_cast<int>(y), m, d,
+      static_cast<int>(s / 3600), static_cast<int>(s % 3600 / 60), static_cast<int>(s % 60));
+    if (frac)
+      size += std::snprintf(buf + size, sizeof(buf) - size, ".%06d", static_cast<int>(frac));
+    assert(0 < size && static_cast<std::size_t>(size) < sizeof(buf));
+    return std::string{buf, static_cast<std::size_t>(size)}.append("+00");
+  }
+
+private:
+  friend struct Time_point_data_conversions;
+
+  /// @returns The number of days since 1970-01-01 of the specified civil date.
+  static std::int64_t days_from_civil(std::int64_t y, const unsigned m, const unsigned d) noexcept
+  {
+    // See http://howardhinnant.github.io/date_algorithms.html
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const auto yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+  }
+
+  /// Converts the number of days since 1970-01-01 to the civil date.
+  static void civil_from_days(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) noexcept
+  {
+    // See http://howardhinnant.github.io/date_algorithms.html
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+  }
+
+  static Type to_type__(const std::string_view text)
+  {
+    const auto invalid = []
+    {
+      return std::runtime_error{"invalid text timestamp representation"};
+    };
+
+    const auto size = text.size();
+    std::size_t i{};
+    const auto is_next = [&](const char c) noexcept
+    {
+      return i < size && text[i] == c;
+    };
+    const auto skip = [&](const char c)
+    {
+      if (!is_next(c))
+        throw invalid();
+      ++i;
+    };
+    const auto number = [&](const std::size_t min_length, const std::size_t max_length)
+    {
+      int result{};
+      const std::size_t b = i;
+      for (; i < size && i - b < max_length && '0' <= text[i] && text[i] <= '9'; ++i)
+        result = result * 10 + (text[i] - '0');
+      if (i - b < min_length)
+        throw invalid();
+      return result;
+    };
+
+    // Date.
+    const int y = number(4, 6);
+    skip('-');
+    const int m = number(2, 2);
+    skip('-');
+    const int d = number(2, 2);
+    if (m < 1 || m > 12 || d < 1 || d > 31)
+      throw invalid();
+
+    // Time.
+    int hh{}, mm{}, ss{}, us{};
+    if (is_next(' ') || is_next('T')) {
+      ++i;
+      hh = number(2, 2);
+      skip(':');
+      mm = number(2, 2);
+      if (is_next(':')) {
+        ++i;
+        ss = number(2, 2);
+        if (is_next('.')) {
+          ++i;
+          const std::size_t b = i;
+          us = number(1, 6);
+          for (auto n = i - b; n < 6; ++n)
+            us *= 10;
+          while (i < size && '0' <= text[i] && text[i] <= '9')
+            ++i; // ignore the digits beyond the microseconds
+        }
+      }
+      if (hh > 24 || mm > 59 || ss > 60)
+        throw invalid();
+    }
+
+    // Time zone offset.
+    int offset{};
+    if (is_next('Z'))
+      ++i;
+    else if (is_next('+') || is_next('-')) {
+      const int sign = text[i++] == '-' ? -1 : 1;
+      offset = number(2, 2) * 3600;
+      if (is_next(':')) {
+        ++i;
+        offset += number(2, 2) * 60;
+        if (is_next(':')) {
+          ++i;
+          offset += number(2, 2);
+        }
+      }
+      offset *= sign;
+    }
+
+    if (i != size)
+      throw invalid();
+
+    namespace chrono = std::chrono;
+    const std::int64_t seconds = days_from_civil(y, static_cast<unsigned>(m), static_cast<unsigned>(d)) * 86400 +
+      hh * 3600 + mm * 60 + ss - offset;
+    return Type{chrono::duration_cast<Type::duration>(chrono::seconds{seconds} + chrono::microseconds{us})};
+  }
+};
+
+/**
+ * @brief The implementation of `std::chrono::system_clock::time_point`
+ * to/from Data conversions.
+ *
+ * @details The binary representation is either timestamp(tz) (8 bytes) or date
+ * (4 bytes) for input, and timestamptz for output.
+ */
+struct Time_point_data_conversions final {
+  using Type = std::chrono::system_clock::time_point;
+
+  template<typename ... Types>
+  static Type to_type(const Data* const data, Types&& ...)
+  {
+    assert(data);
+    namespace chrono = std::chrono;
+    if (data->format() == Data_format::binary) {
+      switch (data->size()) {
+      case sizeof(std::int64_t): {
+        const chrono::microseconds us{net::conv<std::int64_t>(data->bytes(), data->size())};
+        return postgres_epoch() + chrono::duration_cast<Type::duration>(us);
+      }
+      case sizeof(std::int32_t): {
+        const chrono::seconds s{std::int64_t{net::conv<std::int32_t>(data->bytes(), data->size())} * 86400};
+        return postgres_epoch() + chrono::duration_cast<Type::duration>(s);
+      }
+      default:
+        throw std::runtime_error{"invalid binary timestamp representation"};
+      }
+    } else
+      return Time_point_string_conversions::to_type__({static_cast<const char*>(data->bytes()), data->size()});
+  }
+
+  template<typename ... Types>
+  static Type to_type(std::unique_ptr<Data>&& data, Types&& ...)
+  {
+    return to_type(data.get());
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type value, Types&& ...)
+  {
+    return Data::make(Time_point_string_conversions::to_string(value), Data_format::text);
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type value, const Data_format format, Types&& ...)
+  {
+    if (format == Data_format::binary) {
+      std::string result;
+      append_binary(result, value);
+      return Data::make(std::move(result), Data_format::binary);
+    } else
+      return to_data(value);
+  }
+
+  /// Appends the binary representation (timestamptz) of the `value` to the `result`.
+  static void append_binary(std::string& result, const Type value)
+  {
+    namespace chrono = std::chrono;
+    const std::int64_t us = chrono::floor<chrono::microseconds>(value - postgres_epoch()).count();
+    const auto offset = result.size();
+    result.resize(offset + sizeof(us));
+    net::copy(result.data() + offset, sizeof(us), us);
+  }
+
+private:
+  /// @returns 2000-01-01 00:00:00 UTC.
+  static Type postgres_epoch() noexcept
+  {
+    return Type{std::chrono::seconds{946684800}};
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Bytea conversions
+// -----------------------------------------------------------------------------
+
+/// The implementation of `std::vector<std::byte>` to/from `std::string` conversions.
+struct Bytea_string_conversions final {
+  using Type = std::vector<std::byte>;
+
+  template<typename ... Types>
+  static Type to_type(const std::string& text, Types&& ...)
+  {
+    return to_type__(text);
+  }
+
+  template<typename ... Types>
+  static std::string to_string(const Type& value, Types&& ...)
+  {
+    std::string result;
+    result.reserve(2 + value.size() * 2);
+    result.append("\\x");
+    append_hex(result, value.data(), value.size());
+    return result;
+  }
+
+private:
+  friend struct Bytea_data_conversions;
+
+  static Type to_type__(const std::string_view text)
+  {
+    if (text.size() >= 2 && text[0] == '\\' && text[1] == 'x') {
+      if (text.size() % 2)
+        throw std::runtime_error{"invalid text bytea representation"};
+
+      Type result(text.size() / 2 - 1);
+      for (std::size_t i = 2, j = 0; i < text.size(); i += 2, ++j) {
+        const int hi = hex_digit_value(text[i]);
+        const int lo = hex_digit_value(text[i + 1]);
+        if (hi < 0 || lo < 0)
+          throw std::runtime_error{"invalid text bytea representation"};
+        result[j] = static_cast<std::byte>(hi << 4 | lo);
+      }
+      return result;
+    } else {
+      // Escape format (must be null-terminated for libpq).
+      const auto data = Data::to_bytea(std::string{text});
+      const auto* const bytes = static_cast<const std::byte*>(data->bytes());
+      return Type(bytes, bytes + data->size());
+    }
+  }
+};
+
+/// The implementation of `std::vector<std::byte>` to/from Data conversions.
+struct Bytea_data_conversions final {
+  using Type = std::vector<std::byte>;
+
+  template<typename ... Types>
+  static Type to_type(const Data* const data, Types&& ...)
+  {
+    assert(data);
+    if (data->format() == Data_format::binary) {
+      const auto* const bytes = static_cast<const std::byte*>(data->bytes());
+      return Type(bytes, bytes + data->size());
+    } else
+      return Bytea_string_conversions::to_type__({static_cast<const char*>(data->bytes()), data->size()});
+  }
+
+  template<typename ... Types>
+  static Type to_type(std::unique_ptr<Data>&& data, Types&& ...)
+  {
+    return to_type(data.get());
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type& value, Types&& ...)
+  {
+    return Data::make(Bytea_string_conversions::to_string(value), Data_format::text);
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type& value, const Data_format format, Types&& ...)
+  {
+    return format == Data_format::binary ?
+      Data::make(std::string_view{reinterpret_cast<const char*>(value.data()), value.size()}, Data_format::binary) :
+      to_data(value);
+  }
+
+  /// Appends the binary representation of the `value` to the `result`.
+  static void append_binary(std::string& result, const Type& value)
+  {
+    result.append(reinterpret_cast<const char*>(value.data()), value.size());
+  }
+};
+
+// -----------------------------------------------------------------------------
+// UUID conversions
+// -----------------------------------------------------------------------------
+
+/// The implementation of `std::array<std::byte, 16>` to/from `std::string` conversions.
+struct Uuid_string_conversions final {
+  using Type = std::array<std::byte, 16>;
+
+  template<typename ... Types>
+  static Type to_type(const std::string& text, Types&& ...)
+  {
+    return to_type__(text);
+  }
+
+  template<typename ... Types>
+  static std::string to_string(const Type& value, Types&& ...)
+  {
+    std::string result;
+    result.reserve(36);
+    append_hex(result, value.data(), 4);
+    for (const std::size_t offset : {4, 6, 8}) {
+      result += '-';
+      append_hex(result, value.data() + offset, 2);
+    }
+    result += '-';
+    append_hex(result, value.data() + 10, 6);
+    return result;
+  }
+
+private:
+  friend struct Uuid_data_conversions;
+
+  /*
+   * Accepts the same input as PostgreSQL does: the hex digits may be separated
+   * by hyphens after any group of four digits, and may be surrounded by braces.
+   */
+  static Type to_type__(std::string_view text)
+  {
+    const auto invalid = []
+    {
+      return std::runtime_error{"invalid text uuid representation"};
+    };
+
+    if (!text.empty() && text.front() == '{') {
+      if (text.back() != '}')
+        throw invalid();
+      text = text.substr(1, text.size() - 2);
+    }
+
+    Type result{};
+    std::size_t i{};
+    for (std::size_t j = 0; j < result.size(); ++j) {
+      if (j && !(j % 2) && i < text.size() && text[i] == '-')
+        ++i;
+      if (i + 1 >= text.size())
+        throw invalid();
+      const int hi = hex_digit_value(text[i++]);
+      const int lo = hex_digit_value(text[i++]);
+      if (hi < 0 || lo < 0)
+        throw invalid();
+      result[j] = static_cast<std::byte>(hi << 4 | lo);
+    }
+    if (i != text.size())
+      throw invalid();
+
+    return result;
+  }
+};
+
+/// The implementation of `std::array<std::byte, 16>` to/from Data conversions.
+struct Uuid_data_conversions final {
+  using Type = std::array<std::byte, 16>;
+
+  template<typename ... Types>
+  static Type to_type(const Data* const data, Types&& ...)
+  {
+    assert(data);
+    if (data->format() == Data_format::binary) {
+      Type result;
+      if (data->size() != result.size())
+        throw std::runtime_error{"invalid binary uuid representation"};
+      std::memcpy(result.data(), data->bytes(), result.size());
+      return result;
+    } else
+      return Uuid_string_conversions::to_type__({static_cast<const char*>(data->bytes()), data->size()});
+  }
+
+  template<typename ... Types>
+  static Type to_type(std::unique_ptr<Data>&& data, Types&& ...)
+  {
+    return to_type(data.get());
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type& value, Types&& ...)
+  {
+    return Data::make(Uuid_string_conversions::to_string(value), Data_format::text);
+  }
+
+  template<typename ... Types>
+  static std::unique_ptr<Data> to_data(const Type& value, const Data_format format, Types&& ...)
+  {
+    return format == Data_format::binary ?
+      Data::make(std::string_view{reinterpret_cast<const char*>(value.data()), value.size()}, Data_format::binary) :
+      to_data(value);
+  }
+
+  /// Appends the binary representation of the `value` to the `result`.
+  static void append_binary(std::string& result, const Type& value)
+  {
+    result.append(reinterpret_cast<const char*>(value.data()), value.size());
+  }
+};
+
 } // namespace dmitigr::pgfe::detail
 
 namespace dmitigr::pgfe {
@@ -434,11 +986,25 @@ namespace dmitigr::pgfe {
  *
  * Support of the following data formats is implemented:
  *   - for input data  - Data_format::text, Data_format::binary;
- *   - for output data - Data_format::text.
+ *   - for output data - Data_format::text, Data_format::binary.
+ *
+ * The output data is produced in Data_format::binary format only if this
+ * format is passed as the second argument of to_data(), for example:
+ * @code to_data(42, Data_format::binary) @endcode
+ * In this case the integers are encoded as `int2`, `int4` or `int8`, and the
+ * floating point numbers are encoded as `float4` or `float8` depending on
+ * the size of the `Type`.
  *
  * @par Requires
- * When converting to the native type `Type`, the size of the input data in
- * Data_format::binary format must be less or equal to the size of the `Type`.
+ * When converting to the native type `Type`, the input data in
+ * Data_format::binary format must be of type `int2`, `int4` or `int8` for
+ * integral types, or `float4` or `float8` for floating point types, which is
+ * not wider than `Type`. (For example, `int2` or `int4` for `int`.)
+ *
+ * @remarks Since the binary data is decoded according to its size, the data
+ * of the other type of the same size (for example, `float4` or `date` for
+ * `int`) cannot be detected and is decoded as the garbage. The type
+ * `numeric` isn't supported in Data_format::binary format.
  */
 template<typename T>
 struct Numeric_conversions : public Basic_conversions<T, detail::Numeric_string_conversions<T>,
@@ -578,7 +1144,8 @@ struct Conversions<char> final : public Basic_conversions<char,
  *
  * Support of the following data formats is implemented:
  *   - for input data  - Data_format::text, Data_format::binary;
- *   - for output data - Data_format::text.
+ *   - for output data - Data_format::text, Data_format::binary (see
+ *   Numeric_conversions for how to request the binary format).
  *
  * @par Requires
  * The size of the input data in the Data_format::binary format must be
@@ -588,6 +1155,53 @@ template<>
 struct Conversions<bool> final : public Basic_conversions<bool,
   detail::Bool_string_conversions, detail::Bool_data_conversions>{};
 
+/**
+ * @ingroup conversions
+ *
+ * @brief Full specialization of Conversions for `std::chrono::system_clock::time_point`.
+ *
+ * Support of the following data formats is implemented:
+ *   - for input data  - Data_format::text (ISO style of `timestamp`,
+ *   `timestamptz` and `date`), Data_format::binary (`timestamp`, `timestamptz`
+ *   and `date`);
+ *   - for output data - Data_format::text, Data_format::binary (`timestamptz`).
+ *
+ * @remarks The infinite timestamps are not supported.
+ */
+template<>
+struct Conversions<std::chrono::system_clock::time_point> final
+  : public Basic_conversions<std::chrono::system_clock::time_point,
+  detail::Time_point_string_conversions, detail::Time_point_data_conversions>{};
+
+/**
+ * @ingroup conversions
+ *
+ * @brief Full specialization of Conversions for `std::vector<std::byte>`
+ * which represents the PostgreSQL's `bytea`.
+ *
+ * Support of the following data formats is implemented:
+ *   - for input data  - Data_format::text (both hex and escape formats),
+ *   Data_format::binary;
+ *   - for output data - Data_format::text (hex format), Data_format::binary.
+ */
+template<>
+struct Conversions<std::vector<std::byte>> final : public Basic_conversions<std::vector<std::byte>,
+  detail::Bytea_string_conversions, detail::Bytea_data_conversions>{};
+
+/**
+ * @ingroup conversions
+ *
+ * @brief Full specialization of Conversions for `std::array<std::byte, 16>`
+ * which represents the PostgreSQL's `uuid`.
+ *
+ * Support of the following data formats is implemented:
+ *   - for input data  - Data_format::text, Data_format::binary;
+ *   - for output data - Data_format::text, Data_format::binary.
+ */
+template<>
+struct Conversions<std::array<std::byte, 16>> final : public Basic_conversions<std::array<std::byte, 16>,
+  detail::Uuid_string_conversions, detail::Uuid_data_conversions>{};
+
 /**
  * @ingroup conversions
  *
@@ -601,7 +1215,7 @@ struct Conversions<std::optional<T>> final {
   static Type to_type(const Data* const data, Types&& ... args)
   {
     if (data && *data)
-      return Conversions<T>::to_type(data, std::forward(args)...);
+      return Conversions<T>::to_type(data, std::forward<Types>(args)...);
     else
       return std::nullopt;
   }
@@ -610,7 +1224,7 @@ struct Conversions<std::optional<T>> final {
   static Type to_type(std::unique_ptr<Data>&& data, Types&& ... args)
   {
     if (data && *data)
-      return Conversions<T>::to_type(std::move(data), std::forward(args)...);
+      return Conversions<T>::to_type(std::move(data), std::forward<Types>(args)...);
     else
       return std::nullopt;
   }
@@ -619,7 +1233,7 @@ struct Conversions<std::optional<T>> final {
   static std::unique_ptr<Data> to_data(const Type& value, Types&& ... args)
   {
     if (value)
-      return Conversions<T>::to_data(*value, std::forward(args)...);
+      return Conversions<T>::to_data(*value, std::forward<Types>(args)...);
     else
       return nullptr;
   }
@@ -628,7 +1242,7 @@ struct Conversions<std::optional<T>> final {
   static std::unique_ptr<Data> to_data(Type&& value, Types&& ... args)
   {
     if (value)
-      return Conversions<T>::to_data(std::move(*value), std::forward(args)...);
+      return Conversions<T>::to_data(std::move(*value), std::forward<Types>(args)...);
     else
       return nullptr;
   }
@@ -637,7 +1251,7 @@ struct Conversions<std::optional<T>> final {
   static Type to_type(const Row& row, Types&& ... args)
   {
     if (row)
-      return Conversions<T>::to_type(row, std::forward(args)...);
+      return Conversions<T>::to_type(row, std::forward<Types>(args)...);
     else
       return std::nullopt;
   }
@@ -646,7 +1260,7 @@ struct Conversions<std::optional<T>> final {
   static Type to_type(Row&& row, Types&& ... args)
   {
     if (row)
-      return Conversions<T>::to_type(std::move(row), std::forward(args)...);
+      return Conversions<T>::to_type(std::move(row), std::forward<Types>(args)...);
     else
       return std::nullopt;
   }
@@ -77,6 +77,9 @@ namespace dmitigr::pgfe {
  * that conversion will work properly with data from PostgreSQL servers of older
  * versions than the latest one. If the application works with multiple PostgreSQL
  * servers of the same (latest) versions these arguments can be just ignored.
+ * The value of type Data_format can be passed as the first of these arguments
+ * to (4) and (14) to request the specific format of the resulting data. The
+ * conversions which doesn't support the requested format ignore it.
  *
  * @remarks An implementation of generic conversions will throw exceptions of
  * type `std::runtime_error` if the following is not fulfilled:
@@ -0,0 +1,90 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "connection.hpp"
+#include "copier.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE Data_format Copier::data_format() const noexcept
+{
+  assert(is_valid());
+  return ::PQbinaryTuples(pq_result_.native_handle()) ? Data_format::binary : Data_format::text;
+}
+
+DMITIGR_PGFE_INLINE Data_direction Copier::data_direction() const noexcept
+{
+  assert(is_valid());
+  return pq_result_.status() == PGRES_COPY_OUT ? Data_direction::from_server : Data_direction::to_server;
+}
+
+DMITIGR_PGFE_INLINE void Copier::send(const std::string_view data) const
+{
+  assert(is_valid() && data_direction() == Data_direction::to_server);
+  // PQputCopyData() accepts the size of type int, so the data is sent by chunks.
+  constexpr std::size_t max_chunk_size = std::numeric_limits<int>::max();
+  for (auto rest = data; !rest.empty();) {
+    const auto chunk_size = std::min(rest.size(), max_chunk_size);
+    if (::PQputCopyData(conn(), rest.data(), static_cast<int>(chunk_size)) != 1)
+      throw std::runtime_error{connection_->error_message()};
+    rest.remove_prefix(chunk_size);
+  }
+}
+
+DMITIGR_PGFE_INLINE void Copier::end(const std::string& error_message) const
+{
+  assert(is_valid() && data_direction() == Data_direction::to_server);
+  const char* const errmsg = !error_message.empty() ? error_message.c_str() : nullptr;
+  if (::PQputCopyEnd(conn(), errmsg) != 1)
+    throw std::runtime_error{connection_->error_message()};
+}
+
+DMITIGR_PGFE_INLINE std::unique_ptr<Data> Copier::receive() const
+{
+  assert(is_valid() && data_direction() == Data_direction::from_server);
+  char* buffer{};
+  const int size = ::PQgetCopyData(conn(), &buffer, false);
+  if (size > 0) {
+    assert(buffer);
+    return Data::make(std::unique_ptr<void, void(*)(void*)>{buffer, &::PQfreemem},
+      static_cast<std::size_t>(size), data_format());
+  } else if (size == -1)
+    return nullptr;
+  else
+    throw std::runtime_error{connection_->error_message()};
+}
+
+DMITIGR_PGFE_INLINE bool Copier::is_invariant_ok() const noexcept
+{
+  const auto status = pq_result_.status();
+  return !connection_ ||
+    (status == PGRES_COPY_IN || status == PGRES_COPY_OUT || status == PGRES_COPY_BOTH);
+}
+
+DMITIGR_PGFE_INLINE ::PGconn* Copier::conn() const noexcept
+{
+  assert(is_valid());
+  return connection_->conn();
+}
+
+DMITIGR_PGFE_INLINE void Copier::append_escaped__(std::string& result,
+  const std::string_view value)
+{
+  result.reserve(result.size() + value.size());
+  for (const char c : value) {
+    switch (c) {
+    case '\\': result.append("\\\\"); break;
+    case '\t': result.append("\\t"); break;
+    case '\n': result.append("\\n"); break;
+    case '\r': result.append("\\r"); break;
+    default: result += c;
+    }
+  }
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,246 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_COPIER_HPP
+#define DMITIGR_PGFE_COPIER_HPP
+
+#include "basics.hpp"
+#include "conversions.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "pq.hpp"
+#include "response.hpp"
+#include "types_fwd.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup main
+ *
+ * @brief A COPY operation in progress.
+ *
+ * The instance of this class is available after the execution of the `COPY`
+ * command with either `FROM STDIN` or `TO STDOUT` clause. The data must be
+ * either sent by using send() (or send_row()) and the operation must be
+ * finished by end() in the former case, or received by using receive() until
+ * it returns `nullptr` in the latter case. Then the response to the `COPY`
+ * command must be processed as usual (for example, by using
+ * Connection::wait_response() and Connection::completion()).
+ *
+ * @see Connection::copier().
+ */
+class Copier final : public Response {
+public:
+  /// Default-constructible. (Constructs invalid instance.)
+  Copier() = default;
+
+  /// Non copy-constructible.
+  Copier(const Copier&) = delete;
+
+  /// Non copy-assignable.
+  Copier& operator=(const Copier&) = delete;
+
+  /// Move-constructible.
+  Copier(Copier&& rhs) noexcept
+    : connection_{rhs.connection_}
+    , pq_result_{std::move(rhs.pq_result_)}
+  {
+    rhs.connection_ = nullptr;
+  }
+
+  /// Move-assignable.
+  Copier& operator=(Copier&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      Copier tmp{std::move(rhs)};
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  /// Swaps the instances.
+  void swap(Copier& rhs) noexcept
+  {
+    using std::swap;
+    swap(connection_, rhs.connection_);
+    swap(pq_result_, rhs.pq_result_);
+  }
+
+  /// @see Message::is_valid().
+  bool is_valid() const noexcept override
+  {
+    return connection_;
+  }
+
+  /// @returns The number of fields (columns) of the data to be copied.
+  std::size_t field_count() const noexcept
+  {
+    return static_cast<std::size_t>(pq_result_.field_count());
+  }
+
+  /// @returns The overall data format of the data to be copied.
+  DMITIGR_PGFE_API Data_format data_format() const noexcept;
+
+  /**
+   * @returns The data format of the field of the specified index.
+   *
+   * @par Requires
+   * `(index < field_count())`.
+   */
+  Data_format data_format(const std::size_t index) const noexcept
+  {
+    assert(index < field_count());
+    return pq_result_.field_format(static_cast<int>(index));
+  }
+
+  /// @returns The data direction.
+  DMITIGR_PGFE_API Data_direction data_direction() const noexcept;
+
+  /**
+   * @brief Sends the `data` to the server.
+   *
+   * The data doesn't need to be aligned by the boundaries of the rows. This
+   * method blocks the calling thread if the output buffer of the connection is
+   * full until the server consumes the previously sent data, so the memory usage
+   * is bounded regardless of the size of the data to be copied. The data of
+   * any size is accepted (the data larger than `INT_MAX` bytes is sent by
+   * several chunks).
+   *
+   * @par Requires
+   * `(is_valid() && data_direction() == Data_direction::to_server)`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @see end().
+   */
+  DMITIGR_PGFE_API void send(std::string_view data) const;
+
+  /**
+   * @brief Sends the row of the `values` to the server in the text format.
+   *
+   * Each value is converted by using to_data() and escaped as required by
+   * the text format of `COPY`. The values which converted to `nullptr` (for
+   * example, the empty `std::optional` or `nullptr` itself) are sent as `NULL`.
+   *
+   * @par Requires
+   * `(is_valid() && data_direction() == Data_direction::to_server &&
+   * data_format() == Data_format::text)`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename ... Types>
+  void send_row(Types&& ... values) const
+  {
+    std::string row;
+    std::size_t i{};
+    (append_field__(row, i++, std::forward<Types>(values)), ...);
+    row += '\n';
+    send(row);
+  }
+
+  /**
+   * @brief Finishes sending the data to the server.
+   *
+   * @param error_message If not empty, forces the `COPY` to fail with the
+   * specified error message.
+   *
+   * @par Requires
+   * `(is_valid() && data_direction() == Data_direction::to_server)`.
+   *
+   * @par Effects
+   * The response to the `COPY` command can be awaited.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API void end(const std::string& error_message = {}) const;
+
+  /**
+   * @brief Receives the next portion of the data from the server.
+   *
+   * @returns The received data (which is normally one row in the format of
+   * `COPY`), or `nullptr` if there are no more data to receive.
+   *
+   * @par Requires
+   * `(is_valid() && data_direction() == Data_direction::from_server)`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @remarks The data is not copied from the buffer allocated by libpq.
+   */
+  DMITIGR_PGFE_API std::unique_ptr<Data> receive() const;
+
+  /// @returns The connection of this instance.
+  const Connection& connection() const noexcept
+  {
+    assert(is_valid());
+    return *connection_;
+  }
+
+  /// @overload
+  Connection& connection() noexcept
+  {
+    return const_cast<Connection&>(static_cast<const Copier*>(this)->connection());
+  }
+
+private:
+  friend Connection;
+
+  Connection* connection_{};
+  detail::pq::Result pq_result_;
+
+  /// The constructor.
+  Copier(Connection& connection, detail::pq::Result&& pq_result) noexcept
+    : connection_{&connection}
+    , pq_result_{std::move(pq_result)}
+  {
+    assert(is_invariant_ok());
+  }
+
+  DMITIGR_PGFE_API bool is_invariant_ok() const noexcept;
+
+  DMITIGR_PGFE_API ::PGconn* conn() const noexcept;
+
+  template<typename T>
+  static void append_field__(std::string& row, const std::size_t index, T&& value)
+  {
+    if (index)
+      row += '\t';
+    if constexpr (!std::is_same_v<std::decay_t<T>, std::nullptr_t>) {
+      if (const auto data = to_data(std::forward<T>(value))) {
+        assert(data->format() == Data_format::text);
+        append_escaped__(row, std::string_view{static_cast<const char*>(data->bytes()), data->size()});
+        return;
+      }
+    }
+    row.append("\\N");
+  }
+
+  static DMITIGR_PGFE_API void append_escaped__(std::string& result, std::string_view value);
+};
+
+/**
+ * @ingroup main
+ *
+ * @brief Copier is swappable.
+ */
+inline void swap(Copier& lhs, Copier& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace dmitigr::pgfe
+
+#endif  // DMITIGR_PGFE_COPIER_HPP
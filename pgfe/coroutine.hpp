@@ -0,0 +1,579 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_COROUTINE_HPP
+#define DMITIGR_PGFE_COROUTINE_HPP
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "completion.hpp"
+#include "connection.hpp"
+#include "connection_pool.hpp"
+#include "error.hpp"
+#include "exceptions.hpp"
+#include "reactor.hpp"
+#include "row.hpp"
+#include "sql_string.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief An alias of the executor of the coroutines.
+ *
+ * The executor is called to resume the suspended coroutine. For example, it
+ * can push the coroutine handle to the queue of the tasks to resume it later.
+ * The empty executor means that the coroutines are resumed inline, i.e. from
+ * the handlers of Reactor.
+ */
+using Coroutine_executor = std::function<void(std::coroutine_handle<>)>;
+
+namespace detail {
+
+/// Resumes the `handle` by using the `executor`.
+inline void resume(const Coroutine_executor& executor, const std::coroutine_handle<> handle)
+{
+  if (executor)
+    executor(handle);
+  else
+    handle.resume();
+}
+
+} // namespace detail
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A coroutine which is started immediately upon the call.
+ *
+ * @par Example
+ * @code
+ * Task query(Awaitable_connection& conn)
+ * {
+ *   const auto result = co_await conn.execute("select $1::int", 1);
+ *   std::cout << to<int>(result.rows.front()[0]) << std::endl;
+ * }
+ * @endcode
+ *
+ * @warning The behaivor is undefined if the instance of this class is
+ * destroyed before the coroutine is done.
+ */
+class Task final {
+public:
+  /// The promise type.
+  struct promise_type final {
+    /// @returns The task.
+    Task get_return_object() noexcept
+    {
+      return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    /// @returns The awaitable to start the coroutine immediately.
+    std::suspend_never initial_suspend() const noexcept
+    {
+      return {};
+    }
+
+    /// @returns The awaitable to keep the coroutine state until destruction.
+    std::suspend_always final_suspend() const noexcept
+    {
+      return {};
+    }
+
+    /// Does nothing.
+    void return_void() const noexcept
+    {}
+
+    /// Stores the exception.
+    void unhandled_exception() noexcept
+    {
+      exception = std::current_exception();
+    }
+
+    /// The unhandled exception.
+    std::exception_ptr exception;
+  };
+
+  /// The destructor.
+  ~Task()
+  {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  /// Default-constructible. (Constructs invalid instance.)
+  Task() noexcept = default;
+
+  /// Non copy-constructible.
+  Task(const Task&) = delete;
+
+  /// Non copy-assignable.
+  Task& operator=(const Task&) = delete;
+
+  /// Move-constructible.
+  Task(Task&& rhs) noexcept
+    : handle_{std::exchange(rhs.handle_, {})}
+  {}
+
+  /// Move-assignable.
+  Task& operator=(Task&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      Task tmp{std::move(rhs)};
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  /// Swaps this instance with `rhs`.
+  void swap(Task& rhs) noexcept
+  {
+    using std::swap;
+    swap(handle_, rhs.handle_);
+  }
+
+  /// @returns `true` if the coroutine is done.
+  bool is_done() const noexcept
+  {
+    return !handle_ || handle_.done();
+  }
+
+  /**
+   * @brief Rethrows the unhandled exception of the coroutine (if any).
+   *
+   * @par Requires
+   * `is_done()`.
+   */
+  void get() const
+  {
+    assert(is_done());
+    if (handle_ && handle_.promise().exception)
+      std::rethrow_exception(handle_.promise().exception);
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task(const std::coroutine_handle<promise_type> handle) noexcept
+    : handle_{handle}
+  {}
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A result of the awaited execution.
+ */
+struct Execute_result final {
+  /// The rows.
+  std::vector<Row> rows;
+
+  /// The completion.
+  Completion completion;
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A connection which provides the awaitable operations.
+ *
+ * The operations are performed by the Reactor, so the coroutines are suspended
+ * until the responses arrive, and are resumed via the executor.
+ *
+ * @par Example
+ * @code
+ * Reactor reactor;
+ * Connection conn{options};
+ * Awaitable_connection aconn{reactor, conn};
+ * auto task = [&]() -> Task
+ * {
+ *   co_await aconn.connect();
+ *   auto* const ps = co_await aconn.prepare("select $1::int", "ps");
+ *   const auto result = co_await aconn.execute("select 1");
+ * }();
+ * reactor.run();
+ * task.get();
+ * @endcode
+ *
+ * @warning The operations must be awaited from the thread which runs the
+ * reactor.
+ *
+ * @warning The behaivor is undefined if the instance of this class is
+ * destroyed while there are operations awaited.
+ */
+class Awaitable_connection final {
+public:
+  /**
+   * @brief The destructor.
+   *
+   * Removes the underlying connection from the reactor.
+   */
+  ~Awaitable_connection()
+  {
+    assert(operations_.empty());
+    reactor_.remove(connection_);
+  }
+
+  /**
+   * @brief The constructor.
+   *
+   * @par Requires
+   * `(!reactor.contains(connection))`.
+   */
+  Awaitable_connection(Reactor& reactor, Connection& connection,
+    Coroutine_executor executor = {}) noexcept
+    : reactor_{reactor}
+    , connection_{connection}
+    , executor_{std::move(executor)}
+  {
+    assert(!reactor_.contains(connection_));
+  }
+
+  /// Non copy-constructible.
+  Awaitable_connection(const Awaitable_connection&) = delete;
+
+  /// Non copy-assignable.
+  Awaitable_connection& operator=(const Awaitable_connection&) = delete;
+
+  /// @returns The underlying reactor.
+  Reactor& reactor() const noexcept
+  {
+    return reactor_;
+  }
+
+  /// @returns The underlying connection.
+  Connection& connection() const noexcept
+  {
+    return connection_;
+  }
+
+  /// @returns The executor.
+  const Coroutine_executor& executor() const noexcept
+  {
+    return executor_;
+  }
+
+  /**
+   * @returns The awaitable of the connection establishment.
+   *
+   * @remarks It's not necessary to await the establishment explicitly, since
+   * the requests are queued until the connection is established.
+   */
+  auto connect()
+  {
+    class Awaiter final : Operation {
+    public:
+      explicit Awaiter(Awaitable_connection& self) noexcept
+        : self_{self}
+      {}
+
+      bool await_ready() const noexcept
+      {
+        return self_.reactor_.contains(self_.connection_) &&
+          self_.connection_.is_connected();
+      }
+
+      void await_suspend(const std::coroutine_handle<> handle)
+      {
+        handle_ = handle;
+        self_.start__(*this, [this]
+        {
+          if (!self_.reactor_.contains(self_.connection_))
+            self_.add__([this](Connection&){ self_.finish__(*this); });
+          else
+            // Await the establishment via the queue of the reactor.
+            self_.reactor_.submit(self_.connection_, [](Connection& conn)
+            {
+              conn.execute_nio("select 1");
+            }, [this](Completion&&, Error&&){ self_.finish__(*this); });
+        });
+      }
+
+      void await_resume() const
+      {
+        if (exception_)
+          std::rethrow_exception(exception_);
+      }
+
+    private:
+      Awaitable_connection& self_;
+    };
+    return Awaiter{*this};
+  }
+
+  /**
+   * @returns The awaitable of the execution of the `statement` which results
+   * to the instance of type Execute_result.
+   *
+   * @param statement A *preparsed* statement to execute.
+   * @param parameters Parameters to bind with a parameterized statement.
+   *
+   * @par Requires
+   * `!statement.has_missing_parameters()`.
+   *
+   * @throws Server_exception on error.
+   *
+   * @see Reactor::execute().
+   */
+  template<typename ... Types>
+  auto execute(Sql_string statement, Types&& ... parameters)
+  {
+    class Awaiter final : Operation {
+    public:
+      Awaiter(Awaitable_connection& self, std::function<void(Connection&)>&& request) noexcept
+        : self_{self}
+        , request_{std::move(request)}
+      {}
+
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+      void await_suspend(const std::coroutine_handle<> handle)
+      {
+        handle_ = handle;
+        self_.start__(*this, [this]
+        {
+          self_.add__();
+          self_.reactor_.submit(self_.connection_, std::move(request_),
+            [this](Completion&& completion, Error&& error)
+            {
+              result_.completion = std::move(completion);
+              error_ = std::move(error);
+              self_.finish__(*this);
+            },
+            [this](Row&& row)
+            {
+              result_.rows.push_back(std::move(row));
+            });
+        });
+      }
+
+      Execute_result await_resume()
+      {
+        if (exception_)
+          std::rethrow_exception(exception_);
+        else if (error_)
+          throw Server_exception{std::make_shared<Error>(std::move(error_))};
+        return std::move(result_);
+      }
+
+    private:
+      Awaitable_connection& self_;
+      std::function<void(Connection&)> request_;
+      Execute_result result_;
+      Error error_;
+    };
+
+    auto arguments = std::make_shared<std::tuple<std::decay_t<Types>...>>(
+      std::forward<Types>(parameters)...);
+    return Awaiter{*this, [statement = std::move(statement),
+      arguments = std::move(arguments)](Connection& conn)
+    {
+      std::apply([&conn, &statement](auto& ... args)
+      {
+        conn.execute_nio(statement, std::move(args)...);
+      }, *arguments);
+    }};
+  }
+
+  /**
+   * @returns The awaitable of the preparation of the `statement` which results
+   * to the pointer to the prepared statement.
+   *
+   * @param statement A *preparsed* statement to prepare.
+   * @param name A name of the statement to be prepared.
+   *
+   * @par Requires
+   * `!statement.has_missing_parameters()`.
+   *
+   * @throws Server_exception on error.
+   *
+   * @see Connection::prepare_nio().
+   */
+  auto prepare(Sql_string statement, std::string name = {})
+  {
+    class Awaiter final : Operation {
+    public:
+      Awaiter(Awaitable_connection& self, Sql_string&& statement, std::string&& name) noexcept
+        : self_{self}
+        , statement_{std::move(statement)}
+        , name_{std::move(name)}
+      {}
+
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+      void await_suspend(const std::coroutine_handle<> handle)
+      {
+        handle_ = handle;
+        self_.start__(*this, [this]
+        {
+          self_.add__();
+          self_.reactor_.submit(self_.connection_, [this](Connection& conn)
+          {
+            conn.prepare_nio(statement_, name_);
+          }, [this](Completion&&, Error&& error)
+          {
+            if (!(error_ = std::move(error)))
+              result_ = self_.connection_.prepared_statement();
+            self_.finish__(*this);
+          });
+        });
+      }
+
+      Prepared_statement* await_resume()
+      {
+        if (exception_)
+          std::rethrow_exception(exception_);
+        else if (error_)
+          throw Server_exception{std::make_shared<Error>(std::move(error_))};
+        assert(result_);
+        return result_;
+      }
+
+    private:
+      Awaitable_connection& self_;
+      Sql_string statement_;
+      std::string name_;
+      Prepared_statement* result_{};
+      Error error_;
+    };
+    return Awaiter{*this, std::move(statement), std::move(name)};
+  }
+
+private:
+  /// The state of the awaited operation.
+  class Operation {
+  protected:
+    friend Awaitable_connection;
+    std::coroutine_handle<> handle_;
+    std::exception_ptr exception_;
+  };
+
+  Reactor& reactor_;
+  Connection& connection_;
+  Coroutine_executor executor_;
+  std::vector<Operation*> operations_;
+
+  /// Registers the connection in the reactor unless it's already registered.
+  void add__(Reactor::Connect_handler handler = {})
+  {
+    if (reactor_.contains(connection_)) {
+      if (handler)
+        handler(connection_);
+      return;
+    }
+
+
+    reactor_.add(connection_, std::move(handler), [this](Connection&,
+        const std::exception_ptr exception)
+    {
+      // Fail all of the awaited operations since the connection is removed.
+      auto operations = std::move(operations_);
+      operations_.clear();
+      for (auto* const operation : operations) {
+        operation->exception_ = exception;
+        detail::resume(executor_, operation->handle_);
+      }
+    });
+  }
+
+  /// Starts the `operation` by calling `start`.
+  template<class F>
+  void start__(Operation& operation, F&& start)
+  {
+    operations_.push_back(&operation);
+    try {
+      start();
+    } catch (...) {
+      const auto i = std::find(operations_.begin(), operations_.end(), &operation);
+      if (i != operations_.end())
+        operations_.erase(i);
+      throw;
+    }
+  }
+
+  /// Finishes the `operation` and resumes the awaiting coroutine.
+  void finish__(Operation& operation)
+  {
+    const auto i = std::find(operations_.begin(), operations_.end(), &operation);
+    assert(i != operations_.end());
+    operations_.erase(i);
+    detail::resume(executor_, operation.handle_);
+  }
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @returns The awaitable of the acquisition of the connection from the `pool`
+ * which results to the instance of type Connection_pool::Handle. The handle is
+ * invalid if the pool is not connected (or disconnected while waiting).
+ *
+ * @param pool The pool to acquire the connection from.
+ * @param executor The executor to resume the coroutine if there is no free
+ * connection in the pool. In this case the coroutine waits without blocking
+ * the thread, and is resumed by using the `executor` from the thread which
+ * releases the connection to the pool (or disconnects the pool).
+ *
+ * @see Connection_pool::enqueue().
+ */
+inline auto connection(Connection_pool& pool, Coroutine_executor executor = {})
+{
+  class Awaiter final {
+  public:
+    Awaiter(Connection_pool& pool, Coroutine_executor&& executor)
+      : pool_{pool}
+      , executor_{std::move(executor)}
+      , waiter_{[this]{ detail::resume(executor_, handle_); }}
+    {}
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    bool await_suspend(const std::coroutine_handle<> handle)
+    {
+      handle_ = handle;
+      // The coroutine can be resumed by the other thread before returning.
+      return pool_.enqueue(waiter_);
+    }
+
+    Connection_pool::Handle await_resume()
+    {
+      return pool_.connection(waiter_);
+    }
+
+  private:
+    Connection_pool& pool_;
+    Coroutine_executor executor_;
+    std::coroutine_handle<> handle_;
+    Connection_pool::Async_waiter waiter_;
+  };
+  return Awaiter{pool, std::move(executor)};
+}
+
+} // namespace dmitigr::pgfe
+
+#endif  // defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#endif  // DMITIGR_PGFE_COROUTINE_HPP
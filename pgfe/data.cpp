@@ -114,6 +114,146 @@ using custom_memory_Data = memory_Data<void, void(*)(void*)>;
 
 // =============================================================================
 
+/**
+ * @brief The thread-local free list of the memory blocks of size `BlockSize`.
+ *
+ * @details The blocks released by deallocate() are reused by allocate() of
+ * the same thread instead of returning them to the heap. At most `max_size`
+ * blocks are kept per thread, the rest are returned to the heap. The blocks
+ * may be released by a thread other than the one which allocated them.
+ */
+template<std::size_t BlockSize>
+class Block_pool final {
+public:
+  static_assert(BlockSize >= sizeof(void*));
+
+  /// The maximum number of free blocks kept per thread.
+  static constexpr std::size_t max_size{1024};
+
+  /// @returns The block of size `BlockSize`.
+  static void* allocate()
+  {
+    auto& state = state__();
+    if (auto* const block = state.head) {
+      state.head = block->next;
+      --state.size;
+      return block;
+    } else
+      return ::operator new(BlockSize);
+  }
+
+  /// Releases the `block` returned by allocate().
+  static void deallocate(void* const block) noexcept
+  {
+    auto& state = state__();
+    if (!state.is_exiting && state.size < max_size) {
+      thread_local const Cleaner cleaner; // frees the blocks at thread exit
+      (void)cleaner;
+      state.head = ::new(block) Block{state.head};
+      ++state.size;
+    } else
+      ::operator delete(block);
+  }
+
+private:
+  struct Block final {
+    Block* next{};
+  };
+
+  /// The state is trivially destructible so it's accessible at thread exit.
+  struct State final {
+    Block* head{};
+    std::size_t size{};
+    bool is_exiting{};
+  };
+
+  struct Cleaner final {
+    ~Cleaner()
+    {
+      auto& state = state__();
+      state.is_exiting = true;
+      while (auto* const block = state.head) {
+        state.head = block->next;
+        ::operator delete(block);
+      }
+      state.size = 0;
+    }
+  };
+
+  static State& state__() noexcept
+  {
+    thread_local State state;
+    return state;
+  }
+};
+
+// =============================================================================
+
+/**
+ * @brief The implementation of Data with the inline storage of small size.
+ *
+ * @details The instances are allocated from the Block_pool.
+ */
+class small_Data final : public Data {
+public:
+  /// The maximum size of the data to store.
+  static constexpr std::size_t capacity{32};
+
+  small_Data(const std::string_view bytes, const Format format) noexcept
+    : format_(format)
+    , size_(static_cast<unsigned char>(bytes.size()))
+  {
+    assert(bytes.size() <= capacity);
+    std::memcpy(bytes_, bytes.data(), bytes.size());
+    bytes_[bytes.size()] = '\0';
+    assert(is_invariant_ok());
+  }
+
+  static void* operator new(const std::size_t size)
+  {
+    assert(size == sizeof(small_Data));
+    (void)size;
+    return Block_pool<sizeof(small_Data)>::allocate();
+  }
+
+  static void operator delete(void* const ptr) noexcept
+  {
+    Block_pool<sizeof(small_Data)>::deallocate(ptr);
+  }
+
+  std::unique_ptr<Data> to_data() const override
+  {
+    return std::make_unique<small_Data>(std::string_view{bytes_, size_}, format_);
+  }
+
+  Format format() const noexcept override
+  {
+    return format_;
+  }
+
+  std::size_t size() const noexcept override
+  {
+    return size_;
+  }
+
+  bool is_empty() const noexcept override
+  {
+    return !size_;
+  }
+
+  const void* bytes() const noexcept override
+  {
+    return bytes_;
+  }
+
+private:
+  const Format format_{Format::text};
+  unsigned char size_{};
+  char bytes_[capacity + 1];
+};
+
+// =============================================================================
+
 /// The implementation of empty Data.
 class empty_Data final : public Data {
 public:
@@ -200,7 +340,10 @@ DMITIGR_PGFE_INLINE bool Data::is_invariant_ok() const
 DMITIGR_PGFE_INLINE std::unique_ptr<Data>
 Data::make(std::string&& storage, const Data_format format)
 {
-  return std::make_unique<detail::string_Data>(std::move(storage), format);
+  if (storage.size() <= detail::small_Data::capacity)
+    return std::make_unique<detail::small_Data>(storage, format);
+  else
+    return std::make_unique<detail::string_Data>(std::move(storage), format);
 }
 
 DMITIGR_PGFE_INLINE std::unique_ptr<Data>
@@ -213,12 +356,14 @@ Data::make(std::unique_ptr<void, void(*)(void*)>&& storage, const std::size_t si
 DMITIGR_PGFE_INLINE std::unique_ptr<Data>
 Data::make(const std::string_view bytes, const Data_format format)
 {
-  if (bytes.size() > 0) {
+  if (bytes.size() > detail::small_Data::capacity) {
     std::unique_ptr<char[]> storage{new char[bytes.size() + 1]};
     std::memcpy(storage.get(), bytes.data(), bytes.size());
     storage.get()[bytes.size()] = '\0';
     return std::make_unique<detail::array_memory_Data>(std::move(storage), bytes.size(), format);
-  } else
+  } else if (bytes.size() > 0)
+    return std::make_unique<detail::small_Data>(bytes, format);
+  else
     return std::make_unique<detail::empty_Data>(format);
 }
 
@@ -273,12 +418,9 @@ DMITIGR_PGFE_INLINE void Data_view::swap(Data_view& rhs) noexcept
   swap(bytes_, rhs.bytes_);
 }
 
-std::unique_ptr<Data> Data_view::to_data() const
+DMITIGR_PGFE_INLINE std::unique_ptr<Data> Data_view::to_data() const
 {
-  const std::size_t sz = static_cast<std::size_t>(size_);
-  std::unique_ptr<char[]> storage{new char[sz]};
-  std::memcpy(storage.get(), bytes_, sz);
-  return std::make_unique<detail::array_memory_Data>(std::move(storage), sz, format_);
+  return Data::make(std::string_view{bytes_, static_cast<std::size_t>(size_)}, format_);
 }
 
 } // namespace dmitigr::pgfe
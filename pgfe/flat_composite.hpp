@@ -0,0 +1,557 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_FLAT_COMPOSITE_HPP
+#define DMITIGR_PGFE_FLAT_COMPOSITE_HPP
+
+#include "composite.hpp"
+#include "compositional.hpp"
+#include "conversions.hpp"
+#include "data.hpp"
+#include "row.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+
+/// Denotes the types of data which are copied into Flat_composite as is.
+template<typename T>
+struct Is_flat_composite_data final : std::bool_constant<
+  std::is_convertible_v<T&&, const Data*> ||
+  std::is_base_of_v<Data, std::decay_t<T>> ||
+  std::is_same_v<std::decay_t<T>, std::unique_ptr<Data>>> {};
+
+} // namespace detail
+
+/**
+ * @ingroup main
+ *
+ * @brief A composite type with the flat storage.
+ *
+ * @details Unlike Composite, the names and the data of all the fields are
+ * stored in the single buffer, so neither appending nor copying of the
+ * instance requires the memory allocation per field. The fields are looked up
+ * by names by using the hash index which is maintained by the modifiers if
+ * the number of fields is not less than `hash_threshold`. (Thus, the lookups
+ * don't modify the instance and can be performed concurrently.)
+ *
+ * @remarks The views returned by name_of() and data() are invalidated by the
+ * modifications of the instance. (Though, they can be passed to the
+ * modifiers of the same instance, for example, `fc.append("copy", fc.data(0))`.)
+ *
+ * @see Composite.
+ */
+class Flat_composite final : public Compositional {
+public:
+  /// The minimum number of fields to look up them by using the hash index.
+  static constexpr std::size_t hash_threshold{16};
+
+  /// Default-constructible
+  Flat_composite() = default;
+
+  /// The constructor.
+  explicit Flat_composite(const Composite& composite)
+  {
+    fields_.reserve(composite.size());
+    for (const auto& [name, data] : composite)
+      append(name, data.get());
+    assert(is_invariant_ok());
+  }
+
+  /// @overload
+  explicit Flat_composite(const Row& row)
+  {
+    const auto sz = row.size();
+    std::size_t buffer_size{};
+    for (std::size_t i = 0; i < sz; ++i)
+      buffer_size += row.name_of(i).size() + row.data(i).size() + 2;
+    reserve(sz, buffer_size);
+    for (std::size_t i = 0; i < sz; ++i)
+      append(row.name_of(i), row.data(i));
+    assert(is_invariant_ok());
+  }
+
+  /// Copy-constructible.
+  Flat_composite(const Flat_composite& rhs) = default;
+
+  /// Copy-assignable.
+  Flat_composite& operator=(const Flat_composite& rhs) = default;
+
+  /// Move-constructible.
+  Flat_composite(Flat_composite&& rhs) = default;
+
+  /// Move-assignable.
+  Flat_composite& operator=(Flat_composite&& rhs) = default;
+
+  /// Swaps the instances.
+  void swap(Flat_composite& rhs) noexcept
+  {
+    using std::swap;
+    swap(buffer_, rhs.buffer_);
+    swap(fields_, rhs.fields_);
+    swap(garbage_size_, rhs.garbage_size_);
+    swap(buckets_, rhs.buckets_);
+  }
+
+  /// @returns The Composite with the copies of the fields of this instance.
+  Composite to_composite() const
+  {
+    std::vector<std::pair<std::string, std::unique_ptr<Data>>> datas;
+    datas.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+      const auto d = data(i);
+      datas.emplace_back(name_of(i), d ? Data::make(std::string_view{
+        static_cast<const char*>(d.bytes()), d.size()}, d.format()) : nullptr);
+    }
+    return Composite{std::move(datas)};
+  }
+
+  /// @see Compositional::size().
+  std::size_t size() const noexcept override
+  {
+    return fields_.size();
+  }
+
+  /// @see Compositional::is_empty().
+  bool is_empty() const noexcept override
+  {
+    return fields_.empty();
+  }
+
+  /// @see Compositional::name_of().
+  std::string_view name_of(const std::size_t index) const noexcept override
+  {
+    assert(index < size());
+    const auto& field = fields_[index];
+    return {buffer_.data() + field.name_offset, field.name_size};
+  }
+
+  /// @see Compositional::index_of().
+  std::size_t index_of(const std::string_view name, const std::size_t offset = 0) const noexcept override
+  {
+    const auto sz = size();
+    if (offset >= sz)
+      return sz;
+
+    if (!buckets_.empty()) {
+      const auto mask = buckets_.size() - 1;
+      for (auto b = bucket_of(name); buckets_[b]; b = (b + 1) & mask) {
+        if (const std::size_t i = buckets_[b] - 1; name_of(i) == name) {
+          if (i >= offset)
+            return i;
+          else
+            break; // fall back to the scan of the duplicates
+        }
+      }
+    }
+
+    for (auto i = offset; i < sz; ++i)
+      if (name_of(i) == name)
+        return i;
+    return sz;
+  }
+
+  /**
+   * @returns The field data of this composite, or invalid instance if NULL.
+   *
+   * @param index See Compositional.
+   *
+   * @par Requires
+   * `(index < size())`.
+   */
+  Data_view data(const std::size_t index) const noexcept
+  {
+    assert(index < size());
+    const auto& field = fields_[index];
+    return field.data_size >= 0 ?
+      Data_view{buffer_.data() + field.data_offset, field.data_size, field.data_format} :
+      Data_view{};
+  }
+
+  /**
+   * @overload
+   *
+   * @param name See Compositional.
+   * @param offset See Compositional.
+   *
+   * @par Requires
+   * `has_field(name, offset)`.
+   */
+  Data_view data(const std::string_view name, const std::size_t offset = 0) const noexcept
+  {
+    return data(index_of(name, offset));
+  }
+
+  /// @returns `data(index)`.
+  Data_view operator[](const std::size_t index) const noexcept
+  {
+    return data(index);
+  }
+
+  /// @returns `data(name)`.
+  Data_view operator[](const std::string_view name) const noexcept
+  {
+    return data(name);
+  }
+
+  /**
+   * @brief Sets the data of the specified index with the copy of `data`.
+   *
+   * @param data The data to copy, or `nullptr` to set NULL.
+   *
+   * @par Requires
+   * `(index < size())`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void set_data(const std::size_t index, const Data* const data)
+  {
+    if (data)
+      set_data__(index, static_cast<const char*>(data->bytes()), data->size(), data->format());
+    else
+      set_data__(index, nullptr, 0, Data_format::text);
+  }
+
+  /// @overload
+  void set_data(const std::size_t index, const Data_view& data)
+  {
+    set_data(index, data ? &data : nullptr);
+  }
+
+  /// @overload
+  void set_data(const std::size_t index, const std::unique_ptr<Data>& data)
+  {
+    set_data(index, data.get());
+  }
+
+  /**
+   * @overload
+   *
+   * @brief Sets the data of the specified index with the value of type T,
+   * implicitly converted to the Data by using to_data().
+   */
+  template<typename T>
+  std::enable_if_t<!detail::Is_flat_composite_data<T>::value> set_data(const std::size_t index, T&& value)
+  {
+    if constexpr (std::is_convertible_v<T&&, std::string_view>) {
+      const std::string_view text{std::forward<T>(value)};
+      set_data__(index, text.data(), text.size(), Data_format::text);
+    } else
+      set_data(index, to_data(std::forward<T>(value)));
+  }
+
+  /// @overload
+  template<typename T>
+  void set_data(const std::string_view name, T&& value)
+  {
+    set_data(index_of(name), std::forward<T>(value));
+  }
+
+  /**
+   * @brief Appends the field to this composite.
+   *
+   * @param name See Compositional.
+   * @param data The data to copy, or `nullptr` to append NULL.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void append(const std::string_view name, const Data* const data)
+  {
+    if (data)
+      append__(name, static_cast<const char*>(data->bytes()), data->size(), data->format());
+    else
+      append__(name, nullptr, 0, Data_format::text);
+  }
+
+  /// @overload
+  void append(const std::string_view name, const Data_view& data)
+  {
+    append(name, data ? &data : nullptr);
+  }
+
+  /// @overload
+  void append(const std::string_view name, const std::unique_ptr<Data>& data)
+  {
+    append(name, data.get());
+  }
+
+  /**
+   * @overload
+   *
+   * @brief Appends the field with the value of type T, implicitly converted
+   * to the Data by using to_data().
+   *
+   * @remarks The values convertible to `std::string_view` are appended as
+   * the text data without creating the intermediate Data objects.
+   */
+  template<typename T>
+  std::enable_if_t<!detail::Is_flat_composite_data<T>::value> append(const std::string_view name, T&& value)
+  {
+    if constexpr (std::is_convertible_v<T&&, std::string_view>) {
+      const std::string_view text{std::forward<T>(value)};
+      append__(name, text.data(), text.size(), Data_format::text);
+    } else
+      append(name, to_data(std::forward<T>(value)));
+  }
+
+  /**
+   * @brief Removes field from this composite.
+   *
+   * @par Requires
+   * `(index < size())`.
+   */
+  void remove(const std::size_t index) noexcept
+  {
+    assert(index < size());
+    const auto& field = fields_[index];
+    garbage_size_ += field.name_size + 1 + stored_size(field.data_size);
+    fields_.erase(fields_.cbegin() + static_cast<std::ptrdiff_t>(index));
+    build_index(); // the indexes of the next fields are shifted
+    if (fields_.empty()) {
+      buffer_.clear();
+      garbage_size_ = 0;
+    }
+  }
+
+  /**
+   * @overload
+   *
+   * @param name See Compositional.
+   * @param offset See Compositional.
+   *
+   * @par Effects
+   * `!has_field(name, offset)`.
+   */
+  void remove(const std::string_view name, const std::size_t offset = 0) noexcept
+  {
+    if (const auto index = index_of(name, offset); index != size())
+      remove(index);
+  }
+
+  /// Removes all the fields without releasing the memory.
+  void clear() noexcept
+  {
+    buffer_.clear();
+    fields_.clear();
+    garbage_size_ = 0;
+    buckets_.clear();
+  }
+
+  /**
+   * @brief Reserves the memory to store `field_count` fields with names and
+   * data of total size `byte_count`.
+   */
+  void reserve(const std::size_t field_count, const std::size_t byte_count)
+  {
+    fields_.reserve(field_count);
+    buffer_.reserve(byte_count);
+  }
+
+private:
+  struct Field final {
+    std::size_t name_offset{};
+    std::size_t name_size{};
+    std::size_t data_offset{};
+    int data_size{-1}; // -1 if NULL
+    Data_format data_format{Data_format::text};
+  };
+
+  std::string buffer_; // null-terminated names and data
+  std::vector<Field> fields_;
+  std::size_t garbage_size_{}; // the size of unused bytes in buffer_
+  std::vector<std::uint32_t> buckets_; // index of field + 1, or 0 if empty
+
+  bool is_invariant_ok() const override
+  {
+    const bool garbage_ok = garbage_size_ <= buffer_.size();
+    return garbage_ok && Compositional::is_invariant_ok();
+  }
+
+  static std::size_t stored_size(const int data_size) noexcept
+  {
+    return data_size >= 0 ? static_cast<std::size_t>(data_size) + 1 : 0;
+  }
+
+  /// Appends the data (or NULL if `!bytes`) to the buffer.
+  void append_data__(Field& field, const char* const bytes, const std::size_t bytes_size,
+    const Data_format format)
+  {
+    field.data_offset = buffer_.size();
+    field.data_format = format;
+    if (bytes) {
+      if (bytes_size > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        throw std::runtime_error{"data is too large for Flat_composite"};
+      // The data is terminated by zero since Data_view calls strlen() for empty text.
+      buffer_.append(bytes, bytes_size).push_back('\0');
+      field.data_size = static_cast<int>(bytes_size);
+    } else
+      field.data_size = -1;
+  }
+
+  /*
+   * Reserves the buffer for `size` more bytes. Since the `name` and the
+   * `bytes` can point to the buffer itself (when the field of this instance
+   * is copied), they are updated to point to the reserved buffer.
+   */
+  void reserve_aliased__(const std::size_t size, std::string_view& name, const char*& bytes)
+  {
+    const auto offset_of = [this](const char* const ptr) -> std::optional<std::size_t>
+    {
+      const std::less<const char*> less;
+      const auto* const b = buffer_.data();
+      if (ptr && !less(ptr, b) && less(ptr, b + buffer_.size()))
+        return static_cast<std::size_t>(ptr - b);
+      else
+        return std::nullopt;
+    };
+    const auto name_offset = offset_of(name.data());
+    const auto bytes_offset = offset_of(bytes);
+    if (!name_offset && !bytes_offset)
+      return;
+
+    buffer_.reserve(buffer_.size() + size);
+    if (name_offset)
+      name = {buffer_.data() + *name_offset, name.size()};
+    if (bytes_offset)
+      bytes = buffer_.data() + *bytes_offset;
+  }
+
+  void append__(std::string_view name, const char* bytes,
+    const std::size_t bytes_size, const Data_format format)
+  {
+    const auto buffer_size = buffer_.size();
+    try {
+      reserve_aliased__(name.size() + 1 + (bytes ? bytes_size + 1 : 0), name, bytes);
+      Field field;
+      field.name_offset = buffer_size;
+      field.name_size = name.size();
+      buffer_.append(name).push_back('\0');
+      append_data__(field, bytes, bytes_size, format);
+      fields_.push_back(field);
+    } catch (...) {
+      buffer_.resize(buffer_size);
+      throw;
+    }
+    index_back();
+    assert(is_invariant_ok());
+  }
+
+  void set_data__(const std::size_t index, const char* bytes,
+    const std::size_t bytes_size, const Data_format format)
+  {
+    assert(index < size());
+    const auto buffer_size = buffer_.size();
+    auto field = fields_[index];
+    try {
+      std::string_view name;
+      reserve_aliased__(bytes ? bytes_size + 1 : 0, name, bytes);
+      append_data__(field, bytes, bytes_size, format);
+    } catch (...) {
+      buffer_.resize(buffer_size);
+      throw;
+    }
+    garbage_size_ += stored_size(fields_[index].data_size);
+    fields_[index] = field;
+    shrink_if_needed();
+  }
+
+  /// Removes the unused bytes from the buffer if they takes more than a half of it.
+  void shrink_if_needed() noexcept
+  try {
+    if (garbage_size_ < 256 || garbage_size_ < buffer_.size() / 2)
+      return;
+
+    std::string buffer;
+    buffer.reserve(buffer_.size() - garbage_size_);
+    for (auto& field : fields_) {
+      const auto name_offset = buffer.size();
+      buffer.append(buffer_, field.name_offset, field.name_size + 1);
+      field.name_offset = name_offset;
+      const auto data_offset = buffer.size();
+      buffer.append(buffer_, field.data_offset, stored_size(field.data_size));
+      field.data_offset = data_offset;
+    }
+    buffer_.swap(buffer);
+    garbage_size_ = 0;
+  } catch (...) {
+    // The buffer will be shrinked next time.
+  }
+
+  std::size_t bucket_of(const std::string_view name) const noexcept
+  {
+    return std::hash<std::string_view>{}(name) & (buckets_.size() - 1);
+  }
+
+  /// Adds the last field to the index, or rebuilds the index if it's too dense.
+  void index_back() noexcept
+  {
+    const auto sz = size();
+    if (sz < hash_threshold)
+      return;
+    else if (buckets_.size() < 2*sz)
+      return build_index();
+
+    const auto i = sz - 1;
+    const auto mask = buckets_.size() - 1;
+    for (auto b = bucket_of(name_of(i));; b = (b + 1) & mask) {
+      if (!buckets_[b])
+        buckets_[b] = static_cast<std::uint32_t>(i + 1);
+      else if (name_of(buckets_[b] - 1) != name_of(i))
+        continue;
+      break; // the first field of the name is indexed
+    }
+  }
+
+  /// Builds the index of the first fields of each name if there is enough memory.
+  void build_index() noexcept
+  try {
+    const auto sz = size();
+    if (sz < hash_threshold) {
+      buckets_.clear();
+      return;
+    }
+
+    std::size_t bucket_count{hash_threshold * 2};
+    while (bucket_count < 2*sz)
+      bucket_count *= 2;
+    buckets_.assign(bucket_count, 0);
+    for (auto i = sz; i--;) {
+      for (auto b = bucket_of(name_of(i));; b = (b + 1) & (bucket_count - 1)) {
+        if (!buckets_[b] || name_of(buckets_[b] - 1) == name_of(i)) {
+          buckets_[b] = static_cast<std::uint32_t>(i + 1);
+          break;
+        }
+      }
+    }
+  } catch (...) {
+    buckets_.clear(); // the fields will be scanned
+  }
+};
+
+/// Flat_composite is swappable.
+inline void swap(Flat_composite& lhs, Flat_composite& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace dmitigr::pgfe
+
+#endif  // DMITIGR_PGFE_FLAT_COMPOSITE_HPP
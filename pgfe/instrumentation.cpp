@@ -0,0 +1,192 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace dmitigr::pgfe {
+
+// -----------------------------------------------------------------------------
+// Latency_histogram
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE Latency_histogram::Latency_histogram()
+  : counts_(index_of(static_cast<std::uint64_t>(max_value().count())) + 1)
+{}
+
+DMITIGR_PGFE_INLINE void
+Latency_histogram::record(const std::chrono::nanoseconds value) noexcept
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  const auto us = std::clamp(duration_cast<microseconds>(value).count(),
+    microseconds::rep{}, max_value().count());
+  ++counts_[index_of(static_cast<std::uint64_t>(us))];
+  min_ = count_ ? std::min<std::int64_t>(min_, us) : us;
+  max_ = std::max<std::int64_t>(max_, us);
+  sum_ += static_cast<std::uint64_t>(us);
+  ++count_;
+}
+
+DMITIGR_PGFE_INLINE void Latency_histogram::merge(const Latency_histogram& other) noexcept
+{
+  if (!other.count_)
+    return;
+
+  assert(counts_.size() == other.counts_.size());
+  for (std::size_t i = 0; i < counts_.size(); ++i)
+    counts_[i] += other.counts_[i];
+  min_ = count_ ? std::min(min_, other.min_) : other.min_;
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+  count_ += other.count_;
+}
+
+DMITIGR_PGFE_INLINE void Latency_histogram::clear() noexcept
+{
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = sum_ = 0;
+  min_ = max_ = 0;
+}
+
+DMITIGR_PGFE_INLINE std::chrono::microseconds
+Latency_histogram::value_at_percentile(const double percentile) const noexcept
+{
+  assert(0 <= percentile && percentile <= 100);
+  if (!count_)
+    return {};
+
+  const auto rank = std::max<std::uint64_t>(1,
+    static_cast<std::uint64_t>(std::ceil(percentile / 100 * static_cast<double>(count_))));
+  std::uint64_t accumulated{};
+  for (std::size_t i = 0; i < counts_.size(); ++i) {
+    accumulated += counts_[i];
+    if (accumulated >= rank)
+      return std::chrono::microseconds{std::clamp(
+          static_cast<std::int64_t>(highest_value_of(i)), min_, max_)};
+  }
+  return max();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Latency_histogram::index_of(const std::uint64_t value) noexcept
+{
+  if (value < sub_bucket_count)
+    return static_cast<std::size_t>(value);
+
+  // The bucket is determined by the exponent, the sub-bucket - by the next bits.
+  unsigned exponent{};
+  for (auto v = value; v >>= 1;)
+    ++exponent;
+  const unsigned shift = exponent - precision;
+  const auto bucket = static_cast<std::size_t>(shift) + 1;
+  const auto sub_bucket = static_cast<std::size_t>(value >> shift) - sub_bucket_count;
+  return bucket * sub_bucket_count + sub_bucket;
+}
+
+DMITIGR_PGFE_INLINE std::uint64_t
+Latency_histogram::highest_value_of(const std::size_t index) noexcept
+{
+  if (index < sub_bucket_count)
+    return index;
+
+  const auto bucket = index / sub_bucket_count;
+  const auto sub_bucket = index % sub_bucket_count + sub_bucket_count;
+  const auto shift = static_cast<unsigned>(bucket - 1);
+  return ((static_cast<std::uint64_t>(sub_bucket) + 1) << shift) - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Statement_statistics
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE void Statement_statistics::on_send(const Connection&,
+  const Request_metrics& metrics, const std::string_view query)
+{
+  if (metrics.kind != Request_kind::execution)
+    return;
+
+  const auto key = key_of(metrics);
+  const std::lock_guard lg{mutex_};
+  if (const auto i = entries_.find(key); i == entries_.end()) {
+    auto& entry = entries_[key];
+    entry.query_hash = metrics.query_hash;
+    entry.statement_name = metrics.statement_name;
+    entry.query = query.substr(0, max_query_size);
+  } else if (i->second.query.empty() && !query.empty())
+    i->second.query = query.substr(0, max_query_size);
+}
+
+DMITIGR_PGFE_INLINE void Statement_statistics::on_complete(const Connection&,
+  const Request_metrics& metrics)
+{
+  if (metrics.kind != Request_kind::execution)
+    return;
+
+  const auto key = key_of(metrics);
+  const std::lock_guard lg{mutex_};
+  auto& entry = entries_[key];
+  if (!entry.latency.count()) {
+    entry.query_hash = metrics.query_hash;
+    entry.statement_name = metrics.statement_name;
+  }
+  entry.latency.record(metrics.latency());
+  entry.first_response_latency.record(metrics.first_response_latency());
+  entry.row_count += metrics.row_count;
+  entry.byte_count += metrics.byte_count;
+  if (metrics.is_failed()) {
+    ++entry.error_count;
+    entry.last_sqlstate = metrics.sqlstate;
+  }
+}
+
+DMITIGR_PGFE_INLINE auto Statement_statistics::entries() const -> std::vector<Entry>
+{
+  std::vector<Entry> result;
+  const std::lock_guard lg{mutex_};
+  result.reserve(entries_.size());
+  for (const auto& [key, entry] : entries_)
+    result.push_back(entry);
+  return result;
+}
+
+DMITIGR_PGFE_INLINE auto Statement_statistics::slowest(const std::size_t count,
+  const double percentile) const -> std::vector<Entry>
+{
+  assert(0 <= percentile && percentile <= 100);
+
+  std::vector<std::pair<std::chrono::microseconds, const Entry*>> latencies;
+  std::vector<Entry> result;
+  const std::lock_guard lg{mutex_};
+  latencies.reserve(entries_.size());
+  for (const auto& [key, entry] : entries_)
+    latencies.emplace_back(entry.latency.value_at_percentile(percentile), &entry);
+  const auto size = std::min(count, latencies.size());
+  std::partial_sort(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(size),
+    latencies.end(), [](const auto& lhs, const auto& rhs)
+    {
+      return lhs.first > rhs.first;
+    });
+  result.reserve(size);
+  for (std::size_t i = 0; i < size; ++i)
+    result.push_back(*latencies[i].second);
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Statement_statistics::clear() noexcept
+{
+  const std::lock_guard lg{mutex_};
+  entries_.clear();
+}
+
+DMITIGR_PGFE_INLINE std::uint64_t
+Statement_statistics::key_of(const Request_metrics& metrics) noexcept
+{
+  return metrics.query_hash ? metrics.query_hash :
+    query_hash(metrics.statement_name) ^ 1;
+}
+
+} // namespace dmitigr::pgfe
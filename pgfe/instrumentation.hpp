@@ -0,0 +1,348 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_INSTRUMENTATION_HPP
+#define DMITIGR_PGFE_INSTRUMENTATION_HPP
+
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @returns The 64-bit FNV-1a hash of the `query`.
+ */
+constexpr std::uint64_t query_hash(const std::string_view query) noexcept
+{
+  std::uint64_t result{14695981039346656037ULL};
+  for (const char c : query) {
+    result ^= static_cast<unsigned char>(c);
+    result *= 1099511628211ULL;
+  }
+  return result;
+}
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A kind of the request.
+ */
+enum class Request_kind {
+  /// The execution of the statement.
+  execution,
+
+  /// The preparation of the statement.
+  preparation,
+
+  /// The description of the prepared statement.
+  description,
+
+  /// The deallocation of the prepared statement.
+  deallocation,
+
+  /// The synchronization point of the pipeline.
+  synchronization
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief The metrics of the request collected by the Connection with the
+ * instrument set.
+ *
+ * @see Instrument, Connection::set_instrument().
+ */
+struct Request_metrics final {
+  /// The clock of the time points.
+  using Clock = std::chrono::steady_clock;
+
+  /// The kind of the request.
+  Request_kind kind{};
+
+  /**
+   * The hash of the query text (see query_hash()), or `0` if the text is
+   * unknown (i.e. for the prepared statement described rather than prepared).
+   */
+  std::uint64_t query_hash{};
+
+  /// The name of the prepared statement. (Empty for the unnamed statement.)
+  std::string statement_name;
+
+  /// The time point when the request was sent.
+  Clock::time_point sent_at;
+
+  /// The time point when the first response was received.
+  std::optional<Clock::time_point> first_response_at;
+
+  /// The time point when the request was completed.
+  std::optional<Clock::time_point> completed_at;
+
+  /// The number of the results received.
+  std::size_t result_count{};
+
+  /// The number of the rows received.
+  std::size_t row_count{};
+
+  /// The number of the bytes of the row data received.
+  std::size_t byte_count{};
+
+  /// The SQLSTATE of the error. (Empty on success.)
+  std::string sqlstate;
+
+  /// `true` if the request has been aborted in pipeline mode.
+  bool is_aborted{};
+
+  /// @returns The time elapsed from sending to the completion.
+  std::chrono::nanoseconds latency() const noexcept
+  {
+    return completed_at ? *completed_at - sent_at : std::chrono::nanoseconds{};
+  }
+
+  /// @returns The time elapsed from sending to the first response.
+  std::chrono::nanoseconds first_response_latency() const noexcept
+  {
+    return first_response_at ? *first_response_at - sent_at : std::chrono::nanoseconds{};
+  }
+
+  /// @returns `true` if the request is failed.
+  bool is_failed() const noexcept
+  {
+    return !sqlstate.empty() || is_aborted;
+  }
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief An observer of the requests of the connections.
+ *
+ * The functions are called by the Connection from the thread which uses it.
+ * The instance can be shared by the multiple connections which are used by
+ * the multiple threads, so the implementations must be thread-safe in this
+ * case. The exceptions thrown by the functions are reported to the standard
+ * error and are not propagated.
+ *
+ * @see Connection::set_instrument().
+ */
+class Instrument {
+public:
+  /// The destructor.
+  virtual ~Instrument() = default;
+
+  /**
+   * @brief Called just after the request has been sent.
+   *
+   * @param query The query text, or empty if it's unknown.
+   */
+  virtual void on_send(const Connection&, const Request_metrics&,
+    std::string_view /*query*/)
+  {}
+
+  /// Called when the first response to the request has been received.
+  virtual void on_first_response(const Connection&, const Request_metrics&)
+  {}
+
+  /// Called when the rows (or the chunk of rows) has been received.
+  virtual void on_result(const Connection&, const Request_metrics&)
+  {}
+
+  /**
+   * @brief Called when the request has been completed.
+   *
+   * @remarks It's not called for the synchronization points.
+   */
+  virtual void on_complete(const Connection&, const Request_metrics&)
+  {}
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A histogram of the latencies with the logarithmic buckets linearly
+ * subdivided (similar to the HDR histogram).
+ *
+ * The values are recorded with the resolution of 1 microsecond and with the
+ * relative error not exceeding `1 / sub_bucket_count`. The values greater
+ * than `max_value()` are recorded as `max_value()`.
+ *
+ * @remarks Functions of this class are not thread-safe.
+ */
+class Latency_histogram final {
+public:
+  /// The number of significant bits of the recorded values.
+  static constexpr unsigned precision{5};
+
+  /// The number of the linear subdivisions of each power of 2.
+  static constexpr std::size_t sub_bucket_count{std::size_t{1} << precision};
+
+  /// The maximum exponent of the recorded values.
+  static constexpr unsigned max_exponent{40};
+
+  /// The default constructor.
+  DMITIGR_PGFE_API Latency_histogram();
+
+  /// @returns The maximum value which can be recorded exactly (about 12 days).
+  static constexpr std::chrono::microseconds max_value() noexcept
+  {
+    return std::chrono::microseconds{(std::int64_t{1} << max_exponent) - 1};
+  }
+
+  /// Records the `value`.
+  DMITIGR_PGFE_API void record(std::chrono::nanoseconds value) noexcept;
+
+  /// Adds all of the values recorded by `other`.
+  DMITIGR_PGFE_API void merge(const Latency_histogram& other) noexcept;
+
+  /// Removes all of the recorded values.
+  DMITIGR_PGFE_API void clear() noexcept;
+
+  /// @returns The number of recorded values.
+  std::uint64_t count() const noexcept
+  {
+    return count_;
+  }
+
+  /// @returns The minimum recorded value.
+  std::chrono::microseconds min() const noexcept
+  {
+    return std::chrono::microseconds{count_ ? min_ : 0};
+  }
+
+  /// @returns The maximum recorded value.
+  std::chrono::microseconds max() const noexcept
+  {
+    return std::chrono::microseconds{max_};
+  }
+
+  /// @returns The mean of recorded values.
+  std::chrono::microseconds mean() const noexcept
+  {
+    return std::chrono::microseconds{count_ ?
+      static_cast<std::int64_t>(sum_ / count_) : 0};
+  }
+
+  /**
+   * @returns The value not exceeded by the `percentile` of recorded values.
+   *
+   * @par Requires
+   * `(0 <= percentile && percentile <= 100)`.
+   */
+  DMITIGR_PGFE_API std::chrono::microseconds
+  value_at_percentile(double percentile) const noexcept;
+
+private:
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t count_{};
+  std::uint64_t sum_{};
+  std::int64_t min_{};
+  std::int64_t max_{};
+
+  static std::size_t index_of(std::uint64_t value) noexcept;
+  static std::uint64_t highest_value_of(std::size_t index) noexcept;
+};
+
+/**
+ * @ingroup utilities
+ *
+ * @brief The instrument which collects the statistics per statement.
+ *
+ * The statements are identified by the hash of the query text, or by the
+ * name of the prepared statement if the text is unknown. Only the executions
+ * are accounted.
+ *
+ * @par Example
+ * @code
+ * auto stats = std::make_shared<Statement_statistics>();
+ * conn.set_instrument(stats);
+ * // ...
+ * for (const auto& s : stats->slowest(10))
+ *   std::cout << s.latency.value_at_percentile(99).count() << " " << s.query << std::endl;
+ * @endcode
+ *
+ * @remarks Functions of this class are thread-safe.
+ */
+class Statement_statistics final : public Instrument {
+public:
+  /// The maximum size of the stored query text.
+  static constexpr std::size_t max_query_size{1024};
+
+  /// The statistics of the statement.
+  struct Entry final {
+    /// The hash of the query text (or `0`).
+    std::uint64_t query_hash{};
+
+    /// The name of the prepared statement.
+    std::string statement_name;
+
+    /// The query text (truncated to `max_query_size`).
+    std::string query;
+
+    /// The latencies of the executions.
+    Latency_histogram latency;
+
+    /// The latencies of the first responses.
+    Latency_histogram first_response_latency;
+
+    /// The total number of the rows received.
+    std::uint64_t row_count{};
+
+    /// The total number of the bytes of the row data received.
+    std::uint64_t byte_count{};
+
+    /// The number of the failed executions.
+    std::uint64_t error_count{};
+
+    /// The SQLSTATE of the last failed execution.
+    std::string last_sqlstate;
+  };
+
+  /// @see Instrument::on_send().
+  DMITIGR_PGFE_API void on_send(const Connection&, const Request_metrics& metrics,
+    std::string_view query) override;
+
+  /// @see Instrument::on_complete().
+  DMITIGR_PGFE_API void on_complete(const Connection&, const Request_metrics& metrics) override;
+
+  /// @returns The copy of statistics of all of the statements.
+  DMITIGR_PGFE_API std::vector<Entry> entries() const;
+
+  /**
+   * @returns The copy of statistics of at most `count` statements having the
+   * largest latency at the `percentile`, in descending order of the latency.
+   *
+   * @par Requires
+   * `(0 <= percentile && percentile <= 100)`.
+   */
+  DMITIGR_PGFE_API std::vector<Entry> slowest(std::size_t count,
+    double percentile = 99) const;
+
+  /// Removes all of the statistics.
+  DMITIGR_PGFE_API void clear() noexcept;
+
+private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::uint64_t, Entry> entries_;
+
+  static std::uint64_t key_of(const Request_metrics& metrics) noexcept;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifdef DMITIGR_PGFE_HEADER_ONLY
+#include "instrumentation.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_INSTRUMENTATION_HPP
@@ -4,10 +4,21 @@
 
 #include "connection.hpp"
 #include "large_object.hpp"
+#include "../net/descriptor.hpp"
 
 #include <libpq-fe.h>
 
+#include <cerrno>
+#include <cstring>
 #include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace dmitigr::pgfe {
 
@@ -82,18 +93,342 @@ DMITIGR_PGFE_INLINE bool Large_object::truncate(const std::int_fast64_t new_size
   return conn_->truncate(*this, new_size);
 }
 
-int Large_object::read(char* const buf, const std::size_t size) noexcept
+DMITIGR_PGFE_INLINE int Large_object::read(char* const buf, const std::size_t size) noexcept
 {
   assert(is_valid());
   assert(buf && size <= std::numeric_limits<int>::max());
   return conn_->read(*this, buf, size);
 }
 
-int Large_object::write(const char* const buf, const std::size_t size) noexcept
+DMITIGR_PGFE_INLINE int Large_object::write(const char* const buf, const std::size_t size) noexcept
 {
   assert(is_valid());
   assert(buf && size <= std::numeric_limits<int>::max());
   return conn_->write(*this, buf, size);
 }
 
+DMITIGR_PGFE_INLINE std::size_t Large_object::read(char* const buf,
+  const std::size_t chunk_size, const std::size_t chunk_count)
+{
+  assert(is_valid());
+  assert(buf);
+  assert(chunk_size && chunk_size <= std::numeric_limits<int>::max());
+  assert(chunk_count && chunk_count <= std::numeric_limits<int>::max());
+  assert(conn_->is_ready_for_request());
+
+  // The single chunk is read by using the fast-path interface.
+  if (chunk_count == 1) {
+    const int result = read(buf, chunk_size);
+    if (result < 0)
+      throw std::runtime_error{"cannot read large object"};
+    return static_cast<std::size_t>(result);
+  }
+
+  /*
+   * The fast-path interface cannot be used to request several chunks at once,
+   * so the chunks are requested by the single query. The chunks are retrieved
+   * in binary format to avoid the bytea encoding overhead.
+   */
+  const auto result_format = conn_->result_format();
+  conn_->set_result_format(Data_format::binary);
+  std::size_t result{};
+  try {
+    bool is_end{};
+    conn_->execute([buf, chunk_size, &result, &is_end](auto&& row)
+    {
+      if (is_end)
+        return;
+
+      const auto data = row[0];
+      assert(data && data.size() <= chunk_size);
+      std::memcpy(buf + result, data.bytes(), data.size());
+      result += data.size();
+      is_end = data.size() < chunk_size;
+    }, "select pg_catalog.loread($1::integer, $2::integer)"
+    " from pg_catalog.generate_series(1, $3::integer)",
+      desc_, static_cast<int>(chunk_size), static_cast<int>(chunk_count));
+  } catch (...) {
+    conn_->set_result_format(result_format);
+    throw;
+  }
+  conn_->set_result_format(result_format);
+  return result;
+}
+
+template<class F>
+std::int_fast64_t Large_object::read_to__(F&& sink,
+  const std::size_t chunk_size, const std::size_t read_ahead)
+{
+  assert(chunk_size && chunk_size <= std::numeric_limits<int>::max());
+  assert(read_ahead && read_ahead <= std::numeric_limits<int>::max());
+
+  const std::size_t buffer_size{chunk_size * read_ahead};
+  std::unique_ptr<char[]> buffer{new char[buffer_size]};
+  std::int_fast64_t result{};
+  while (true) {
+    const auto size = read(buffer.get(), chunk_size, read_ahead);
+    if (size)
+      sink(buffer.get(), size);
+    result += static_cast<std::int_fast64_t>(size);
+    if (size < buffer_size)
+      return result;
+  }
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t Large_object::read_to(net::Descriptor& dst,
+  const std::size_t chunk_size, const std::size_t read_ahead)
+{
+  return read_to__([&dst](const char* buf, std::size_t size)
+  {
+    while (size) {
+      const auto max_size = static_cast<std::size_t>(dst.max_write_size());
+      const auto n = dst.write(buf, static_cast<std::streamsize>(std::min(size, max_size)));
+      assert(n > 0);
+      buf += n;
+      size -= static_cast<std::size_t>(n);
+    }
+  }, chunk_size, read_ahead);
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t Large_object::read_to(const int fd,
+  const std::size_t chunk_size, const std::size_t read_ahead)
+{
+  return read_to__([fd](const char* buf, std::size_t size)
+  {
+    while (size) {
+#ifdef _WIN32
+      const auto n = ::_write(fd, buf, static_cast<unsigned>(size));
+#else
+      const auto n = ::write(fd, buf, size);
+#endif
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::system_error{errno, std::system_category()};
+      }
+      buf += n;
+      size -= static_cast<std::size_t>(n);
+    }
+  }, chunk_size, read_ahead);
+}
+
+template<class F>
+std::int_fast64_t Large_object::write_from__(F&& source,
+  const std::size_t chunk_size, const std::size_t write_window)
+{
+  assert(is_valid());
+  assert(chunk_size && chunk_size <= std::numeric_limits<int>::max());
+  assert(write_window);
+  assert(conn_->is_ready_for_request());
+
+  const Sql_string statement{"select pg_catalog.lowrite(:fd, :data)"};
+  std::unique_ptr<char[]> buffer{new char[chunk_size]};
+  std::int_fast64_t result{};
+  std::int_fast64_t written{};
+  std::size_t uncompleted_count{};
+  Error error;
+  const auto process_response = [this, &written, &uncompleted_count, &error]
+  {
+    assert(uncompleted_count);
+    conn_->process_responses([&written, &error](auto&& row, auto&& err)
+    {
+      if (!err)
+        written += to<int>(row[0]);
+      else if (!error)
+        error = std::move(err);
+    });
+    --uncompleted_count;
+  };
+  const auto complete = [this, &process_response, &uncompleted_count]
+  {
+    conn_->send_sync();
+    while (uncompleted_count)
+      process_response();
+    conn_->process_responses(ignore_row); // sync
+    conn_->set_pipeline_enabled(false);
+  };
+
+  /*
+   * Each chunk is sent as soon as it's read from the source. The responses
+   * are processed only when the window is full, so the chunks are written
+   * without waiting for the round trips.
+   */
+  conn_->set_pipeline_enabled(true);
+  try {
+    while (!error) {
+      const std::size_t size = source(buffer.get(), chunk_size);
+      if (!size)
+        break;
+
+      const Data_view data{buffer.get(), static_cast<int>(size), Data_format::binary};
+      conn_->execute_nio(statement, a{"fd", desc_}, a{"data", &data});
+      conn_->send_flush();
+      ++uncompleted_count;
+      result += static_cast<std::int_fast64_t>(size);
+
+      if (uncompleted_count == write_window)
+        process_response();
+    }
+    complete();
+  } catch (...) {
+    try {
+      if (conn_->pipeline_status() != Pipeline_status::disabled)
+        complete();
+    } catch (...) {}
+    throw;
+  }
+
+  if (error)
+    throw Server_exception{std::make_shared<Error>(std::move(error))};
+  else if (written != result)
+    throw std::runtime_error{"cannot write large object"};
+
+  return result;
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t Large_object::write_from(net::Descriptor& src,
+  const std::size_t chunk_size, const std::size_t write_window)
+{
+  return write_from__([&src](char* const buf, const std::size_t size)
+  {
+    const auto max_size = static_cast<std::size_t>(src.max_read_size());
+    const auto n = src.read(buf, static_cast<std::streamsize>(std::min(size, max_size)));
+    assert(n >= 0);
+    return static_cast<std::size_t>(n);
+  }, chunk_size, write_window);
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t Large_object::write_from(const int fd,
+  const std::size_t chunk_size, const std::size_t write_window)
+{
+  return write_from__([fd](char* const buf, const std::size_t size)
+  {
+    while (true) {
+#ifdef _WIN32
+      const auto n = ::_read(fd, buf, static_cast<unsigned>(size));
+#else
+      const auto n = ::read(fd, buf, size);
+#endif
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::system_error{errno, std::system_category()};
+      }
+      return static_cast<std::size_t>(n);
+    }
+  }, chunk_size, write_window);
+}
+
+// -----------------------------------------------------------------------------
+// Large_object_streambuf
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::~Large_object_streambuf()
+{
+  try {
+    sync();
+  } catch (...) {}
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::Large_object_streambuf(Large_object& lob,
+  const std::size_t chunk_size, const std::size_t read_ahead)
+  : lob_{lob}
+  , chunk_size_{chunk_size}
+  , read_ahead_{read_ahead}
+  , buffer_{new char[chunk_size * read_ahead]}
+{
+  assert(lob_.is_valid());
+  assert(chunk_size_ && chunk_size_ <= std::numeric_limits<int>::max());
+  assert(read_ahead_ && read_ahead_ <= std::numeric_limits<int>::max());
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::int_type
+Large_object_streambuf::underflow()
+{
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+  else if (sync())
+    return traits_type::eof();
+
+  // The buffer is shared, so the put area must be disabled while reading.
+  setp(nullptr, nullptr);
+  char* const buf = buffer_.get();
+  const auto size = lob_.read(buf, chunk_size_, read_ahead_);
+  setg(buf, buf, buf + size);
+  assert(is_invariant_ok());
+  return size ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::int_type
+Large_object_streambuf::overflow(const int_type ch)
+{
+  // Both flush the put area and discard the get area (if any).
+  if (sync())
+    return traits_type::eof();
+
+  char* const buf = buffer_.get();
+  setp(buf, buf + chunk_size_);
+
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  assert(is_invariant_ok());
+  return traits_type::not_eof(ch);
+}
+
+DMITIGR_PGFE_INLINE int Large_object_streambuf::sync()
+{
+  // Write the data of the put area.
+  if (const auto size = pptr() - pbase(); size > 0) {
+    if (lob_.write(pbase(), static_cast<std::size_t>(size)) != size)
+      return -1;
+    setp(pbase(), epptr());
+  }
+
+  // Discard the get area, restoring the actual position of the large object.
+  if (const auto size = egptr() - gptr(); size > 0) {
+    if (lob_.seek(-size, Large_object_seek_whence::current) < 0)
+      return -1;
+  }
+  setg(nullptr, nullptr, nullptr);
+
+  assert(is_invariant_ok());
+  return 0;
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::pos_type
+Large_object_streambuf::seekoff(const off_type off,
+  const std::ios_base::seekdir dir, const std::ios_base::openmode)
+{
+  // Avoid discarding the buffers when just telling the position.
+  if (!off && dir == std::ios_base::cur) {
+    const auto pos = lob_.tell();
+    return pos < 0 ? pos_type(off_type(-1)) :
+      pos_type(pos - (egptr() - gptr()) + (pptr() - pbase()));
+  } else if (sync())
+    return pos_type(off_type(-1));
+
+  const auto whence = dir == std::ios_base::beg ? Large_object_seek_whence::begin :
+    dir == std::ios_base::cur ? Large_object_seek_whence::current :
+    Large_object_seek_whence::end;
+  const auto pos = lob_.seek(off, whence);
+  return pos < 0 ? pos_type(off_type(-1)) : pos_type(pos);
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::pos_type
+Large_object_streambuf::seekpos(const pos_type pos,
+  const std::ios_base::openmode which)
+{
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+DMITIGR_PGFE_INLINE bool Large_object_streambuf::is_invariant_ok() const noexcept
+{
+  // Only one of the areas can be non-empty at time.
+  return lob_.is_valid() && chunk_size_ && read_ahead_ && buffer_ &&
+    (gptr() == egptr() || pptr() == pbase());
+}
+
 } // namespace dmitigr::pgfe
@@ -8,9 +8,12 @@
 #include "basics.hpp"
 #include "dll.hpp"
 #include "types_fwd.hpp"
+#include "../net/types_fwd.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <streambuf>
 
 namespace dmitigr {
 namespace pgfe {
@@ -89,6 +92,15 @@ public:
   /// An alias of Large_object_seek_whence.
   using Seek_whence = Large_object_seek_whence;
 
+  /// The default size of chunk of the chunked transfers.
+  static constexpr std::size_t default_chunk_size{1024 * 1024};
+
+  /// The default number of chunks requested per round trip.
+  static constexpr std::size_t default_read_ahead{8};
+
+  /// The default number of chunks written without waiting for the responses.
+  static constexpr std::size_t default_write_window{8};
+
   /**
    * @brief The destructor.
    *
@@ -182,6 +194,95 @@ public:
    */
   DMITIGR_PGFE_API int write(const char* buf, std::size_t size) noexcept;
 
+  /**
+   * @brief Reads up to `chunk_count` chunks of `chunk_size` bytes each from
+   * the current position associated with the underlying large object
+   * descriptor into `buf` by using a single round trip.
+   *
+   * @returns The number of bytes read. The value less than
+   * `chunk_size * chunk_count` indicates the end of the large object.
+   *
+   * @par Requires
+   * `(buf && chunk_size && chunk_size <= std::numeric_limits<int>::max() &&
+   * chunk_count && chunk_count <= std::numeric_limits<int>::max() &&
+   * connection()->is_ready_for_request())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @remarks The behavior is undefined if the actual size of `buf` is less
+   * than `chunk_size * chunk_count`.
+   */
+  DMITIGR_PGFE_API std::size_t read(char* buf, std::size_t chunk_size,
+    std::size_t chunk_count);
+
+  /**
+   * @brief Reads the large object from the current position associated with
+   * the underlying large object descriptor up to the end, and writes the data
+   * read to `dst`.
+   *
+   * @param dst The destination to write the data to.
+   * @param chunk_size The size of the chunk to read at once.
+   * @param read_ahead The number of chunks requested per round trip.
+   *
+   * @returns The number of bytes transferred.
+   *
+   * @par Requires
+   * `(chunk_size && chunk_size <= std::numeric_limits<int>::max() &&
+   * read_ahead && read_ahead <= std::numeric_limits<int>::max() &&
+   * connection()->is_ready_for_request())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API std::int_fast64_t read_to(net::Descriptor& dst,
+    std::size_t chunk_size = default_chunk_size,
+    std::size_t read_ahead = default_read_ahead);
+
+  /**
+   * @overload
+   *
+   * @param fd The file descriptor to write the data to.
+   */
+  DMITIGR_PGFE_API std::int_fast64_t read_to(int fd,
+    std::size_t chunk_size = default_chunk_size,
+    std::size_t read_ahead = default_read_ahead);
+
+  /**
+   * @brief Writes the data read from `src` up to the end to the large object
+   * from the current position associated with the underlying large object
+   * descriptor.
+   *
+   * The chunks are written in pipeline mode, so up to `write_window` chunks
+   * are on the wire without waiting for the responses.
+   *
+   * @param src The source to read the data from.
+   * @param chunk_size The size of the chunk to write at once.
+   * @param write_window The maximum number of the chunks sent without waiting
+   * for the responses.
+   *
+   * @returns The number of bytes transferred.
+   *
+   * @par Requires
+   * `(chunk_size && chunk_size <= std::numeric_limits<int>::max() &&
+   * write_window && connection()->is_ready_for_request())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API std::int_fast64_t write_from(net::Descriptor& src,
+    std::size_t chunk_size = default_chunk_size,
+    std::size_t write_window = default_write_window);
+
+  /**
+   * @overload
+   *
+   * @param fd The file descriptor to read the data from.
+   */
+  DMITIGR_PGFE_API std::int_fast64_t write_from(int fd,
+    std::size_t chunk_size = default_chunk_size,
+    std::size_t write_window = default_write_window);
+
   /// @returns The underlying connection instance.
   Connection* connection() const noexcept
   {
@@ -197,6 +298,12 @@ public:
 private:
   Connection* conn_{};
   int desc_{-1};
+
+  template<class F>
+  std::int_fast64_t read_to__(F&& sink, std::size_t chunk_size, std::size_t read_ahead);
+
+  template<class F>
+  std::int_fast64_t write_from__(F&& source, std::size_t chunk_size, std::size_t write_window);
 };
 
 /// Large_object is swappable.
@@ -205,6 +312,95 @@ inline void swap(Large_object& lhs, Large_object& rhs) noexcept
   lhs.swap(rhs);
 }
 
+/**
+ * @ingroup lob
+ *
+ * @brief A stream buffer to access a large object by using the standard
+ * streams.
+ *
+ * The reads are performed by chunks, optionally requesting several chunks per
+ * round trip (see Large_object::read(char*, std::size_t, std::size_t)). The
+ * writes are buffered up to the chunk size.
+ *
+ * @par Example
+ * @code
+ * auto lob = conn.open_large_object(oid, Large_object_open_mode::reading);
+ * Large_object_streambuf buf{lob};
+ * std::istream in{&buf};
+ * std::string line;
+ * while (std::getline(in, line))
+ *   std::cout << line << std::endl;
+ * @endcode
+ *
+ * @warning The behaivor is undefined if the underlying large object is
+ * accessed directly while the instance of this class is in use.
+ */
+class Large_object_streambuf final : public std::streambuf {
+public:
+  /**
+   * @brief The destructor.
+   *
+   * Writes the buffered data (if any).
+   */
+  DMITIGR_PGFE_API ~Large_object_streambuf() override;
+
+  /**
+   * @brief The constructor.
+   *
+   * @param lob The large object to access.
+   * @param chunk_size The size of the chunk to read or write at once.
+   * @param read_ahead The number of chunks requested per round trip.
+   *
+   * @par Requires
+   * `(lob.is_valid() && chunk_size &&
+   * chunk_size <= std::numeric_limits<int>::max() &&
+   * read_ahead && read_ahead <= std::numeric_limits<int>::max())`.
+   *
+   * @remarks The value of `read_ahead` greater than `1` requires the
+   * underlying connection to be ready for request upon each refill.
+   */
+  explicit DMITIGR_PGFE_API Large_object_streambuf(Large_object& lob,
+    std::size_t chunk_size = 64 * 1024, std::size_t read_ahead = 1);
+
+  /// Non copy-constructible.
+  Large_object_streambuf(const Large_object_streambuf&) = delete;
+
+  /// Non copy-assignable.
+  Large_object_streambuf& operator=(const Large_object_streambuf&) = delete;
+
+  /// @returns The underlying large object.
+  Large_object& large_object() const noexcept
+  {
+    return lob_;
+  }
+
+protected:
+  /// @see std::streambuf::underflow().
+  DMITIGR_PGFE_API int_type underflow() override;
+
+  /// @see std::streambuf::overflow().
+  DMITIGR_PGFE_API int_type overflow(int_type ch) override;
+
+  /// @see std::streambuf::sync().
+  DMITIGR_PGFE_API int sync() override;
+
+  /// @see std::streambuf::seekoff().
+  DMITIGR_PGFE_API pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+    std::ios_base::openmode which) override;
+
+  /// @see std::streambuf::seekpos().
+  DMITIGR_PGFE_API pos_type seekpos(pos_type pos,
+    std::ios_base::openmode which) override;
+
+private:
+  Large_object& lob_;
+  std::size_t chunk_size_{};
+  std::size_t read_ahead_{};
+  std::unique_ptr<char[]> buffer_;
+
+  bool is_invariant_ok() const noexcept;
+};
+
 } // namespace pgfe
 } // namespace dmitigr
 
@@ -0,0 +1,255 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "notification_hub.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dmitigr::pgfe {
+
+// -----------------------------------------------------------------------------
+// Subscription
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE Notification_hub::Subscription::Subscription(
+  std::string channel_name, const std::size_t capacity)
+  : channel_name_{std::move(channel_name)}
+{
+  assert(capacity);
+  std::size_t size{1};
+  while (size < capacity)
+    size <<= 1;
+  slots_.reset(new Notification_ptr[size]);
+  mask_ = size - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Notification_hub
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE Notification_hub::~Notification_hub()
+{
+  const std::lock_guard lg{mutex_};
+  for (auto& [name, channel] : channels_) {
+    for (auto& subscription : channel.subscriptions)
+      subscription->is_subscribed_.store(false, std::memory_order_release);
+  }
+}
+
+DMITIGR_PGFE_INLINE Notification_hub::Notification_hub(Connection_options options)
+  : connection_{std::move(options)}
+{}
+
+DMITIGR_PGFE_INLINE std::shared_ptr<Notification_hub::Subscription>
+Notification_hub::subscribe(std::string channel_name, const std::size_t capacity)
+{
+  assert(!channel_name.empty());
+  assert(capacity);
+  std::shared_ptr<Subscription> result{new Subscription{channel_name, capacity}};
+  const std::lock_guard lg{mutex_};
+  auto& channel = channels_[std::move(channel_name)];
+  channel.subscriptions.push_back(result);
+  if (!channel.is_listening)
+    is_sync_needed_ = true;
+  return result;
+}
+
+DMITIGR_PGFE_INLINE bool Notification_hub::unsubscribe(Subscription& subscription) noexcept
+{
+  const std::lock_guard lg{mutex_};
+  const auto c = channels_.find(subscription.channel_name_);
+  if (c == channels_.end())
+    return false;
+
+  auto& subscriptions = c->second.subscriptions;
+  const auto s = std::find_if(subscriptions.begin(), subscriptions.end(),
+    [&subscription](const auto& sub){ return sub.get() == &subscription; });
+  if (s == subscriptions.end())
+    return false;
+
+  subscription.is_subscribed_.store(false, std::memory_order_release);
+  subscriptions.erase(s);
+  if (subscriptions.empty())
+    is_sync_needed_ = true;
+  return true;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Notification_hub::subscription_count() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  std::size_t result{};
+  for (const auto& [name, channel] : channels_)
+    result += channel.subscriptions.size();
+  return result;
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Notification_hub::run_once(const std::optional<std::chrono::milliseconds> timeout)
+{
+  assert(!timeout || timeout->count() >= 0);
+
+  if (!connection_.is_connected())
+    connect__();
+
+  sync_channels__();
+
+  // The notifications could be received while synchronizing the channels.
+  dispatch__();
+  if (!batch_.empty())
+    return batch_.size();
+
+  try {
+    if (connection_.wait_socket_readiness(Socket_readiness::read_ready, timeout)
+      == Socket_readiness::unready)
+      return 0;
+    connection_.read_input();
+  } catch (...) {
+    // The connection will be re-established by the next call.
+    if (!connection_.is_connected())
+      return 0;
+    throw;
+  }
+
+  dispatch__();
+  return batch_.size();
+}
+
+DMITIGR_PGFE_INLINE void Notification_hub::connect__()
+{
+  connection_.disconnect();
+  connection_.connect();
+
+  const std::lock_guard lg{mutex_};
+  for (auto& [name, channel] : channels_) {
+    channel.is_listening = false;
+    if (was_connected_) {
+      for (auto& subscription : channel.subscriptions)
+        subscription->is_missed_.store(true, std::memory_order_release);
+    }
+  }
+  if (was_connected_)
+    ++reconnect_count_;
+  was_connected_ = true;
+  is_sync_needed_ = true;
+}
+
+DMITIGR_PGFE_INLINE void Notification_hub::sync_channels__()
+{
+  assert(connection_.is_connected());
+  assert(connection_.is_ready_for_request());
+
+  /*
+   * The mutex is not held while communicating with the server in order to
+   * not block subscribe() and unsubscribe() for the round trip. The iterators
+   * of the changed channels remain valid while unlocked since the channels are
+   * erased only by this method (which is called by the thread of run_once()).
+   */
+  while (true) {
+    // The channels which must be LISTENed (true) or UNLISTENed (false).
+    std::vector<std::pair<decltype(channels_)::iterator, bool>> changed;
+    {
+      const std::lock_guard lg{mutex_};
+      if (!is_sync_needed_)
+        return;
+
+      for (auto c = channels_.begin(); c != channels_.end();) {
+        if (!c->second.is_listening && c->second.subscriptions.empty())
+          c = channels_.erase(c);
+        else {
+          if (c->second.is_listening == c->second.subscriptions.empty())
+            changed.emplace_back(c, !c->second.is_listening);
+          ++c;
+        }
+      }
+      is_sync_needed_ = false;
+    }
+    if (changed.empty())
+      continue;
+
+    // All the changes are sent at once to avoid the round trip per channel.
+    try {
+      std::size_t uncompleted_count{};
+      Error error;
+      const auto process_response = [this, &uncompleted_count, &error]
+      {
+        assert(uncompleted_count);
+        connection_.process_responses([&error](auto&&, auto&& err)
+        {
+          if (err && !error)
+            error = std::move(err);
+        });
+        --uncompleted_count;
+      };
+      const auto complete = [this, &process_response, &uncompleted_count]
+      {
+        connection_.send_sync();
+        while (uncompleted_count)
+          process_response();
+        connection_.process_responses(ignore_row); // sync
+        connection_.set_pipeline_enabled(false);
+      };
+
+      connection_.set_pipeline_enabled(true);
+      try {
+        for (const auto& [c, is_listen] : changed) {
+          connection_.execute_nio((is_listen ? "listen " : "unlisten ")
+            + connection_.to_quoted_identifier(c->first));
+          ++uncompleted_count;
+        }
+        complete();
+      } catch (...) {
+        try {
+          if (connection_.is_connected() &&
+            connection_.pipeline_status() != Pipeline_status::disabled)
+            complete();
+        } catch (...) {}
+        throw;
+      }
+
+      if (error)
+        throw Server_exception{std::make_shared<Error>(std::move(error))};
+    } catch (...) {
+      const std::lock_guard lg{mutex_};
+      is_sync_needed_ = true;
+      throw;
+    }
+
+    // The subscriptions could be changed meanwhile, so resync if needed.
+    const std::lock_guard lg{mutex_};
+    for (const auto& [c, is_listen] : changed) {
+      c->second.is_listening = is_listen;
+      if (is_listen == c->second.subscriptions.empty())
+        is_sync_needed_ = true;
+      else if (!is_listen)
+        channels_.erase(c);
+    }
+  }
+}
+
+DMITIGR_PGFE_INLINE void Notification_hub::dispatch__()
+{
+  batch_.clear();
+  while (true) {
+    auto n = connection_.pop_notification();
+    if (!n)
+      break;
+    batch_.push_back(std::make_shared<const Notification>(std::move(n)));
+  }
+  if (batch_.empty())
+    return;
+
+  // The lock is acquired once per batch.
+  const std::lock_guard lg{mutex_};
+  for (const auto& notification : batch_) {
+    const auto c = channels_.find(notification->channel_name());
+    if (c != channels_.end()) {
+      for (const auto& subscription : c->second.subscriptions)
+        subscription->push(notification);
+    }
+  }
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,304 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_NOTIFICATION_HUB_HPP
+#define DMITIGR_PGFE_NOTIFICATION_HUB_HPP
+
+#include "connection.hpp"
+#include "dll.hpp"
+#include "notification.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A dispatcher of the notifications of many channels received via the
+ * single connection.
+ *
+ * The hub owns the connection which LISTENs each channel having at least one
+ * subscriber. The notifications are drained from the connection in batches
+ * and are fanned out to the queues of the subscriptions. Each queue is a
+ * lock-free single-producer single-consumer ring, thus the subscribers can
+ * consume the notifications from their own threads without contention.
+ *
+ * @par Example
+ * @code
+ * Notification_hub hub{options};
+ * auto sub = hub.subscribe("cache");
+ * std::thread listener{[&]{ while (!stop) hub.run_once(100ms); }};
+ * // On the subscriber's thread:
+ * if (sub->reset_missed())
+ *   cache.clear();
+ * while (const auto n = sub->pop())
+ *   cache.erase(to<std::string>(n->payload()));
+ * @endcode
+ *
+ * @remarks The functions subscribe(), unsubscribe() and subscription_count()
+ * are thread-safe. The other functions must be called from the single thread
+ * (the thread of the hub).
+ */
+class Notification_hub final {
+public:
+  /// The default capacity of the queue of the subscription.
+  static constexpr std::size_t default_capacity{1024};
+
+  /// An alias of the shared notification.
+  using Notification_ptr = std::shared_ptr<const Notification>;
+
+  /**
+   * @brief A subscription to the notifications of the channel.
+   *
+   * @remarks The function pop() must be called from the single thread (the
+   * thread of the subscriber).
+   */
+  class Subscription final {
+  public:
+    /// Non copy-constructible.
+    Subscription(const Subscription&) = delete;
+
+    /// Non copy-assignable.
+    Subscription& operator=(const Subscription&) = delete;
+
+    /// @returns The channel name.
+    const std::string& channel_name() const noexcept
+    {
+      return channel_name_;
+    }
+
+    /// @returns The capacity of the queue.
+    std::size_t capacity() const noexcept
+    {
+      return mask_ + 1;
+    }
+
+    /// @returns The number of notifications in the queue.
+    std::size_t size() const noexcept
+    {
+      return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    /// @returns `true` if the queue is empty.
+    bool is_empty() const noexcept
+    {
+      return !size();
+    }
+
+    /**
+     * @returns The next notification of the queue, or `nullptr` if the queue
+     * is empty.
+     */
+    Notification_ptr pop() noexcept
+    {
+      const auto head = head_.load(std::memory_order_relaxed);
+      if (head == tail_.load(std::memory_order_acquire))
+        return nullptr;
+      auto result = std::move(slots_[head & mask_]);
+      head_.store(head + 1, std::memory_order_release);
+      return result;
+    }
+
+    /**
+     * @returns `true` if the notifications might have been missed since the
+     * previous call, because either the queue was full or the connection of
+     * the hub was re-established.
+     */
+    bool reset_missed() noexcept
+    {
+      return is_missed_.exchange(false, std::memory_order_acq_rel);
+    }
+
+    /// @returns The number of notifications dropped because the queue was full.
+    std::uint_fast64_t dropped_count() const noexcept
+    {
+      return dropped_count_.load(std::memory_order_relaxed);
+    }
+
+    /// @returns `true` if this instance is subscribed.
+    bool is_subscribed() const noexcept
+    {
+      return is_subscribed_.load(std::memory_order_acquire);
+    }
+
+  private:
+    friend Notification_hub;
+
+    std::string channel_name_;
+    std::unique_ptr<Notification_ptr[]> slots_;
+    std::size_t mask_{};
+    alignas(64) std::atomic<std::size_t> head_{}; // written by the consumer
+    alignas(64) std::atomic<std::size_t> tail_{}; // written by the producer
+    std::atomic<std::uint_fast64_t> dropped_count_{};
+    std::atomic<bool> is_missed_{};
+    std::atomic<bool> is_subscribed_{true};
+
+    Subscription(std::string channel_name, std::size_t capacity);
+
+    /// Pushes the `notification` to the queue, or drops it if the queue is full.
+    bool push(const Notification_ptr& notification) noexcept
+    {
+      const auto tail = tail_.load(std::memory_order_relaxed);
+      if (tail - head_.load(std::memory_order_acquire) > mask_) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        is_missed_.store(true, std::memory_order_release);
+        return false;
+      }
+      slots_[tail & mask_] = notification;
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+  };
+
+  /**
+   * @brief The destructor.
+   *
+   * Unsubscribes all of the subscriptions.
+   */
+  DMITIGR_PGFE_API ~Notification_hub();
+
+  /**
+   * @brief The constructor.
+   *
+   * @param options The options of the connection of the hub.
+   *
+   * @remarks The connection is established by the first call of run_once().
+   */
+  explicit DMITIGR_PGFE_API Notification_hub(Connection_options options = {});
+
+  /// Non copy-constructible.
+  Notification_hub(const Notification_hub&) = delete;
+
+  /// Non copy-assignable.
+  Notification_hub& operator=(const Notification_hub&) = delete;
+
+  /// Non move-constructible.
+  Notification_hub(Notification_hub&&) = delete;
+
+  /// Non move-assignable.
+  Notification_hub& operator=(Notification_hub&&) = delete;
+
+  /**
+   * @returns The new subscription to the notifications of the channel named
+   * by `channel_name`.
+   *
+   * @param channel_name The channel name.
+   * @param capacity The capacity of the queue. (Rounded up to the power of 2.)
+   *
+   * @par Requires
+   * `(!channel_name.empty() && capacity)`.
+   *
+   * @par Effects
+   * The channel is LISTENed by the next call of run_once() if it's not yet.
+   *
+   * @par Thread safety
+   * Thread-safe.
+   */
+  DMITIGR_PGFE_API std::shared_ptr<Subscription> subscribe(std::string channel_name,
+    std::size_t capacity = default_capacity);
+
+  /**
+   * @brief Cancels the `subscription`.
+   *
+   * @returns `true` if the `subscription` was subscribed.
+   *
+   * @par Effects
+   * `!subscription.is_subscribed()`. The channel is UNLISTENed by the next
+   * call of run_once() if it has no more subscribers.
+   *
+   * @par Thread safety
+   * Thread-safe.
+   */
+  DMITIGR_PGFE_API bool unsubscribe(Subscription& subscription) noexcept;
+
+  /**
+   * @returns The number of subscriptions.
+   *
+   * @par Thread safety
+   * Thread-safe.
+   */
+  DMITIGR_PGFE_API std::size_t subscription_count() const noexcept;
+
+  /**
+   * @brief Establishes the connection if it's not established, synchronizes
+   * the set of LISTENed channels with the set of subscribed channels, waits
+   * for the notifications and fans them out to the subscriptions.
+   *
+   * If the connection has been lost, it's re-established, all the channels
+   * are re-LISTENed, and all the subscriptions are marked as possibly missed
+   * the notifications.
+   *
+   * @returns The number of received notifications.
+   *
+   * @param timeout The maximum amount of time to wait for the notifications.
+   * The value of `std::nullopt` means *eternity*.
+   *
+   * @par Requires
+   * `(!timeout || timeout->count() >= 0)`.
+   *
+   * @throws An exception if the connection cannot be established, or if the
+   * channels cannot be LISTENed.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API std::size_t run_once(
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+  /// @returns The number of times the connection has been re-established.
+  std::uint_fast64_t reconnect_count() const noexcept
+  {
+    return reconnect_count_;
+  }
+
+  /**
+   * @returns The connection of the hub.
+   *
+   * @warning The connection must not be used to execute the requests.
+   */
+  const Connection& connection() const noexcept
+  {
+    return connection_;
+  }
+
+private:
+  struct Channel final {
+    std::vector<std::shared_ptr<Subscription>> subscriptions;
+    bool is_listening{};
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Channel, std::less<>> channels_;
+  bool is_sync_needed_{};
+
+  Connection connection_;
+  std::vector<Notification_ptr> batch_;
+  bool was_connected_{};
+  std::uint_fast64_t reconnect_count_{};
+
+  void connect__();
+  void sync_channels__();
+  void dispatch__();
+};
+
+} // namespace dmitigr::pgfe
+
+#ifdef DMITIGR_PGFE_HEADER_ONLY
+#include "notification_hub.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_NOTIFICATION_HUB_HPP
@@ -26,6 +26,7 @@
 #include "array_conversions.hpp"
 #include "basic_conversions.hpp"
 #include "basics.hpp"
+#include "binary_copy.hpp"
 #include "completion.hpp"
 #include "composite.hpp"
 #include "compositional.hpp"
@@ -34,19 +35,28 @@
 #include "connection_pool.hpp"
 #include "conversions_api.hpp"
 #include "conversions.hpp"
+#include "copier.hpp"
+#include "coroutine.hpp"
 #include "data.hpp"
 #include "errc.hpp"
 #include "error.hpp"
 #include "exceptions.hpp"
+#include "flat_composite.hpp"
+#include "instrumentation.hpp"
 #include "large_object.hpp"
 #include "message.hpp"
 #include "misc.hpp"
 #include "notice.hpp"
 #include "notification.hpp"
+#include "notification_hub.hpp"
 #include "parameterizable.hpp"
 #include "problem.hpp"
+#include "reactor.hpp"
 #include "response.hpp"
+#include "routing_pool.hpp"
 #include "row.hpp"
+#include "row_batch.hpp"
+#include "row_binding.hpp"
 #include "row_info.hpp"
 #include "signal.hpp"
 #include "sql_string.hpp"
@@ -59,6 +59,19 @@ inline Data_format to_data_format(const int format) noexcept
   return Data_format{format};
 }
 
+/**
+ * @returns `true` if the `status` denotes a portion of rows (i.e. a single
+ * row or a chunk of rows) of a result set.
+ */
+inline bool is_rows_portion(const ::ExecStatusType status) noexcept
+{
+#ifdef LIBPQ_HAS_CHUNK_MODE
+  return status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_CHUNK;
+#else
+  return status == PGRES_SINGLE_TUPLE;
+#endif
+}
+
 /// Represents libpq's result.
 class Result final {
 public:
@@ -92,7 +92,8 @@ DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio()
   execute_nio__(nullptr);
 }
 
-DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio__(const Sql_string* const statement)
+DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio__(const Sql_string* const statement,
+  const bool is_unprepare)
 {
   assert(connection()->is_ready_for_nio_request());
 
@@ -102,7 +103,17 @@ DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio__(const Sql_string* con
   std::vector<int> lengths(static_cast<unsigned>(param_count), 0);
   std::vector<int> formats(static_cast<unsigned>(param_count), 0);
 
-  connection_->requests_.push(Connection::Request_id::execute); // can throw
+  const std::string query = statement ? statement->to_query_string() : std::string{};
+  if (is_unprepare) {
+    // The name of the statement to deallocate is already requested.
+    assert(!connection_->request_prepared_statement_names_.empty());
+    connection_->push_request__(Connection::Request_id::unprepare,
+      connection_->instrument_ ? query_hash(query) : 0,
+      connection_->request_prepared_statement_names_.back()); // can throw
+  } else
+    connection_->push_request__(Connection::Request_id::execute,
+      connection_->instrument_ ? (statement ? query_hash(query) : query_hash_) : 0,
+      name_); // can throw
   try {
     // Prepare the input for libpq.
     for (unsigned i = 0; i < static_cast<unsigned>(param_count); ++i) {
@@ -116,7 +127,7 @@ DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio__(const Sql_string* con
 
     const int send_ok = statement
       ?
-      ::PQsendQueryParams(connection_->conn(), statement->to_query_string().c_str(),
+      ::PQsendQueryParams(connection_->conn(), query.c_str(),
         param_count, nullptr, values.data(), lengths.data(), formats.data(), result_format)
       :
       ::PQsendQueryPrepared(connection_->conn(), name_.c_str(),
@@ -125,13 +136,19 @@ DMITIGR_PGFE_INLINE void Prepared_statement::execute_nio__(const Sql_string* con
     if (!send_ok)
       throw std::runtime_error(connection_->error_message());
 
-    const auto set_ok = ::PQsetSingleRowMode(connection_->conn());
-    if (!set_ok)
-      throw std::runtime_error{"cannot switch to single-row mode"};
+    /*
+     * In pipeline mode the rows mode can be switched only for the request
+     * which is currently processed, so it can fail here. (In this case it will
+     * be switched by Connection::handle_input() later.)
+     */
+    const auto set_ok = connection_->set_rows_mode();
+    if (!set_ok && connection_->pipeline_status() == Pipeline_status::disabled)
+      throw std::runtime_error{"cannot switch to single-row or chunked rows mode"};
   } catch (...) {
-    connection_->requests_.pop(); // rollback
+    connection_->pop_request_back__(); // rollback
     throw;
   }
+  connection_->trace_send__(query);
 
   assert(is_invariant_ok());
 }
@@ -371,6 +371,37 @@ public:
     return bind(idx, std::forward<T>(value));
   }
 
+  /**
+   * @overload
+   *
+   * Similar to bind(std::size_t, T&&) but the value is converted to the Data
+   * of the specified `format` if the conversion to this format is supported.
+   * (For example, the binary format is supported for numerics, `bool`, etc.)
+   *
+   * @remarks The binary format of the data must be exactly the format of the
+   * parameter type, since a server doesn't perform any conversions of the data
+   * in binary format.
+   */
+  template<typename T>
+  Prepared_statement& bind(const std::size_t index, T&& value, const Data_format format) noexcept
+  {
+    return bind(index, to_data(std::forward<T>(value), format));
+  }
+
+  /**
+   * @overload
+   *
+   * @par Requries
+   * `(parameter_index(name) < parameter_count())`.
+   */
+  template<typename T>
+  Prepared_statement& bind(const std::string_view name, T&& value, const Data_format format) noexcept
+  {
+    const auto idx = parameter_index(name);
+    assert(idx < parameter_count());
+    return bind(idx, std::forward<T>(value), format);
+  }
+
   /**
    * @brief Similar to bind(std::size_t, std::unique_ptr<Data>&&) but
    * binds the parameter of the specified index with a view to the data.
@@ -516,7 +547,7 @@ public:
   /// @overload
   Completion execute()
   {
-    return execute([](auto&&){});
+    return execute([](Row_batch&&){});
   }
 
   /**
@@ -598,6 +629,7 @@ private:
 
   Data_format result_format_{Data_format::text};
   std::string name_;
+  std::uint64_t query_hash_{}; // of the query text if prepared
   bool preparsed_{};
   Connection* connection_{};
   std::chrono::system_clock::time_point session_start_time_;
@@ -620,6 +652,7 @@ private:
   Prepared_statement(Prepared_statement&& rhs) noexcept
     : result_format_{std::move(rhs.result_format_)}
     , name_{std::move(rhs.name_)}
+    , query_hash_{std::move(rhs.query_hash_)}
     , preparsed_{std::move(rhs.preparsed_)}
     , connection_{std::move(rhs.connection_)}
     , session_start_time_{std::move(rhs.session_start_time_)}
@@ -645,6 +678,7 @@ private:
     using std::swap;
     swap(result_format_, rhs.result_format_);
     swap(name_, rhs.name_);
+    swap(query_hash_, rhs.query_hash_);
     swap(preparsed_, rhs.preparsed_);
     swap(connection_, rhs.connection_);
     swap(session_start_time_, rhs.session_start_time_);
@@ -735,7 +769,13 @@ private:
   // ---------------------------------------------------------------------------
 
   void execute_nio(const Sql_string& statement);
-  void execute_nio__(const Sql_string* const statement);
+
+  /*
+   * Sends the statement. If `is_unprepare`, the request is accounted as the
+   * deallocation of the statement which name is requested last (see
+   * Connection::unprepare_nio()) instead of the execution.
+   */
+  void execute_nio__(const Sql_string* const statement, bool is_unprepare = false);
 };
 
 } // namespace dmitigr::pgfe
@@ -0,0 +1,451 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "reactor.hpp"
+#include "../net/socket.hpp"
+
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+#ifdef __linux__
+constexpr unsigned reactor_read_event = EPOLLIN;
+constexpr unsigned reactor_write_event = EPOLLOUT;
+#else
+constexpr unsigned reactor_read_event = POLLIN;
+constexpr unsigned reactor_write_event = POLLOUT;
+#endif
+} // namespace detail
+
+DMITIGR_PGFE_INLINE Reactor::~Reactor()
+{
+  while (!entries_.empty())
+    remove(*entries_.begin()->second->connection);
+#ifdef __linux__
+  ::close(poller_);
+#endif
+}
+
+DMITIGR_PGFE_INLINE Reactor::Reactor()
+{
+#ifdef __linux__
+  poller_ = ::epoll_create1(EPOLL_CLOEXEC);
+  if (poller_ < 0)
+    throw std::system_error{errno, std::system_category()};
+#endif
+}
+
+DMITIGR_PGFE_INLINE void Reactor::add(Connection& connection, Connect_handler handler,
+  Failure_handler failure_handler)
+{
+  assert(!contains(connection));
+  assert(!connection.has_uncompleted_request());
+  assert(connection.row_batch_size() == 1);
+
+  auto& e = *entries_.emplace(&connection, std::make_unique<Entry>()).first->second;
+  e.connection = &connection;
+  e.connect_handler = std::move(handler);
+  e.failure_handler = std::move(failure_handler);
+
+  // The entry can be removed by the connect handler called by drive__().
+  struct Running_guard final {
+    ~Running_guard()
+    {
+      if (!was_running) {
+        reactor.is_running_ = false;
+        reactor.removed_entries_.clear();
+      }
+    }
+    Reactor& reactor;
+    bool was_running;
+  } const running_guard{*this, is_running_};
+  is_running_ = true;
+
+  try {
+    const auto s = connection.status();
+    if (s == Connection_status::disconnected || s == Connection_status::failure)
+      connection.connect_nio();
+    drive__(e, false, false);
+  } catch (...) {
+    remove(connection);
+    throw;
+  }
+}
+
+DMITIGR_PGFE_INLINE bool Reactor::remove(Connection& connection) noexcept
+{
+  const auto i = entries_.find(&connection);
+  if (i == entries_.end())
+    return false;
+
+  auto e = std::move(i->second);
+  entries_.erase(i);
+  unwatch__(*e);
+  e->is_removed = true;
+  request_count_ -= e->queued.size() + static_cast<std::size_t>(
+    std::count_if(e->submitted.begin(), e->submitted.end(),
+      [](const auto& request){ return !request.is_sync; }));
+  if (connection.conn())
+    ::PQsetnonblocking(connection.conn(), 0);
+
+  // The entry can be in use by the handler which is being called right now.
+  if (is_running_) {
+    try {
+      removed_entries_.push_back(std::move(e));
+    } catch (...) {
+      (void)e.release();
+    }
+  }
+  return true;
+}
+
+DMITIGR_PGFE_INLINE bool Reactor::contains(const Connection& connection) const noexcept
+{
+  return entry(connection);
+}
+
+DMITIGR_PGFE_INLINE std::size_t Reactor::size() const noexcept
+{
+  return entries_.size();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Reactor::run_once(const std::optional<std::chrono::milliseconds> timeout)
+{
+  assert(!timeout || timeout->count() >= 0);
+  assert(!is_running_);
+
+  struct Running_guard final {
+    ~Running_guard()
+    {
+      reactor.is_running_ = false;
+      reactor.removed_entries_.clear();
+    }
+    Reactor& reactor;
+  } const running_guard{*this};
+  is_running_ = true;
+
+  std::size_t result{};
+  const auto drive = [this, &result](Entry& e, const bool is_readable, const bool is_writable)
+  {
+    if (e.is_removed)
+      return;
+
+    try {
+      result += drive__(e, is_readable, is_writable);
+    } catch (...) {
+      fail__(e, std::current_exception());
+    }
+  };
+  const int timeout_ms = timeout ? static_cast<int>(timeout->count()) : -1;
+
+#ifdef __linux__
+  std::array<::epoll_event, 256> events;
+  const int count = ::epoll_wait(poller_, events.data(), static_cast<int>(events.size()), timeout_ms);
+  if (count < 0) {
+    if (errno == EINTR)
+      return result;
+    throw std::system_error{errno, std::system_category()};
+  }
+
+  for (int i = 0; i < count; ++i) {
+    const auto& event = events[static_cast<std::size_t>(i)];
+    constexpr unsigned failure_events = EPOLLERR | EPOLLHUP;
+    drive(*static_cast<Entry*>(event.data.ptr),
+      event.events & (EPOLLIN | failure_events),
+      event.events & (EPOLLOUT | failure_events));
+  }
+#else
+#ifdef _WIN32
+  using Pollfd = WSAPOLLFD;
+  const auto poll = [](Pollfd* const fds, const std::size_t size, const int timeout)
+  {
+    const int result = ::WSAPoll(fds, static_cast<ULONG>(size), timeout);
+    return result != SOCKET_ERROR ? result : (errno = ::WSAGetLastError(), -1);
+  };
+#else
+  using Pollfd = ::pollfd;
+  const auto poll = [](Pollfd* const fds, const std::size_t size, const int timeout)
+  {
+    return ::poll(fds, static_cast<::nfds_t>(size), timeout);
+  };
+#endif
+  std::vector<Pollfd> fds;
+  std::vector<Entry*> polled;
+  fds.reserve(entries_.size());
+  polled.reserve(entries_.size());
+  for (const auto& [connection, e] : entries_) {
+    if (e->socket >= 0 && e->events) {
+      Pollfd fd{};
+      fd.fd = e->socket;
+      fd.events = static_cast<short>(e->events);
+      fds.push_back(fd);
+      polled.push_back(e.get());
+    }
+  }
+
+  const int count = poll(fds.data(), fds.size(), timeout_ms);
+  if (count < 0) {
+    if (errno == EINTR)
+      return result;
+    throw std::system_error{errno, std::system_category()};
+  }
+
+  for (std::size_t i{}; count && i < fds.size(); ++i) {
+    if (const auto revents = fds[i].revents) {
+      constexpr short failure_events = POLLERR | POLLHUP;
+      drive(*polled[i], revents & (POLLIN | failure_events),
+        revents & (POLLOUT | failure_events));
+    }
+  }
+#endif
+
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Reactor::run()
+{
+  while (!is_idle())
+    run_once();
+}
+
+DMITIGR_PGFE_INLINE bool Reactor::is_idle() const noexcept
+{
+  return !request_count_ && std::all_of(entries_.begin(), entries_.end(),
+    [](const auto& pair){ return pair.second->is_established; });
+}
+
+DMITIGR_PGFE_INLINE auto Reactor::entry(const Connection& connection) const noexcept -> Entry*
+{
+  const auto i = entries_.find(&connection);
+  return i != entries_.end() ? i->second.get() : nullptr;
+}
+
+DMITIGR_PGFE_INLINE void Reactor::queue__(Entry& e, Request&& request)
+{
+  assert(!e.is_removed);
+  e.queued.push_back(std::move(request));
+  ++request_count_;
+  if (submit__(e))
+    watch__(e);
+}
+
+DMITIGR_PGFE_INLINE bool Reactor::submit__(Entry& e)
+{
+  if (!e.is_established || e.queued.empty())
+    return false;
+
+  auto& conn = *e.connection;
+  const bool is_pipeline = conn.pipeline_status() != Pipeline_status::disabled;
+  if (!conn.is_ready_for_nio_request() || (!is_pipeline && !e.submitted.empty()))
+    return false;
+
+  /*
+   * Only one request can be submitted at time in non-pipeline mode. In
+   * pipeline mode all the queued requests are submitted followed by the
+   * synchronization point, since the server doesn't begin to respond until it.
+   */
+  do {
+    auto& request = e.queued.front();
+    try {
+      request.submit(conn);
+    } catch (...) {
+      e.queued.pop_front();
+      --request_count_;
+      throw;
+    }
+    request.submit = nullptr; // release the parameters
+    e.submitted.push_back(std::move(request));
+    e.queued.pop_front();
+  } while (is_pipeline && !e.queued.empty());
+
+  if (is_pipeline) {
+    conn.send_sync();
+    Request sync;
+    sync.is_sync = true;
+    e.submitted.push_back(std::move(sync));
+  }
+
+  // The output may be sent only partially in non-blocking mode.
+  const int flush_result = ::PQflush(conn.conn());
+  if (flush_result < 0)
+    throw std::runtime_error{conn.error_message()};
+  e.is_flushing = flush_result > 0;
+
+  return true;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Reactor::drive__(Entry& e,
+  const bool is_readable, const bool is_writable)
+{
+  using Status = Connection_status;
+  auto& conn = *e.connection;
+
+  // Establishment.
+  if (!e.is_established) {
+    if (is_readable || is_writable)
+      conn.connect_nio();
+
+    switch (conn.status()) {
+    case Status::establishment_reading:
+      [[fallthrough]];
+    case Status::establishment_writing:
+      watch__(e);
+      return 0;
+    case Status::connected:
+      break;
+    case Status::disconnected:
+      [[fallthrough]];
+    case Status::failure:
+      throw std::runtime_error{conn.error_message()};
+    }
+
+    if (::PQsetnonblocking(conn.conn(), 1))
+      throw std::runtime_error{conn.error_message()};
+    e.is_established = true;
+    if (e.connect_handler) {
+      e.connect_handler(conn);
+      if (e.is_removed)
+        return 0;
+    }
+  } else {
+    // Output.
+    if (e.is_flushing && is_writable) {
+      const int flush_result = ::PQflush(conn.conn());
+      if (flush_result < 0)
+        throw std::runtime_error{conn.error_message()};
+      e.is_flushing = flush_result > 0;
+    }
+
+    // Input. (Notifications are handled by handle_input() as well.)
+    if (is_readable)
+      conn.read_input();
+
+    if (!conn.is_connected())
+      throw std::runtime_error{conn.error_message()};
+  }
+
+  std::size_t result{};
+  while (conn.handle_input() == Response_status::ready && !e.submitted.empty()) {
+    auto& request = e.submitted.front();
+    if (auto row = conn.row()) {
+      if (request.row_handler) {
+        request.row_handler(std::move(row));
+        if (e.is_removed)
+          return result;
+      }
+      continue;
+    }
+
+    auto error = conn.error();
+    auto completion = error ? Completion{} : conn.completion();
+    auto completed = std::move(request);
+    e.submitted.pop_front();
+    if (completed.is_sync)
+      continue;
+
+    --request_count_;
+    ++result;
+    if (completed.completion_handler) {
+      completed.completion_handler(std::move(completion), std::move(error));
+      if (e.is_removed)
+        return result;
+    }
+  }
+
+  submit__(e);
+  watch__(e);
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Reactor::watch__(Entry& e)
+{
+  using Status = Connection_status;
+  using detail::reactor_read_event;
+  using detail::reactor_write_event;
+
+  const auto& conn = *e.connection;
+  unsigned events{};
+  switch (conn.status()) {
+  case Status::establishment_reading:
+    events = reactor_read_event;
+    break;
+  case Status::establishment_writing:
+    events = reactor_write_event;
+    break;
+  case Status::connected:
+    events = reactor_read_event | (e.is_flushing ? reactor_write_event : 0);
+    break;
+  case Status::disconnected:
+    [[fallthrough]];
+  case Status::failure:
+    break;
+  }
+  const int socket = conn.conn() ? conn.socket() : -1;
+
+#ifdef __linux__
+  /*
+   * The socket can be changed upon the connection establishment (for example,
+   * when trying the next host). Note, that the closed socket is removed from
+   * the epoll set automatically, and its descriptor can be reused.
+   */
+  if (socket != e.socket)
+    unwatch__(e);
+
+  if (socket >= 0 && (e.socket < 0 || events != e.events)) {
+    ::epoll_event event{};
+    event.events = events;
+    event.data.ptr = &e;
+    int op = e.socket < 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    while (::epoll_ctl(poller_, op, socket, &event)) {
+      if (op == EPOLL_CTL_ADD && errno == EEXIST)
+        op = EPOLL_CTL_MOD;
+      else if (op == EPOLL_CTL_MOD && errno == ENOENT)
+        op = EPOLL_CTL_ADD;
+      else
+        throw std::system_error{errno, std::system_category()};
+    }
+  }
+#endif
+
+  e.socket = socket;
+  e.events = events;
+}
+
+DMITIGR_PGFE_INLINE void Reactor::unwatch__(Entry& e) noexcept
+{
+#ifdef __linux__
+  if (e.socket >= 0)
+    ::epoll_ctl(poller_, EPOLL_CTL_DEL, e.socket, nullptr);
+#endif
+  e.socket = -1;
+  e.events = 0;
+}
+
+DMITIGR_PGFE_INLINE void Reactor::fail__(Entry& e, std::exception_ptr exception)
+{
+  auto& conn = *e.connection;
+  remove(conn);
+  if (e.failure_handler)
+    e.failure_handler(conn, std::move(exception));
+  else if (failure_handler_)
+    failure_handler_(conn, std::move(exception));
+  else
+    std::rethrow_exception(std::move(exception));
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,323 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_REACTOR_HPP
+#define DMITIGR_PGFE_REACTOR_HPP
+
+#include "completion.hpp"
+#include "connection.hpp"
+#include "dll.hpp"
+#include "error.hpp"
+#include "row.hpp"
+#include "sql_string.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A single-threaded demultiplexer of the I/O events of many connections.
+ *
+ * The reactor drives the registered connections non-blockingly: it establishes
+ * the connections, submits the queued requests as soon as the connections are
+ * ready for them, and calls the handlers as the responses arrive. Thus, one
+ * thread can keep a lot of requests in flight.
+ *
+ * On Linux the reactor is based on `epoll`, on other platforms - on `poll`.
+ *
+ * @par Example
+ * @code
+ * Reactor reactor;
+ * for (auto& conn : connections)
+ *   reactor.add(conn);
+ * for (auto& conn : connections)
+ *   reactor.execute(conn, [](Completion&& comp, Error&& err){ ... },
+ *     [](Row&& row){ ... }, "select $1::int", 1);
+ * reactor.run();
+ * @endcode
+ *
+ * @warning The registered connections must be used only via the reactor,
+ * since they are switched to the non-blocking mode.
+ *
+ * @warning The behaivor is undefined if the registered connection is destroyed
+ * before it's removed from the reactor.
+ *
+ * @remarks Functions of this class are not thread-safe.
+ */
+class Reactor final {
+public:
+  /// An alias of the handler of rows.
+  using Row_handler = std::function<void(Row&&)>;
+
+  /**
+   * @brief An alias of the handler of completion of the request.
+   *
+   * The handler is called with either the valid Completion on success, or with
+   * the valid Error on failure. (Both are invalid if the request is aborted in
+   * pipeline mode.)
+   */
+  using Completion_handler = std::function<void(Completion&&, Error&&)>;
+
+  /// An alias of the handler of established connection.
+  using Connect_handler = std::function<void(Connection&)>;
+
+  /**
+   * @brief An alias of the handler of connection failure.
+   *
+   * The handler is called with the exception thrown upon driving the
+   * connection (including exceptions thrown by the handlers), just after the
+   * connection has been removed from the reactor.
+   */
+  using Failure_handler = std::function<void(Connection&, std::exception_ptr)>;
+
+  /**
+   * @brief The destructor.
+   *
+   * Removes all of the connections.
+   */
+  DMITIGR_PGFE_API ~Reactor();
+
+  /**
+   * @brief The constructor.
+   *
+   * @throws `std::system_error` on failure.
+   */
+  DMITIGR_PGFE_API Reactor();
+
+  /// Non copy-constructible.
+  Reactor(const Reactor&) = delete;
+
+  /// Non copy-assignable.
+  Reactor& operator=(const Reactor&) = delete;
+
+  /// Non move-constructible.
+  Reactor(Reactor&&) = delete;
+
+  /// Non move-assignable.
+  Reactor& operator=(Reactor&&) = delete;
+
+  /**
+   * @brief Sets the handler of connection failures.
+   *
+   * By default, the exceptions are propagated from run_once().
+   */
+  void set_failure_handler(Failure_handler handler) noexcept
+  {
+    failure_handler_ = std::move(handler);
+  }
+
+  /// @returns The current handler of connection failures.
+  const Failure_handler& failure_handler() const noexcept
+  {
+    return failure_handler_;
+  }
+
+  /**
+   * @brief Registers the `connection`.
+   *
+   * If the `connection` isn't connected the reactor establishes it.
+   *
+   * @param handler The handler to call when the connection is established (or
+   * just after the registration if it's already established).
+   * @param failure_handler The handler of the failure of the `connection`
+   * which is called instead of failure_handler().
+   *
+   * @par Requires
+   * `(!contains(connection) && !connection.has_uncompleted_request() &&
+   * connection.row_batch_size() == 1)`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API void add(Connection& connection, Connect_handler handler = {},
+    Failure_handler failure_handler = {});
+
+  /**
+   * @brief Unregisters the `connection`.
+   *
+   * The requests of the `connection` not completed yet are discarded without
+   * calling their handlers. The `connection` is switched back to the blocking
+   * mode.
+   *
+   * @returns `true` if the `connection` was registered.
+   *
+   * @remarks The `connection` can be removed from within handlers.
+   */
+  DMITIGR_PGFE_API bool remove(Connection& connection) noexcept;
+
+  /// @returns `true` if the `connection` is registered.
+  DMITIGR_PGFE_API bool contains(const Connection& connection) const noexcept;
+
+  /// @returns The number of registered connections.
+  DMITIGR_PGFE_API std::size_t size() const noexcept;
+
+  /// @returns The number of requests submitted or queued, but not completed yet.
+  std::size_t request_count() const noexcept
+  {
+    return request_count_;
+  }
+
+  /**
+   * @brief Queues the request to execute the `statement` on the `connection`.
+   *
+   * The request is submitted immediately if the `connection` is ready for it.
+   * In pipeline mode all the queued requests are submitted at once followed
+   * by the synchronization point.
+   *
+   * @param connection The registered connection.
+   * @param completion_handler The handler to call upon completion.
+   * @param row_handler The handler to call for each row.
+   * @param statement A *preparsed* statement to execute.
+   * @param parameters Parameters to bind with a parameterized statement.
+   *
+   * @par Requires
+   * `(contains(connection) && !statement.has_missing_parameters())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename ... Types>
+  void execute(Connection& connection, Completion_handler completion_handler,
+    Row_handler row_handler, Sql_string statement, Types&& ... parameters)
+  {
+    auto arguments = std::make_shared<std::tuple<std::decay_t<Types>...>>(
+      std::forward<Types>(parameters)...);
+    submit(connection, [statement = std::move(statement),
+      arguments = std::move(arguments)](Connection& conn)
+    {
+      std::apply([&conn, &statement](auto& ... args)
+      {
+        conn.execute_nio(statement, std::move(args)...);
+      }, *arguments);
+    }, std::move(completion_handler), std::move(row_handler));
+  }
+
+  /// @overload
+  template<typename ... Types>
+  void execute(Connection& connection, Completion_handler completion_handler,
+    Sql_string statement, Types&& ... parameters)
+  {
+    execute(connection, std::move(completion_handler), Row_handler{},
+      std::move(statement), std::forward<Types>(parameters)...);
+  }
+
+  /**
+   * @brief Queues the arbitrary request on the `connection`.
+   *
+   * @param connection The registered connection.
+   * @param request The function which submits exactly one request by using
+   * one of the methods of Connection with the suffix "_nio" (for example,
+   * Connection::prepare_nio()).
+   * @param completion_handler The handler to call upon completion. (Note, that
+   * the Completion is invalid upon successful preparation or description of
+   * the statement.)
+   * @param row_handler The handler to call for each row.
+   *
+   * @par Requires
+   * `contains(connection)`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @see execute().
+   */
+  void submit(Connection& connection, std::function<void(Connection&)> request,
+    Completion_handler completion_handler, Row_handler row_handler = {})
+  {
+    auto* const e = entry(connection);
+    assert(e);
+    queue__(*e, Request{std::move(request), std::move(row_handler),
+      std::move(completion_handler)});
+  }
+
+  /**
+   * @brief Waits for the I/O events and handles them.
+   *
+   * @returns The number of completed requests.
+   *
+   * @param timeout The value of `std::nullopt` means *eternity*.
+   *
+   * @par Requires
+   * `(!timeout || timeout->count() >= 0)`. Also, it must not be called from
+   * the handlers.
+   *
+   * @throws The exception thrown upon driving a connection if the failure
+   * handler is not set. (The failed connection is removed in this case.)
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API std::size_t run_once(
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+  /**
+   * @brief Calls run_once() until all of the requests are completed and all
+   * of the connections are established.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  DMITIGR_PGFE_API void run();
+
+  /// @returns `true` if there are neither requests nor connections in progress.
+  DMITIGR_PGFE_API bool is_idle() const noexcept;
+
+private:
+  struct Request final {
+    std::function<void(Connection&)> submit; // reset upon the submission
+    Row_handler row_handler;
+    Completion_handler completion_handler;
+    bool is_sync{}; // the synchronization point in pipeline mode
+  };
+
+  struct Entry final {
+    Connection* connection{};
+    Connect_handler connect_handler;
+    Failure_handler failure_handler;
+    std::deque<Request> queued;
+    std::deque<Request> submitted;
+    int socket{-1};
+    unsigned events{};
+    bool is_established{};
+    bool is_flushing{};
+    bool is_removed{};
+  };
+
+  Failure_handler failure_handler_;
+  std::unordered_map<const Connection*, std::unique_ptr<Entry>> entries_;
+  std::vector<std::unique_ptr<Entry>> removed_entries_;
+  std::size_t request_count_{};
+  int poller_{-1};
+  bool is_running_{};
+
+  Entry* entry(const Connection& connection) const noexcept;
+  void queue__(Entry& e, Request&& request);
+  bool submit__(Entry& e);
+  std::size_t drive__(Entry& e, bool is_readable, bool is_writable);
+  void watch__(Entry& e);
+  void unwatch__(Entry& e) noexcept;
+  void fail__(Entry& e, std::exception_ptr exception);
+};
+
+} // namespace dmitigr::pgfe
+
+#ifdef DMITIGR_PGFE_HEADER_ONLY
+#include "reactor.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_REACTOR_HPP
@@ -19,9 +19,11 @@ namespace dmitigr::pgfe {
  */
 class Response : public Message {
   friend Completion;
+  friend Copier;
   friend Error;
   friend Prepared_statement;
   friend Row;
+  friend Row_batch;
 
   Response() = default;
 };
@@ -44,6 +46,7 @@ struct Response_callback_traits<F,
   constexpr static bool is_result_void = std::is_same_v<Result, void>;
   constexpr static bool is_valid = is_result_row_processing || is_result_void;
   constexpr static bool has_error_parameter = false;
+  using Row_type = Row;
 };
 
 template<typename F>
@@ -54,6 +57,33 @@ struct Response_callback_traits<F,
   constexpr static bool is_result_void = std::is_same_v<Result, void>;
   constexpr static bool is_valid = is_result_row_processing || is_result_void;
   constexpr static bool has_error_parameter = true;
+  using Row_type = Row;
+};
+
+template<typename F>
+struct Response_callback_traits<F,
+  std::enable_if_t<std::conjunction_v<
+    std::negation<std::is_invocable<F, Row&&>>,
+    std::is_invocable<F, Row_batch&&>>>> final {
+  using Result = std::invoke_result_t<F, Row_batch&&>;
+  constexpr static bool is_result_row_processing = std::is_same_v<Result, Row_processing>;
+  constexpr static bool is_result_void = std::is_same_v<Result, void>;
+  constexpr static bool is_valid = is_result_row_processing || is_result_void;
+  constexpr static bool has_error_parameter = false;
+  using Row_type = Row_batch;
+};
+
+template<typename F>
+struct Response_callback_traits<F,
+  std::enable_if_t<std::conjunction_v<
+    std::negation<std::is_invocable<F, Row&&, Error&&>>,
+    std::is_invocable<F, Row_batch&&, Error&&>>>> final {
+  using Result = std::invoke_result_t<F, Row_batch&&, Error&&>;
+  constexpr static bool is_result_row_processing = std::is_same_v<Result, Row_processing>;
+  constexpr static bool is_result_void = std::is_same_v<Result, void>;
+  constexpr static bool is_valid = is_result_row_processing || is_result_void;
+  constexpr static bool has_error_parameter = true;
+  using Row_type = Row_batch;
 };
 } // namespace detail
 
@@ -0,0 +1,257 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#include "conversions.hpp"
+#include "routing_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE Routing_pool::Routing_pool(const std::size_t count,
+  const Connection_options& primary_options,
+  const std::vector<Connection_options>& replica_options)
+  : recovery_check_{[](Connection& conn)
+    {
+      bool result{};
+      conn.execute([&result](auto&& row)
+      {
+        result = to<bool>(row[0]);
+      }, "select pg_catalog.pg_is_in_recovery()");
+      return result;
+    }}
+  , primary_{std::make_unique<Connection_pool>(count, primary_options)}
+  , hosts_(replica_options.size())
+{
+  replicas_.reserve(replica_options.size());
+  for (const auto& options : replica_options)
+    replicas_.push_back(std::make_unique<Connection_pool>(count, options));
+}
+
+DMITIGR_PGFE_INLINE void Routing_pool::set_balancing(const Balancing value) noexcept
+{
+  const std::lock_guard lg{mutex_};
+  balancing_ = value;
+}
+
+DMITIGR_PGFE_INLINE auto Routing_pool::balancing() const noexcept -> Balancing
+{
+  const std::lock_guard lg{mutex_};
+  return balancing_;
+}
+
+DMITIGR_PGFE_INLINE void Routing_pool::set_recovery_check(Recovery_check value) noexcept
+{
+  assert(is_valid() && value);
+  const std::lock_guard lg{mutex_};
+  recovery_check_ = std::move(value);
+}
+
+DMITIGR_PGFE_INLINE auto Routing_pool::recovery_check() const -> Recovery_check
+{
+  const std::lock_guard lg{mutex_};
+  return recovery_check_;
+}
+
+DMITIGR_PGFE_INLINE void Routing_pool::connect()
+{
+  assert(is_valid());
+  primary_->connect();
+  for (auto& replica : replicas_) {
+    try {
+      replica->connect();
+    } catch (...) {
+      // The replica will be out of rotation until it's reachable.
+    }
+  }
+  check();
+}
+
+DMITIGR_PGFE_INLINE void Routing_pool::disconnect() noexcept
+{
+  if (primary_)
+    primary_->disconnect();
+  for (auto& replica : replicas_)
+    replica->disconnect();
+  const std::lock_guard lg{mutex_};
+  for (auto& host : hosts_)
+    host.is_in_rotation = false;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Routing_pool::check()
+{
+  assert(is_valid());
+
+  // The hosts are checked without locking the pool.
+  const auto check = recovery_check();
+  const auto primary_result = check__(*primary_, check);
+  std::vector<Check_result> results;
+  results.reserve(replicas_.size());
+  for (auto& replica : replicas_)
+    results.push_back(check__(*replica, check));
+
+  const std::lock_guard lg{mutex_};
+  if (primary_result.is_in_recovery)
+    is_primary_available_ = !*primary_result.is_in_recovery;
+
+  std::size_t result{};
+  for (std::size_t i = 0; i < hosts_.size(); ++i) {
+    auto& host = hosts_[i];
+    const auto& r = results[i];
+    if (!r.is_alive)
+      host.is_in_rotation = false;
+    else if (r.is_in_recovery)
+      host.is_in_rotation = *r.is_in_recovery;
+    if (r.latency)
+      host.latency = host.latency ?
+        *host.latency + latency_smoothing * (*r.latency - *host.latency) : *r.latency;
+    result += host.is_in_rotation;
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE Connection_pool::Handle
+Routing_pool::connection(const Target target,
+  const std::optional<std::chrono::milliseconds> timeout)
+{
+  assert(is_valid());
+  assert(!timeout || timeout->count() >= 0);
+
+  const auto exclude = [this](const std::size_t index) noexcept
+  {
+    const std::lock_guard lg{mutex_};
+    hosts_[index].is_in_rotation = false;
+  };
+
+  if (target == Target::replica) {
+    const auto candidates = candidates__();
+    for (const auto index : candidates) {
+      try {
+        if (auto result = replicas_[index]->connection(std::chrono::milliseconds{}))
+          return result;
+      } catch (...) {
+        exclude(index);
+      }
+    }
+
+    // All of the replicas are busy: wait for the least loaded one.
+    if (!candidates.empty() && (!timeout || timeout->count())) {
+      const auto index = candidates.front();
+      try {
+        return replicas_[index]->connection(timeout);
+      } catch (...) {
+        exclude(index);
+      }
+    } else if (!candidates.empty())
+      return {};
+  } else {
+    const std::lock_guard lg{mutex_};
+    if (!is_primary_available_)
+      return {};
+  }
+  return primary_->connection(timeout);
+}
+
+DMITIGR_PGFE_INLINE Connection_pool& Routing_pool::replica(const std::size_t index) noexcept
+{
+  assert(index < replica_count());
+  return *replicas_[index];
+}
+
+DMITIGR_PGFE_INLINE bool Routing_pool::is_in_rotation(const std::size_t index) const noexcept
+{
+  assert(index < replica_count());
+  const std::lock_guard lg{mutex_};
+  return hosts_[index].is_in_rotation;
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::chrono::microseconds>
+Routing_pool::latency(const std::size_t index) const noexcept
+{
+  assert(index < replica_count());
+  const std::lock_guard lg{mutex_};
+  if (const auto& latency = hosts_[index].latency)
+    return std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(*latency)};
+  else
+    return std::nullopt;
+}
+
+DMITIGR_PGFE_INLINE bool Routing_pool::is_primary_available() const noexcept
+{
+  const std::lock_guard lg{mutex_};
+  return is_primary_available_;
+}
+
+DMITIGR_PGFE_INLINE auto Routing_pool::check__(Connection_pool& pool,
+  const Recovery_check& recovery_check) -> Check_result
+{
+  Check_result result;
+  try {
+    if (!pool.is_connected())
+      pool.connect();
+
+    auto handle = pool.connection(std::chrono::milliseconds{});
+    if (!handle) {
+      // All of the connections are busy.
+      result.is_alive = pool.is_connected();
+      return result;
+    } else if (handle->transaction_status() != Transaction_status::unstarted)
+      return result;
+
+    const auto started = Clock::now();
+    result.is_in_recovery = recovery_check(*handle);
+    result.latency = std::chrono::duration<double, std::micro>(
+      Clock::now() - started).count();
+    result.is_alive = true;
+  } catch (...) {
+    // The broken connection is closed upon the release of the handle.
+    result = {};
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE std::vector<std::size_t> Routing_pool::candidates__() const
+{
+  struct Candidate final {
+    std::size_t index{};
+    std::size_t busy_count{};
+    double latency{};
+  };
+
+  std::vector<Candidate> candidates;
+  Balancing balancing;
+  {
+    const std::lock_guard lg{mutex_};
+    balancing = balancing_;
+    for (std::size_t i = 0; i < hosts_.size(); ++i) {
+      if (hosts_[i].is_in_rotation)
+        candidates.push_back({i, 0, hosts_[i].latency.value_or(0)});
+    }
+  }
+  for (auto& candidate : candidates)
+    candidate.busy_count = replicas_[candidate.index]->busy_count();
+
+  if (balancing == Balancing::in_flight)
+    std::stable_sort(candidates.begin(), candidates.end(),
+      [](const auto& lhs, const auto& rhs)
+      {
+        return std::tie(lhs.busy_count, lhs.latency) < std::tie(rhs.busy_count, rhs.latency);
+      });
+  else
+    std::stable_sort(candidates.begin(), candidates.end(),
+      [](const auto& lhs, const auto& rhs)
+      {
+        return std::tie(lhs.latency, lhs.busy_count) < std::tie(rhs.latency, rhs.busy_count);
+      });
+
+  std::vector<std::size_t> result;
+  result.reserve(candidates.size());
+  for (const auto& candidate : candidates)
+    result.push_back(candidate.index);
+  return result;
+}
+
+} // namespace dmitigr::pgfe
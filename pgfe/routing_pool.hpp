@@ -0,0 +1,249 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_ROUTING_POOL_HPP
+#define DMITIGR_PGFE_ROUTING_POOL_HPP
+
+#include "connection_pool.hpp"
+#include "dll.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A thread-safe pool of connections to the primary server and to its
+ * replicas which routes the read-only work to the replicas.
+ *
+ * Each host is served by its own Connection_pool. The replicas are moved in
+ * and out of rotation by check(), which verifies that each host is reachable
+ * and is in the expected role (a replica must be in recovery, the primary
+ * must not) and measures the latency of each host.
+ *
+ * @par Example
+ * @code
+ * Routing_pool pool{4, primary_options, {replica1_options, replica2_options}};
+ * pool.connect();
+ * // Periodically (for example, from a timer thread):
+ * pool.check();
+ * // Read-only work is routed to the least loaded replica:
+ * auto handle = pool.connection(Routing_pool::Target::replica);
+ * @endcode
+ */
+class Routing_pool final {
+public:
+  /// A target of the acquired connection.
+  enum class Target {
+    /// The primary server (read-write work).
+    primary,
+
+    /**
+     * The least loaded replica in rotation (read-only work), or the primary
+     * server if there are no replicas in rotation.
+     */
+    replica
+  };
+
+  /// A criterion of the replica selection.
+  enum class Balancing {
+    /// The replica with the least number of busy connections.
+    in_flight,
+
+    /// The replica with the least average latency measured by check().
+    latency
+  };
+
+  /**
+   * @brief An alias of the function which checks the role of the server.
+   *
+   * @returns `true` if the server is in recovery (i.e. it's a replica).
+   */
+  using Recovery_check = std::function<bool(Connection&)>;
+
+  /// The weight of the latest measurement of the latency in its average.
+  static constexpr double latency_smoothing{0.2};
+
+  /// Default-constructible. (Constructs invalid instance.)
+  Routing_pool() = default;
+
+  /**
+   * @brief The constructor.
+   *
+   * @param count A maximum number of connections to each host.
+   * @param primary_options The options of the connections to the primary.
+   * @param replica_options The options of the connections to the replicas.
+   *
+   * @par Effects
+   * `(replica_count() == replica_options.size())`. All of the replicas are
+   * out of rotation until the check().
+   */
+  DMITIGR_PGFE_API Routing_pool(std::size_t count,
+    const Connection_options& primary_options,
+    const std::vector<Connection_options>& replica_options);
+
+  /// @returns `true` if this instance is valid.
+  bool is_valid() const noexcept
+  {
+    return static_cast<bool>(primary_);
+  }
+
+  /// @returns `is_valid()`.
+  explicit operator bool() const noexcept
+  {
+    return is_valid();
+  }
+
+  /// Sets the criterion of the replica selection. (Default is `in_flight`.)
+  DMITIGR_PGFE_API void set_balancing(Balancing value) noexcept;
+
+  /// @returns The criterion of the replica selection.
+  DMITIGR_PGFE_API Balancing balancing() const noexcept;
+
+  /**
+   * @brief Sets the function which checks the role of the server.
+   *
+   * By default, `pg_catalog.pg_is_in_recovery()` is queried.
+   *
+   * @par Requires
+   * `(is_valid() && value)`.
+   */
+  DMITIGR_PGFE_API void set_recovery_check(Recovery_check value) noexcept;
+
+  /// @returns The function which checks the role of the server.
+  DMITIGR_PGFE_API Recovery_check recovery_check() const;
+
+  /**
+   * @brief Connects the pools of all of the hosts and calls check().
+   *
+   * @par Requires
+   * `is_valid()`.
+   *
+   * @throws An exception if the primary cannot be connected. (The replicas
+   * which cannot be connected are just out of rotation.)
+   */
+  DMITIGR_PGFE_API void connect();
+
+  /// Disconnects the pools of all of the hosts.
+  DMITIGR_PGFE_API void disconnect() noexcept;
+
+  /**
+   * @brief Checks each host and moves the replicas in and out of rotation.
+   *
+   * A free connection of each host is used to query the role of the server
+   * (see set_recovery_check()) and to measure the latency. The replica is in
+   * rotation if it's reachable, if its connection is idle (i.e. its
+   * transaction status is `unstarted`) and if it's in recovery. The host
+   * which has no free connections is considered alive. The pool of the host
+   * which is unreachable is reconnected by the next check.
+   *
+   * @returns The number of replicas in rotation.
+   *
+   * @par Requires
+   * `is_valid()`.
+   *
+   * @remarks This function should be called periodically.
+   */
+  DMITIGR_PGFE_API std::size_t check();
+
+  /**
+   * @returns The connection handle of the `target`.
+   *
+   * @param target The target of the connection.
+   * @param timeout Similar to Connection_pool::connection(). (The waiting
+   * happens on the pool of the host selected first.)
+   *
+   * @par Requires
+   * `(is_valid() && (!timeout || timeout->count() >= 0))`.
+   *
+   * @remarks The invalid handle is returned if the primary has been
+   * determined by check() as being in recovery (for example, after failover)
+   * and the `target` is `Target::primary`.
+   */
+  DMITIGR_PGFE_API Connection_pool::Handle connection(Target target,
+    std::optional<std::chrono::milliseconds> timeout = std::chrono::milliseconds{});
+
+  /// @returns The pool of the primary.
+  Connection_pool& primary() noexcept
+  {
+    return *primary_;
+  }
+
+  /// @returns The number of replicas.
+  std::size_t replica_count() const noexcept
+  {
+    return replicas_.size();
+  }
+
+  /**
+   * @returns The pool of the replica.
+   *
+   * @par Requires
+   * `(index < replica_count())`.
+   */
+  DMITIGR_PGFE_API Connection_pool& replica(std::size_t index) noexcept;
+
+  /**
+   * @returns `true` if the replica is in rotation.
+   *
+   * @par Requires
+   * `(index < replica_count())`.
+   */
+  DMITIGR_PGFE_API bool is_in_rotation(std::size_t index) const noexcept;
+
+  /**
+   * @returns The average latency of the replica measured by check(), or
+   * `std::nullopt` if it's not measured yet.
+   *
+   * @par Requires
+   * `(index < replica_count())`.
+   */
+  DMITIGR_PGFE_API std::optional<std::chrono::microseconds>
+  latency(std::size_t index) const noexcept;
+
+  /// @returns `true` if the primary is not in recovery according to check().
+  DMITIGR_PGFE_API bool is_primary_available() const noexcept;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /// A state of the host.
+  struct Host final {
+    bool is_in_rotation{};
+    std::optional<double> latency; // microseconds
+  };
+
+  /// The result of the check of the host.
+  struct Check_result final {
+    bool is_alive{};
+    std::optional<bool> is_in_recovery; // unknown if the host is busy
+    std::optional<double> latency; // microseconds
+  };
+
+  mutable std::mutex mutex_;
+  Balancing balancing_{Balancing::in_flight};
+  Recovery_check recovery_check_;
+  std::unique_ptr<Connection_pool> primary_;
+  bool is_primary_available_{true};
+  std::vector<std::unique_ptr<Connection_pool>> replicas_;
+  std::vector<Host> hosts_; // of replicas
+
+  Check_result check__(Connection_pool& pool, const Recovery_check& recovery_check);
+  std::vector<std::size_t> candidates__() const;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifdef DMITIGR_PGFE_HEADER_ONLY
+#include "routing_pool.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_ROUTING_POOL_HPP
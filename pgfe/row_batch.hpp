@@ -0,0 +1,114 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_ROW_BATCH_HPP
+#define DMITIGR_PGFE_ROW_BATCH_HPP
+
+#include "data.hpp"
+#include "response.hpp"
+#include "row_info.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <string_view>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup main
+ *
+ * @brief A batch of rows produced by a PostgreSQL server.
+ *
+ * All the rows of the batch are stored in the single result retrieved from the
+ * server, therefore the retrieval of the batch of rows costs the same as the
+ * retrieval of the single Row.
+ *
+ * @see Connection::set_row_batch_size(), Connection::row_batch().
+ */
+class Row_batch final : public Response {
+public:
+  /// Default-constructible. (Constructs invalid instance.)
+  Row_batch() = default;
+
+  /// The constructor.
+  template<typename ... Types>
+  explicit Row_batch(Types&& ... args)
+    : info_{std::forward<Types>(args)...}
+  {
+    assert(is_invariant_ok());
+  }
+
+  /// @see Message::is_valid().
+  bool is_valid() const noexcept override
+  {
+    return static_cast<bool>(info_.pq_result_);
+  }
+
+  /// @returns The information about the rows of this batch.
+  const Row_info& info() const noexcept
+  {
+    return info_;
+  }
+
+  /// @returns The number of rows in this batch.
+  std::size_t size() const noexcept
+  {
+    return static_cast<std::size_t>(info_.pq_result_.row_count());
+  }
+
+  /// @returns `(size() == 0)`.
+  bool is_empty() const noexcept
+  {
+    return !size();
+  }
+
+  /**
+   * @returns The field data of the specified row, or invalid instance if NULL.
+   *
+   * @param row The row index.
+   * @param index The field index.
+   *
+   * @par Requires
+   * `(row < size() && index < info().size())`.
+   */
+  Data_view data(const std::size_t row, const std::size_t index = 0) const noexcept
+  {
+    assert(row < size());
+    assert(index < info_.size());
+    const auto rw = static_cast<int>(row);
+    const auto fld = static_cast<int>(index);
+    const auto& r = info_.pq_result_;
+    return !r.is_data_null(rw, fld) ?
+      Data_view{r.data_value(rw, fld), r.data_size(rw, fld), r.field_format(fld)} :
+      Data_view{};
+  }
+
+  /**
+   * @overload
+   *
+   * @param row The row index.
+   * @param name See Compositional.
+   * @param offset See Compositional.
+   *
+   * @par Requires
+   * `(row < size() && info().index_of(name, offset) < info().size())`.
+   */
+  Data_view data(const std::size_t row, const std::string_view name,
+    const std::size_t offset = 0) const noexcept
+  {
+    return data(row, info_.index_of(name, offset));
+  }
+
+private:
+  Row_info info_; // has pq_result_
+
+  bool is_invariant_ok() const noexcept
+  {
+    return detail::pq::is_rows_portion(info_.pq_result_.status());
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#endif  // DMITIGR_PGFE_ROW_BATCH_HPP
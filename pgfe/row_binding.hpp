@@ -0,0 +1,271 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt or pgfe.hpp
+
+#ifndef DMITIGR_PGFE_ROW_BINDING_HPP
+#define DMITIGR_PGFE_ROW_BINDING_HPP
+
+#include "conversions.hpp"
+#include "row.hpp"
+#include "row_batch.hpp"
+#include "row_info.hpp"
+#include "types_fwd.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup conversions
+ *
+ * @brief The binding of the data member of type `M` of the class `T` to the
+ * column of a row.
+ *
+ * @see bind_column(), Row_binding.
+ */
+template<class T, typename M>
+struct Column_binding final {
+  /// The column name.
+  std::string_view name;
+
+  /// The pointer to the data member.
+  M T::* member{};
+};
+
+/**
+ * @ingroup conversions
+ *
+ * @returns The binding of the data member `member` to the column `name`.
+ */
+template<class T, typename M>
+constexpr Column_binding<T, M> bind_column(const std::string_view name, M T::* const member) noexcept
+{
+  return {name, member};
+}
+
+/**
+ * @ingroup conversions
+ *
+ * @brief The binding of the data members of the user type `T` to the columns
+ * of a row.
+ *
+ * @details The specialization must provide the function
+ * `static constexpr auto columns()` which returns the `std::tuple` of the
+ * column bindings (created by bind_column()). For example:
+ * @code
+ * struct Person {
+ *   int id;
+ *   std::string name;
+ *   std::optional<int> age;
+ * };
+ *
+ * template<> struct Row_binding<Person> {
+ *   static constexpr auto columns()
+ *   {
+ *     return std::make_tuple(bind_column("id", &Person::id),
+ *       bind_column("name", &Person::name),
+ *       bind_column("age", &Person::age));
+ *   }
+ * };
+ * @endcode
+ *
+ * @see Row_decoder.
+ */
+template<typename> struct Row_binding;
+
+/**
+ * @ingroup conversions
+ *
+ * @brief The decoder of the rows to the objects of type `T` according to the
+ * specialization of Row_binding.
+ *
+ * The indexes of the columns are resolved by names once per result (i.e. when
+ * the first row of the result is decoded), so the rows are decoded by indexes
+ * without comparing the column names. Each field is converted by using `to()`
+ * directly from the view of the row data, without the intermediate Data
+ * objects.
+ *
+ * @par Example
+ * @code
+ * std::vector<Person> persons;
+ * Row_decoder<Person> decoder;
+ * conn.execute([&](auto&& row)
+ * {
+ *   persons.push_back(decoder.decode(row));
+ * }, "select id, name, age from person");
+ * @endcode
+ *
+ * @remarks The instance of this class is intended to be used by a single
+ * thread.
+ */
+template<typename T>
+class Row_decoder final {
+public:
+  /// The number of the bound columns.
+  static constexpr std::size_t column_count{
+    std::tuple_size_v<decltype(Row_binding<T>::columns())>};
+
+  /// Default-constructible.
+  Row_decoder() = default;
+
+  /**
+   * @brief The constructor.
+   *
+   * @par Effects
+   * `is_resolved()`.
+   *
+   * @see resolve().
+   */
+  explicit Row_decoder(const Row_info& info)
+  {
+    resolve(info);
+  }
+
+  /**
+   * @brief Resolves the indexes of the bound columns by using `info`.
+   *
+   * @par Requires
+   * `info`.
+   *
+   * @throws `std::runtime_error` if the bound column is missing in `info`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void resolve(const Row_info& info)
+  {
+    assert(info);
+    std::array<std::size_t, column_count> indexes;
+    resolve__(info, indexes, std::make_index_sequence<column_count>{});
+    indexes_ = indexes;
+    field_names_ = info.shared_field_names_;
+  }
+
+  /// @returns `true` if the indexes of the bound columns are resolved.
+  bool is_resolved() const noexcept
+  {
+    return static_cast<bool>(field_names_);
+  }
+
+  /**
+   * @returns The index of the column bound to the data member at `index` in
+   * the tuple returned by `Row_binding<T>::columns()`.
+   *
+   * @par Requires
+   * `(is_resolved() && index < column_count)`.
+   */
+  std::size_t column_index(const std::size_t index) const noexcept
+  {
+    assert(is_resolved() && index < column_count);
+    return indexes_[index];
+  }
+
+  /**
+   * @brief Decodes the `row` into the `result`.
+   *
+   * @par Requires
+   * `row`.
+   *
+   * @par Effects
+   * The indexes of the bound columns are resolved if the `row` belongs to a
+   * result other than the one for which they're resolved.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  void decode(const Row& row, T& result)
+  {
+    assert(row);
+    if (row.info().shared_field_names_ != field_names_)
+      resolve(row.info());
+    decode__(result, std::make_index_sequence<column_count>{},
+      [&row](const std::size_t index) { return row.data(index); });
+  }
+
+  /// @overload
+  T decode(const Row& row)
+  {
+    T result{};
+    decode(row, result);
+    return result;
+  }
+
+  /**
+   * @brief Decodes the row at `row_index` of the `batch` into the `result`.
+   *
+   * @par Requires
+   * `(batch && row_index < batch.size())`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  void decode(const Row_batch& batch, const std::size_t row_index, T& result)
+  {
+    assert(batch && row_index < batch.size());
+    if (batch.info().shared_field_names_ != field_names_)
+      resolve(batch.info());
+    decode__(result, std::make_index_sequence<column_count>{},
+      [&batch, row_index](const std::size_t index) { return batch.data(row_index, index); });
+  }
+
+  /// @overload
+  T decode(const Row_batch& batch, const std::size_t row_index)
+  {
+    T result{};
+    decode(batch, row_index, result);
+    return result;
+  }
+
+  /// @returns `decode(row)`.
+  T operator()(const Row& row)
+  {
+    return decode(row);
+  }
+
+private:
+  std::array<std::size_t, column_count> indexes_{};
+  std::shared_ptr<detail::Field_names> field_names_; // identifies the result
+
+  template<std::size_t ... I>
+  static void resolve__(const Row_info& info, std::array<std::size_t, column_count>& indexes,
+    std::index_sequence<I...>)
+  {
+    constexpr auto columns = Row_binding<T>::columns();
+    ((indexes[I] = index_of__(info, std::get<I>(columns).name)), ...);
+  }
+
+  static std::size_t index_of__(const Row_info& info, const std::string_view name)
+  {
+    const auto result = info.index_of(name);
+    if (result == info.size())
+      throw std::runtime_error{"no column \"" + std::string{name} + "\" to bind"};
+    return result;
+  }
+
+  template<std::size_t ... I, typename F>
+  void decode__(T& result, std::index_sequence<I...>, const F& data) const
+  {
+    constexpr auto columns = Row_binding<T>::columns();
+    ((decode_field__(result.*(std::get<I>(columns).member), data(indexes_[I]))), ...);
+  }
+
+  template<typename M>
+  static void decode_field__(M& member, const Data_view& data)
+  {
+    member = to<M>(data);
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#endif  // DMITIGR_PGFE_ROW_BINDING_HPP
@@ -10,6 +10,59 @@
 
 namespace dmitigr::pgfe {
 
+// -----------------------------------------------------------------------------
+// Field_names
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE detail::Field_names::Field_names(const pq::Result& pq_result)
+{
+  assert(pq_result);
+  const auto fc = static_cast<std::size_t>(pq_result.field_count());
+  names_.reserve(fc);
+  for (std::size_t i = 0; i < fc; ++i)
+    names_.emplace_back(pq_result.field_name(static_cast<int>(i)));
+
+  // The load factor is at most 0.5.
+  std::size_t bucket_count{8};
+  while (bucket_count < 2*fc)
+    bucket_count *= 2;
+  buckets_.resize(bucket_count);
+  next_.resize(fc, static_cast<std::uint32_t>(fc));
+
+  // Fill in the reverse order to link each field with the next one of the same name.
+  for (auto i = fc; i--;) {
+    for (auto b = bucket_of(names_[i]);; b = (b + 1) & (bucket_count - 1)) {
+      if (!buckets_[b]) {
+        buckets_[b] = static_cast<std::uint32_t>(i + 1);
+        break;
+      } else if (names_[buckets_[b] - 1] == names_[i]) {
+        next_[i] = buckets_[b] - 1;
+        buckets_[b] = static_cast<std::uint32_t>(i + 1);
+        break;
+      }
+    }
+  }
+}
+
+DMITIGR_PGFE_INLINE std::size_t detail::Field_names::index_of(const std::string_view name,
+  const std::size_t offset) const noexcept
+{
+  const auto sz = size();
+  const auto mask = buckets_.size() - 1;
+  for (auto b = bucket_of(name); buckets_[b]; b = (b + 1) & mask) {
+    if (std::size_t i = buckets_[b] - 1; names_[i] == name) {
+      while (i < offset && i < sz)
+        i = next_[i];
+      return i;
+    }
+  }
+  return sz;
+}
+
+// -----------------------------------------------------------------------------
+// Row_info
+// -----------------------------------------------------------------------------
+
 DMITIGR_PGFE_INLINE Row_info::Row_info(detail::pq::Result&& pq_result)
   : pq_result_(std::move(pq_result))
   , shared_field_names_(make_shared_field_names(pq_result_)) // note pq_result_
@@ -18,23 +71,17 @@ DMITIGR_PGFE_INLINE Row_info::Row_info(detail::pq::Result&& pq_result)
 }
 
 DMITIGR_PGFE_INLINE Row_info::Row_info(detail::pq::Result&& pq_result,
-  const std::shared_ptr<std::vector<std::string>>& shared_field_names)
+  const std::shared_ptr<detail::Field_names>& shared_field_names)
   : pq_result_(std::move(pq_result))
   , shared_field_names_(shared_field_names)
 {
   assert(is_invariant_ok());
 }
 
-std::shared_ptr<std::vector<std::string>> Row_info::make_shared_field_names(const detail::pq::Result& pq_result)
+DMITIGR_PGFE_INLINE std::shared_ptr<detail::Field_names>
+Row_info::make_shared_field_names(const detail::pq::Result& pq_result)
 {
-  assert(pq_result);
-  const int fc = pq_result.field_count();
-  std::vector<std::string> result;
-  result.reserve(static_cast<unsigned>(fc));
-  for (int i = 0; i < fc; ++i)
-    result.emplace_back(pq_result.field_name(i));
-
-  return std::make_shared<decltype(result)>(std::move(result));
+  return std::make_shared<detail::Field_names>(pq_result);
 }
 
 DMITIGR_PGFE_INLINE std::string_view Row_info::name_of(const std::size_t index) const noexcept
@@ -45,12 +92,7 @@ DMITIGR_PGFE_INLINE std::string_view Row_info::name_of(const std::size_t index)
 
 DMITIGR_PGFE_INLINE std::size_t Row_info::index_of(const std::string_view name, const std::size_t offset) const noexcept
 {
-  const auto sz = shared_field_names_->size();
-  const auto b = shared_field_names_->cbegin();
-  const auto e = shared_field_names_->cend();
-  using Diff = decltype(b)::difference_type;
-  const auto i = std::find(std::min(b + static_cast<Diff>(offset), b + static_cast<Diff>(sz)), e, name);
-  return static_cast<std::size_t>(i - b);
+  return shared_field_names_->index_of(name, offset);
 }
 
 DMITIGR_PGFE_INLINE std::uint_fast32_t Row_info::table_oid(const std::size_t index) const noexcept
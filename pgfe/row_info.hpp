@@ -10,9 +10,62 @@
 #include "pq.hpp"
 
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace dmitigr::pgfe {
 
+namespace detail {
+
+/**
+ * @brief The field names of a result with the hash index to look up the
+ * fields by names in constant time on average.
+ *
+ * The instance is created once per result description and shared across all
+ * the rows of the result.
+ */
+class Field_names final {
+public:
+  /// The constructor.
+  explicit DMITIGR_PGFE_API Field_names(const pq::Result& pq_result);
+
+  /// @returns The number of fields.
+  std::size_t size() const noexcept
+  {
+    return names_.size();
+  }
+
+  /// @returns `true` if there are no fields.
+  bool empty() const noexcept
+  {
+    return names_.empty();
+  }
+
+  /// @returns The name of the field at `index`.
+  const std::string& operator[](const std::size_t index) const noexcept
+  {
+    return names_[index];
+  }
+
+  /// @returns The index of the field `name` starting from `offset`, or `size()`.
+  DMITIGR_PGFE_API std::size_t index_of(std::string_view name, std::size_t offset) const noexcept;
+
+private:
+  std::vector<std::string> names_;
+  std::vector<std::uint32_t> buckets_; // index of the first field + 1, or 0 if empty
+  std::vector<std::uint32_t> next_; // index of the next field with the same name, or size()
+
+  std::size_t bucket_of(const std::string_view name) const noexcept
+  {
+    return std::hash<std::string_view>{}(name) & (buckets_.size() - 1);
+  }
+};
+
+} // namespace detail
+
 /**
  * @ingroup main
  *
@@ -29,7 +82,7 @@ public:
 
   /// @overload
   DMITIGR_PGFE_API Row_info(detail::pq::Result&& pq_result,
-    const std::shared_ptr<std::vector<std::string>>& shared_field_names);
+    const std::shared_ptr<detail::Field_names>& shared_field_names);
 
   /// Non copy-constructible.
   Row_info(const Row_info&) = delete;
@@ -243,9 +296,11 @@ private:
   friend Connection;
   friend Prepared_statement;
   friend Row;
+  friend Row_batch;
+  template<typename> friend class Row_decoder;
 
   detail::pq::Result pq_result_;
-  std::shared_ptr<std::vector<std::string>> shared_field_names_;
+  std::shared_ptr<detail::Field_names> shared_field_names_;
 
   bool is_invariant_ok() const override
   {
@@ -265,8 +320,8 @@ private:
     return size_ok && field_names_ok && Compositional::is_invariant_ok();
   }
 
-  /// @returns The shared vector of field names to use across multiple rows.
-  static std::shared_ptr<std::vector<std::string>> make_shared_field_names(const detail::pq::Result& pq_result);
+  /// @returns The shared field names to use across multiple rows.
+  static std::shared_ptr<detail::Field_names> make_shared_field_names(const detail::pq::Result& pq_result);
 };
 
 } // namespace dmitigr::pgfe
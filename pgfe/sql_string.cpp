@@ -5,15 +5,105 @@
 #include "data.hpp"
 #include "sql_string.hpp"
 
-#include <memory>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace dmitigr::pgfe {
 
+// -----------------------------------------------------------------------------
+// Parse cache
+// -----------------------------------------------------------------------------
+
+/// Represents the process-wide cache of the parsed SQL strings.
+struct Sql_string::Parse_cache final {
+  /// @returns The instance of the cache.
+  static Parse_cache& instance()
+  {
+    static Parse_cache result;
+    return result;
+  }
+
+  /// @returns The parsed `text`.
+  Sql_string parse(const std::string_view text, const std::locale& loc)
+  {
+    const bool is_cacheable = (loc == std::locale::classic());
+    if (is_cacheable) {
+      const std::lock_guard lg{mutex_};
+      if (const auto i = entries_.find(text); i != cend(entries_))
+        return i->second->value;
+    }
+
+    auto result = parse_sql_input(text, loc).first;
+
+    if (is_cacheable) {
+      const std::lock_guard lg{mutex_};
+      if (capacity_) {
+        if (entries_.size() >= capacity_)
+          entries_.clear();
+        auto entry = std::make_unique<Entry>(Entry{std::string{text}, result});
+        const std::string_view key{entry->text};
+        entries_.emplace(key, std::move(entry));
+      }
+    }
+    return result;
+  }
+
+  void set_capacity(const std::size_t capacity)
+  {
+    const std::lock_guard lg{mutex_};
+    if (entries_.size() > capacity)
+      entries_.clear();
+    capacity_ = capacity;
+  }
+
+  std::size_t capacity() const
+  {
+    const std::lock_guard lg{mutex_};
+    return capacity_;
+  }
+
+  std::size_t size() const
+  {
+    const std::lock_guard lg{mutex_};
+    return entries_.size();
+  }
+
+private:
+  struct Entry final {
+    std::string text;
+    Sql_string value;
+  };
+
+  mutable std::mutex mutex_;
+  std::size_t capacity_{256};
+  std::unordered_map<std::string_view, std::unique_ptr<Entry>> entries_; // keys are views of Entry::text
+};
+
+DMITIGR_PGFE_INLINE void Sql_string::set_parse_cache_capacity(const std::size_t capacity)
+{
+  Parse_cache::instance().set_capacity(capacity);
+}
+
+DMITIGR_PGFE_INLINE std::size_t Sql_string::parse_cache_capacity()
+{
+  return Parse_cache::instance().capacity();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Sql_string::parse_cache_size()
+{
+  return Parse_cache::instance().size();
+}
+
+// -----------------------------------------------------------------------------
+// Sql_string
+// -----------------------------------------------------------------------------
+
 DMITIGR_PGFE_INLINE Sql_string::Sql_string(const std::string_view text)
 {
-  auto s = parse_sql_input(text, loc_).first;
+  auto s = Parse_cache::instance().parse(text, loc_);
   swap(s);
   assert(is_invariant_ok());
 }
@@ -27,13 +117,13 @@ DMITIGR_PGFE_INLINE Sql_string::Sql_string(const char* const text)
 {}
 
 DMITIGR_PGFE_INLINE Sql_string::Sql_string(const Sql_string& rhs)
-  : fragments_{rhs.fragments_}
+  : text_{rhs.text_}
+  , fragments_{rhs.fragments_}
   , positional_parameters_{rhs.positional_parameters_}
+  , named_parameters_{rhs.named_parameters_}
   , is_extra_data_should_be_extracted_from_comments_{rhs.is_extra_data_should_be_extracted_from_comments_}
   , extra_{rhs.extra_}
-{
-  named_parameters_ = named_parameters();
-}
+{}
 
 DMITIGR_PGFE_INLINE Sql_string& Sql_string::operator=(const Sql_string& rhs)
 {
@@ -45,13 +135,13 @@ DMITIGR_PGFE_INLINE Sql_string& Sql_string::operator=(const Sql_string& rhs)
 }
 
 DMITIGR_PGFE_INLINE Sql_string::Sql_string(Sql_string&& rhs) noexcept
-  : fragments_{std::move(rhs.fragments_)}
+  : text_{std::move(rhs.text_)}
+  , fragments_{std::move(rhs.fragments_)}
   , positional_parameters_{std::move(rhs.positional_parameters_)}
+  , named_parameters_{std::move(rhs.named_parameters_)}
   , is_extra_data_should_be_extracted_from_comments_{std::move(rhs.is_extra_data_should_be_extracted_from_comments_)}
   , extra_{std::move(rhs.extra_)}
-{
-  named_parameters_ = named_parameters();
-}
+{}
 
 DMITIGR_PGFE_INLINE Sql_string& Sql_string::operator=(Sql_string&& rhs) noexcept
 {
@@ -64,6 +154,7 @@ DMITIGR_PGFE_INLINE Sql_string& Sql_string::operator=(Sql_string&& rhs) noexcept
 
 DMITIGR_PGFE_INLINE void Sql_string::swap(Sql_string& rhs) noexcept
 {
+  text_.swap(rhs.text_);
   fragments_.swap(rhs.fragments_);
   positional_parameters_.swap(rhs.positional_parameters_);
   named_parameters_.swap(rhs.named_parameters_);
@@ -76,7 +167,7 @@ DMITIGR_PGFE_INLINE bool Sql_string::is_query_empty() const noexcept
   return all_of(cbegin(fragments_), cend(fragments_),
     [this](const Fragment& f)
     {
-      return is_comment(f) || (is_text(f) && is_blank_string(f.str, loc_));
+      return is_comment(f) || (is_text(f) && is_blank_string(str(f), loc_));
     });
 }
 
@@ -85,15 +176,24 @@ DMITIGR_PGFE_INLINE void Sql_string::append(const Sql_string& appendix)
   const bool was_query_empty = is_query_empty();
 
   // Updating fragments
-  auto old_fragments = fragments_;
+  const auto old_text_size = text_.size();
+  const auto old_fragment_count = fragments_.size();
+  const auto appendix_fragment_count = appendix.fragments_.size(); // appendix can be *this
   try {
-    fragments_.insert(cend(fragments_), cbegin(appendix.fragments_), cend(appendix.fragments_));
+    text_.append(appendix.text_);
+    fragments_.reserve(old_fragment_count + appendix_fragment_count);
+    for (std::size_t i = 0; i < appendix_fragment_count; ++i) {
+      auto fragment = appendix.fragments_[i];
+      fragment.offset += old_text_size;
+      fragments_.push_back(fragment);
+    }
     update_cache(appendix); // can throw (strong exception safety guarantee)
 
     if (was_query_empty)
       is_extra_data_should_be_extracted_from_comments_ = true;
   } catch (...) {
-    fragments_.swap(old_fragments); // rollback
+    text_.resize(old_text_size); // rollback
+    fragments_.erase(cbegin(fragments_) + static_cast<std::ptrdiff_t>(old_fragment_count), cend(fragments_));
     throw;
   }
 
@@ -105,22 +205,33 @@ DMITIGR_PGFE_INLINE void Sql_string::replace_parameter(const std::string_view na
   assert(parameter_index(name) < parameter_count());
   assert(this != &replacement);
 
+  // Building the new fragments (`name` can refer to the text_).
+  std::string text;
+  text.reserve(text_.size() + replacement.text_.size());
+  Fragment_vector fragments;
+  fragments.reserve(fragments_.size() + replacement.fragments_.size());
+  const auto push_back = [&text, &fragments](Fragment fragment, const std::string_view str)
+  {
+    fragment.offset = text.size();
+    fragments.push_back(fragment);
+    text.append(str);
+  };
+  for (const auto& fragment : fragments_) {
+    if (fragment.type == Fragment::Type::named_parameter && str(fragment) == name) {
+      for (const auto& rfragment : replacement.fragments_)
+        push_back(rfragment, replacement.str(rfragment));
+    } else
+      push_back(fragment, str(fragment));
+  }
+
   // Updating fragments
-  auto old_fragments = fragments_;
+  text_.swap(text);
+  fragments_.swap(fragments);
   try {
-    for (auto fi = begin(fragments_); fi != end(fragments_);) {
-      if (fi->type == Fragment::Type::named_parameter && fi->str == name) {
-        // Firstly, we'll insert the `replacement` just before `fi`.
-        fragments_.insert(fi, cbegin(replacement.fragments_), cend(replacement.fragments_));
-        // Secondly, we'll erase named parameter pointed by `fi` and got the next iterator.
-        fi = fragments_.erase(fi);
-      } else
-        ++fi;
-    }
-
     update_cache(replacement);  // can throw (strong exception safety guarantee)
   } catch (...) {
-    fragments_.swap(old_fragments);
+    text_.swap(text); // rollback
+    fragments_.swap(fragments);
     throw;
   }
 
@@ -130,50 +241,49 @@ DMITIGR_PGFE_INLINE void Sql_string::replace_parameter(const std::string_view na
 DMITIGR_PGFE_INLINE std::string Sql_string::to_string() const
 {
   std::string result;
-  result.reserve(512);
+  result.reserve(text_.size() + 4*fragments_.size());
   for (const auto& fragment : fragments_) {
     switch (fragment.type) {
     case Fragment::Type::text:
-      result += fragment.str;
+      result += str(fragment);
       break;
     case Fragment::Type::one_line_comment:
       result += "--";
-      result += fragment.str;
+      result += str(fragment);
       result += '\n';
       break;
     case Fragment::Type::multi_line_comment:
       result += "/*";
-      result += fragment.str;
+      result += str(fragment);
       result += "*/";
       break;
     case Fragment::Type::named_parameter:
       result += ':';
-      result += fragment.str;
+      result += str(fragment);
       break;
     case Fragment::Type::positional_parameter:
       result += '$';
-      result += fragment.str;
+      result += str(fragment);
       break;
     }
   }
-  result.shrink_to_fit();
   return result;
 }
 
 DMITIGR_PGFE_INLINE std::string Sql_string::to_query_string() const
 {
   std::string result;
-  result.reserve(512);
+  result.reserve(text_.size() + 4*fragments_.size());
   for (const auto& fragment : fragments_) {
     switch (fragment.type) {
     case Fragment::Type::text:
-      result += fragment.str;
+      result += str(fragment);
       break;
     case Fragment::Type::one_line_comment:
     case Fragment::Type::multi_line_comment:
       break;
     case Fragment::Type::named_parameter: {
-      const auto idx = named_parameter_index(fragment.str);
+      const auto idx = named_parameter_index(str(fragment));
       assert(idx < parameter_count());
       result += '$';
       result += std::to_string(idx + 1);
@@ -181,7 +291,7 @@ DMITIGR_PGFE_INLINE std::string Sql_string::to_query_string() const
     }
     case Fragment::Type::positional_parameter:
       result += '$';
-      result += fragment.str;
+      result += str(fragment);
       break;
     }
   }
@@ -204,16 +314,17 @@ public:
   /// Denotes the fragment type.
   using Fragment = Sql_string::Fragment;
 
-  /// Denotes the fragment list type.
-  using Fragment_list = Sql_string::Fragment_list;
+  /// Denotes the fragment vector type.
+  using Fragment_vector = Sql_string::Fragment_vector;
 
   /// @returns The vector of associated extra data.
-  static std::vector<std::pair<Key, Value>> extract(const Fragment_list& fragments, const std::locale& loc)
+  static std::vector<std::pair<Key, Value>> extract(const Sql_string& sql)
   {
     std::vector<std::pair<Key, Value>> result;
-    const auto iters = first_related_comments(fragments, loc);
-    if (iters.first != cend(fragments)) {
-      const auto comments = joined_comments(iters.first, iters.second);
+    const auto& loc = sql.loc_;
+    const auto iters = first_related_comments(sql);
+    if (iters.first != cend(sql.fragments_)) {
+      const auto comments = joined_comments(sql, iters.first, iters.second);
       for (const auto& comment : comments) {
         auto associations = extract(comment.first, comment.second, loc);
         result.reserve(result.capacity() + associations.size());
@@ -457,9 +568,11 @@ private:
    *
    * @returns The pair of iterators that specifies the range of relevant comments.
    */
-  std::pair<Fragment_list::const_iterator, Fragment_list::const_iterator>
-  static first_related_comments(const Fragment_list& fragments, const std::locale& loc)
+  std::pair<Fragment_vector::const_iterator, Fragment_vector::const_iterator>
+  static first_related_comments(const Sql_string& sql)
   {
+    const auto& fragments = sql.fragments_;
+    const auto& loc = sql.loc_;
     const auto b = cbegin(fragments);
     const auto e = cend(fragments);
     auto result = std::make_pair(e, e);
@@ -482,9 +595,9 @@ private:
      * Stops lookup when either named parameter or positional parameter are found.
      * (Only fragments of type `text` can have related comments.)
      */
-    auto i = find_if(b, e, [&loc, &is_nearby_string](const Fragment& f)
+    auto i = find_if(b, e, [&sql, &loc, &is_nearby_string](const Fragment& f)
     {
-      return (f.type == Fragment::Type::text && is_nearby_string(f.str, loc) && !is_blank_string(f.str, loc)) ||
+      return (f.type == Fragment::Type::text && is_nearby_string(sql.str(f), loc) && !is_blank_string(sql.str(f), loc)) ||
         f.type == Fragment::Type::named_parameter ||
         f.type == Fragment::Type::positional_parameter;
     });
@@ -492,9 +605,9 @@ private:
       result.second = i;
       do {
         --i;
-        assert(is_comment(*i) || (is_text(*i) && is_blank_string(i->str, loc)));
+        assert(is_comment(*i) || (is_text(*i) && is_blank_string(sql.str(*i), loc)));
         if (i->type == Fragment::Type::text) {
-          if (!is_nearby_string(i->str, loc))
+          if (!is_nearby_string(sql.str(*i), loc))
             break;
         }
         result.first = i;
@@ -512,14 +625,15 @@ private:
    *   - the iterator that points to the fragment that follows the last comment
    *     appended to the result.
    */
-  std::pair<std::pair<std::string, Extra::Comment_type>, Fragment_list::const_iterator>
-  static joined_comments_of_same_type(Fragment_list::const_iterator i, const Fragment_list::const_iterator e)
+  std::pair<std::pair<std::string, Extra::Comment_type>, Fragment_vector::const_iterator>
+  static joined_comments_of_same_type(const Sql_string& sql,
+    Fragment_vector::const_iterator i, const Fragment_vector::const_iterator e)
   {
     assert(is_comment(*i));
     std::string result;
     const auto fragment_type = i->type;
-    for (; i->type == fragment_type && i != e; ++i) {
-      result.append(i->str);
+    for (; i != e && i->type == fragment_type; ++i) {
+      result.append(sql.str(*i));
       if (fragment_type == Fragment::Type::one_line_comment)
         result.append("\n");
     }
@@ -544,12 +658,13 @@ private:
    *   - the type of the joined comments as second element.
    */
   std::vector<std::pair<std::string, Extra::Comment_type>>
-  static joined_comments(Fragment_list::const_iterator i, const Fragment_list::const_iterator e)
+  static joined_comments(const Sql_string& sql,
+    Fragment_vector::const_iterator i, const Fragment_vector::const_iterator e)
   {
     std::vector<std::pair<std::string, Extra::Comment_type>> result;
     while (i != e) {
       if (is_comment(*i)) {
-        auto comments = joined_comments_of_same_type(i, e);
+        auto comments = joined_comments_of_same_type(sql, i, e);
         result.push_back(std::move(comments.first));
         i = comments.second;
       } else
@@ -561,11 +676,14 @@ private:
 
 const Composite& Sql_string::extra() const
 {
-  if (!extra_)
-    extra_.emplace(Extra::extract(fragments_, loc_));
-  else if (is_extra_data_should_be_extracted_from_comments_)
-    extra_->append(Composite{Extra::extract(fragments_, loc_)});
-  is_extra_data_should_be_extracted_from_comments_ = false;
+  // Once extracted, the extra data is only read. (Sql_vector relies on it.)
+  if (!extra_) {
+    extra_.emplace(Extra::extract(*this));
+    is_extra_data_should_be_extracted_from_comments_ = false;
+  } else if (is_extra_data_should_be_extracted_from_comments_) {
+    extra_->append(Composite{Extra::extract(*this)});
+    is_extra_data_should_be_extracted_from_comments_ = false;
+  }
   assert(is_invariant_ok());
   return *extra_;
 }
@@ -574,14 +692,14 @@ const Composite& Sql_string::extra() const
 // Initializers
 // ---------------------------------------------------------------------------
 
-void Sql_string::push_positional_parameter(const std::string& str)
+void Sql_string::push_positional_parameter(const std::string_view str)
 {
   push_back_fragment(Fragment::Type::positional_parameter, str);
 
   using Size = std::vector<bool>::size_type;
-  const int position = stoi(str);
+  const int position = std::stoi(std::string{str});
   if (position < 1 || static_cast<Size>(position) > max_parameter_count())
-    throw std::runtime_error{"invalid parameter position \"" + str + "\""};
+    throw std::runtime_error{"invalid parameter position \"" + std::string{str} + "\""};
   else if (static_cast<Size>(position) > positional_parameters_.size())
     positional_parameters_.resize(static_cast<Size>(position), false);
 
@@ -590,16 +708,13 @@ void Sql_string::push_positional_parameter(const std::string& str)
   assert(is_invariant_ok());
 }
 
-void Sql_string::push_named_parameter(const std::string& str)
+void Sql_string::push_named_parameter(const std::string_view str)
 {
   if (parameter_count() < max_parameter_count()) {
     push_back_fragment(Fragment::Type::named_parameter, str);
     if (none_of(cbegin(named_parameters_), cend(named_parameters_),
-        [&str](const auto& i) { return (i->str == str); })) {
-      auto e = cend(fragments_);
-      --e;
-      named_parameters_.push_back(e);
-    }
+        [this, &str](const auto i) { return (this->str(fragments_[i]) == str); }))
+      named_parameters_.push_back(fragments_.size() - 1);
   } else
     throw std::runtime_error{"maximum parameters count (" + std::to_string(max_parameter_count()) + ") exceeded"};
 
@@ -651,15 +766,15 @@ void Sql_string::update_cache(const Sql_string& rhs)
 // Generators
 // ---------------------------------------------------------------------------
 
-auto Sql_string::unique_fragments(const Fragment::Type type) const
-  -> std::vector<Fragment_list::const_iterator>
+std::vector<std::size_t> Sql_string::unique_fragments(const Fragment::Type type) const
 {
-  std::vector<Fragment_list::const_iterator> result;
+  std::vector<std::size_t> result;
   result.reserve(8);
-  const auto e = cend(fragments_);
-  for (auto i = cbegin(fragments_); i != e; ++i) {
-    if (i->type == type) {
-      if (none_of(cbegin(result), cend(result), [&i](const auto& result_i) { return (i->str == result_i->str); }))
+  const auto fragment_count = fragments_.size();
+  for (std::size_t i = 0; i < fragment_count; ++i) {
+    if (fragments_[i].type == type) {
+      const auto s = str(fragments_[i]);
+      if (none_of(cbegin(result), cend(result), [this, &s](const auto ri) { return (s == str(fragments_[ri])); }))
         result.push_back(i);
     }
   }
@@ -667,12 +782,12 @@ auto Sql_string::unique_fragments(const Fragment::Type type) const
 }
 
 std::size_t Sql_string::unique_fragment_index(
-  const std::vector<Fragment_list::const_iterator>& unique_fragments,
+  const std::vector<std::size_t>& unique_fragments,
   const std::string_view str) const noexcept
 {
   const auto b = cbegin(unique_fragments);
   const auto e = cend(unique_fragments);
-  const auto i = find_if(b, e, [&str](const auto& pi) { return (pi->str == str); });
+  const auto i = find_if(b, e, [this, &str](const auto fi) { return (this->str(fragments_[fi]) == str); });
   return static_cast<std::size_t>(i - b);
 }
 
@@ -1102,12 +1217,12 @@ Sql_string::parse_sql_input(const std::string_view text, const std::locale& loc)
   default: {
     std::string message{"invalid SQL input"};
     if (!result.fragments_.empty())
-      message.append(" follows after: ").append(result.fragments_.back().str);
+      message.append(" follows after: ").append(result.str(result.fragments_.back()));
     throw std::runtime_error{message};
   }
   }
 
-  return std::make_pair(result, i - b);
+  return std::make_pair(std::move(result), i - b);
 }
 
 } // namespace dmitigr::pgfe
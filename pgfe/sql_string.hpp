@@ -14,8 +14,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
-#include <list>
 #include <locale>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -129,7 +129,7 @@ public:
   std::string_view parameter_name(const std::size_t index) const noexcept override
   {
     assert(positional_parameter_count() <= index && index < parameter_count());
-    return (named_parameters_[index - positional_parameter_count()])->str;
+    return str(fragments_[named_parameters_[index - positional_parameter_count()]]);
   }
 
   /// @see Parameterizable::parameter_index().
@@ -315,9 +315,41 @@ public:
   /// @overload
   DMITIGR_PGFE_API const Composite& extra() const;
 
+  /// @name Parse cache
+  /// @{
+
+  /**
+   * @brief Sets the capacity of the process-wide cache of the parsed SQL
+   * strings.
+   *
+   * The cache is used by the constructors of this class which accepts the
+   * text to parse, so the repeated construction from the same text costs
+   * just a copy of the cached instance. The cache is cleared when its
+   * capacity is reached. The value of `0` disables the cache. (The default
+   * capacity is 256 entries.)
+   *
+   * @par Thread safety
+   * Thread-safe.
+   *
+   * @remarks The cache is not used if the global locale is not the classic
+   * ("C") one.
+   */
+  static DMITIGR_PGFE_API void set_parse_cache_capacity(std::size_t capacity);
+
+  /// @returns The capacity of the process-wide cache of the parsed SQL strings.
+  static DMITIGR_PGFE_API std::size_t parse_cache_capacity();
+
+  /// @returns The number of the entries of the process-wide cache of the parsed SQL strings.
+  static DMITIGR_PGFE_API std::size_t parse_cache_size();
+
+  /// @}
+
 private:
   friend Sql_vector;
 
+  /// Represents the process-wide cache of the parsed SQL strings.
+  struct Parse_cache;
+
   static DMITIGR_PGFE_API std::pair<Sql_string, std::string_view::size_type>
   parse_sql_input(std::string_view, const std::locale& loc);
 
@@ -330,20 +362,17 @@ private:
       positional_parameter
     };
 
-    Fragment(const Type tp, const std::string& s)
-      : type(tp)
-      , str(s)
-    {}
-
-    Type type;
-    std::string str;
+    Type type{};
+    std::string::size_type offset{}; // in text_
+    std::string::size_type size{};
   };
-  using Fragment_list = std::list<Fragment>;
+  using Fragment_vector = std::vector<Fragment>;
 
   std::locale loc_;
-  Fragment_list fragments_;
+  std::string text_; // the contents of all the fragments
+  Fragment_vector fragments_;
   std::vector<bool> positional_parameters_; // cache
-  std::vector<Fragment_list::const_iterator> named_parameters_; // cache
+  std::vector<std::size_t> named_parameters_; // cache (indexes of fragments_)
   mutable bool is_extra_data_should_be_extracted_from_comments_{true};
   mutable std::optional<Composite> extra_; // cache
 
@@ -354,6 +383,8 @@ private:
     const bool parameters_ok = ((parameter_count() > 0) == has_parameters());
     const bool parameters_count_ok = (parameter_count() == (positional_parameter_count() + named_parameter_count()));
     const bool empty_ok = !is_empty() || !has_parameters();
+    const bool text_ok = fragments_.empty() ||
+      (fragments_.back().offset + fragments_.back().size == text_.size());
     const bool extra_ok = is_extra_data_should_be_extracted_from_comments_ || extra_;
     const bool parameterizable_ok = Parameterizable::is_invariant_ok();
 
@@ -363,37 +394,46 @@ private:
       parameters_ok &&
       parameters_count_ok &&
       empty_ok &&
+      text_ok &&
       extra_ok &&
       parameterizable_ok;
   }
 
+  /// @returns The content of the fragment `f`.
+  std::string_view str(const Fragment& f) const noexcept
+  {
+    assert(f.offset + f.size <= text_.size());
+    return {text_.data() + f.offset, f.size};
+  }
+
   // ---------------------------------------------------------------------------
   // Initializers
   // ---------------------------------------------------------------------------
 
-  void push_back_fragment(const Fragment::Type type, const std::string& str)
+  void push_back_fragment(const Fragment::Type type, const std::string_view str)
   {
-    fragments_.emplace_back(type, str);
+    fragments_.push_back(Fragment{type, text_.size(), str.size()});
+    text_.append(str);
     assert(is_invariant_ok());
   }
 
-  void push_text(const std::string& str)
+  void push_text(const std::string_view str)
   {
     push_back_fragment(Fragment::Type::text, str);
   }
 
-  void push_one_line_comment(const std::string& str)
+  void push_one_line_comment(const std::string_view str)
   {
     push_back_fragment(Fragment::Type::one_line_comment, str);
   }
 
-  void push_multi_line_comment(const std::string& str)
+  void push_multi_line_comment(const std::string_view str)
   {
     push_back_fragment(Fragment::Type::multi_line_comment, str);
   }
 
-  void push_positional_parameter(const std::string& str);
-  void push_named_parameter(const std::string& str);
+  void push_positional_parameter(std::string_view str);
+  void push_named_parameter(std::string_view str);
 
   // ---------------------------------------------------------------------------
   // Updaters
@@ -406,10 +446,10 @@ private:
   // Generators
   // ---------------------------------------------------------------------------
 
-  std::vector<Fragment_list::const_iterator> unique_fragments(Fragment::Type type) const;
+  std::vector<std::size_t> unique_fragments(Fragment::Type type) const;
 
   std::size_t unique_fragment_index(
-    const std::vector<Fragment_list::const_iterator>& unique_fragments,
+    const std::vector<std::size_t>& unique_fragments,
     const std::string_view str) const noexcept;
 
   std::size_t named_parameter_index(const std::string_view name) const noexcept
@@ -417,7 +457,7 @@ private:
     return positional_parameter_count() + unique_fragment_index(named_parameters_, name);
   }
 
-  std::vector<Fragment_list::const_iterator> named_parameters() const
+  std::vector<std::size_t> named_parameters() const
   {
     return unique_fragments(Fragment::Type::named_parameter);
   }
@@ -431,9 +471,9 @@ private:
     return isspace(c, loc);
   }
 
-  static bool is_blank_string(const std::string& str, const std::locale& loc) noexcept
+  static bool is_blank_string(const std::string_view str, const std::locale& loc) noexcept
   {
-    return all_of(cbegin(str), cend(str), [&loc](const auto& c){return is_space(c, loc);});
+    return std::all_of(cbegin(str), cend(str), [&loc](const auto& c){return is_space(c, loc);});
   }
 
   static bool is_comment(const Fragment& f) noexcept
@@ -4,8 +4,10 @@
 
 #include "conversions.hpp"
 #include "sql_vector.hpp"
+#include "../str.hpp"
 
 #include <algorithm>
+#include <functional>
 
 namespace dmitigr::pgfe {
 
@@ -18,6 +20,18 @@ DMITIGR_PGFE_INLINE Sql_vector::Sql_vector(std::string_view input)
     assert(pos <= input.size());
     input = input.substr(pos);
   }
+  update_index();
+}
+
+DMITIGR_PGFE_INLINE Sql_vector::Sql_vector(std::vector<Sql_string>&& storage)
+  : storage_{std::move(storage)}
+{
+  update_index();
+}
+
+DMITIGR_PGFE_INLINE Sql_vector Sql_vector::from_file(const std::filesystem::path& path)
+{
+  return Sql_vector{str::to_string(path)};
 }
 
 DMITIGR_PGFE_INLINE std::size_t Sql_vector::non_empty_count() const noexcept
@@ -37,22 +51,102 @@ DMITIGR_PGFE_INLINE std::size_t Sql_vector::index_of(
   const std::size_t offset, const std::size_t extra_offset) const noexcept
 {
   const auto sz = size();
+  if (!extra_offset) {
+    if (const auto i = index_.find(index_key(extra_name, extra_value)); i != cend(index_)) {
+      const auto& indexes = i->second;
+      for (auto j = std::lower_bound(cbegin(indexes), cend(indexes), offset);
+           j != cend(indexes); ++j) {
+        if (has_extra(storage_[*j], extra_name, extra_value, 0))
+          return *j;
+      }
+    }
+    return sz;
+  }
+
   const auto b = cbegin(storage_);
   const auto e = cend(storage_);
   using Diff = decltype(b)::difference_type;
   const auto i = find_if(std::min(b + static_cast<Diff>(offset), b + static_cast<Diff>(sz)), e,
     [&extra_name, &extra_value, extra_offset](const auto& sql_string)
     {
-      if (const auto& extra = sql_string.extra(); extra_offset < extra.size()) {
-        const auto index = extra.index_of(extra_name, extra_offset);
-        return (index < extra.size()) &&
-          (to<std::string_view>(*extra.data(index)) == extra_value);
-      } else
-        return false;
+      return has_extra(sql_string, extra_name, extra_value, extra_offset);
     });
   return static_cast<std::size_t>(i - b);
 }
 
+DMITIGR_PGFE_INLINE void Sql_vector::update_index()
+{
+  Index idx;
+  const auto sz = size();
+  for (std::size_t i = 0; i < sz; ++i)
+    index(idx, i, storage_[i]);
+  index_.swap(idx);
+}
+
+DMITIGR_PGFE_INLINE void Sql_vector::index(Index& index, const std::size_t i,
+  const Sql_string& sql_string)
+{
+  const auto& extra = sql_string.extra();
+  const auto field_count = extra.size();
+  for (std::size_t j = 0; j < field_count; ++j) {
+    const auto name = extra.name_of(j);
+    const auto& data = extra.data(j);
+    if (data && extra.index_of(name) == j) { // only the first field with such a name
+      auto& indexes = index[index_key(name, to<std::string_view>(*data))];
+      assert(indexes.empty() || indexes.back() <= i);
+      if (indexes.empty() || indexes.back() != i)
+        indexes.push_back(i);
+    }
+  }
+}
+
+DMITIGR_PGFE_INLINE std::size_t Sql_vector::index_key(const std::string_view extra_name,
+  const std::string_view extra_value) noexcept
+{
+  const std::hash<std::string_view> hash;
+  auto result = hash(extra_name);
+  result ^= hash(extra_value) + 0x9e3779b9 + (result << 6) + (result >> 2);
+  return result;
+}
+
+DMITIGR_PGFE_INLINE bool Sql_vector::has_extra(const Sql_string& sql_string,
+  const std::string_view extra_name, const std::string_view extra_value,
+  const std::size_t extra_offset) noexcept
+{
+  if (const auto& extra = sql_string.extra(); extra_offset < extra.size()) {
+    const auto index = extra.index_of(extra_name, extra_offset);
+    return (index < extra.size()) && extra.data(index) &&
+      (to<std::string_view>(*extra.data(index)) == extra_value);
+  } else
+    return false;
+}
+
+DMITIGR_PGFE_INLINE void Sql_vector::index_back__()
+{
+  assert(!storage_.empty());
+  const auto i = storage_.size() - 1;
+  try {
+    index(index_, i, storage_[i]);
+  } catch (...) {
+    unindex__(i); // rollback
+    throw;
+  }
+}
+
+DMITIGR_PGFE_INLINE void Sql_vector::unindex__(const std::size_t index) noexcept
+{
+  for (auto i = begin(index_); i != end(index_);) {
+    auto& indexes = i->second;
+    const auto j = std::lower_bound(begin(indexes), end(indexes), index);
+    const auto k = (j != end(indexes) && *j == index) ? indexes.erase(j) : j;
+    std::for_each(k, end(indexes), [](auto& idx){ --idx; });
+    if (indexes.empty())
+      i = index_.erase(i);
+    else
+      ++i;
+  }
+}
+
 DMITIGR_PGFE_INLINE std::string::size_type Sql_vector::query_absolute_position(const std::size_t index) const
 {
   assert(index < size());
@@ -8,11 +8,14 @@
 #include "dll.hpp"
 #include "sql_string.hpp"
 #include "types_fwd.hpp"
+#include "../filesystem.hpp"
 
 #include <cassert>
+#include <cstddef>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace dmitigr::pgfe {
@@ -55,14 +58,22 @@ public:
   explicit DMITIGR_PGFE_API Sql_vector(std::string_view input);
 
   /// @overload
-  explicit Sql_vector(std::vector<Sql_string>&& storage)
-    : storage_{std::move(storage)}
-  {}
+  explicit DMITIGR_PGFE_API Sql_vector(std::vector<Sql_string>&& storage);
+
+  /**
+   * @returns The SQL vector parsed from the content of the file at `path`.
+   *
+   * @throws `std::runtime_error` if the file cannot be read.
+   *
+   * @see Sql_vector(std::string_view).
+   */
+  static DMITIGR_PGFE_API Sql_vector from_file(const std::filesystem::path& path);
 
   /// Swaps the instances.
   void swap(Sql_vector& rhs) noexcept
   {
     storage_.swap(rhs.storage_);
+    index_.swap(rhs.index_);
   }
 
   /// @returns The count of SQL strings this vector contains.
@@ -89,9 +100,17 @@ public:
    * @param offset A starting position of lookup in this vector.
    * @param extra_offset A starting position of lookup in the extra data.
    *
-   * @see Sql_string::extra().
+   * @remarks If `(extra_offset == 0)` the lookup is performed by using the
+   * hash index of the extra data of the SQL strings (in average constant
+   * time). The index is built upon the construction and is kept up to date
+   * by the methods which modify this vector, so the concurrent lookups are
+   * safe. If the extra data of the SQL string is modified by using the
+   * reference returned by either operator[]() or find() the index must be
+   * updated by using update_index().
+   *
+   * @see Sql_string::extra(), update_index().
    */
-  std::size_t index_of(const std::string_view extra_name,
+  DMITIGR_PGFE_API std::size_t index_of(const std::string_view extra_name,
     const std::string_view extra_value,
     std::size_t offset = 0, std::size_t extra_offset = 0) const noexcept;
 
@@ -126,7 +145,7 @@ public:
    */
   Sql_string* find(const std::string_view extra_name,
     const std::string_view extra_value,
-    const std::size_t offset = 0, const std::size_t extra_offset = 0)
+    const std::size_t offset = 0, const std::size_t extra_offset = 0) noexcept
   {
     return const_cast<Sql_string*>(static_cast<const Sql_vector*>(this)->
       find(extra_name, extra_value, offset, extra_offset));
@@ -135,7 +154,7 @@ public:
   /// @overload
   const Sql_string* find(const std::string_view extra_name,
     const std::string_view extra_value,
-    const std::size_t offset = 0, const std::size_t extra_offset = 0) const
+    const std::size_t offset = 0, const std::size_t extra_offset = 0) const noexcept
   {
     const auto index = index_of(extra_name, extra_value, offset, extra_offset);
     return (index < size()) ? &operator[](index) : nullptr;
@@ -156,9 +175,15 @@ public:
    *
    * @param sql_string A SQL string to append.
    */
-  void push_back(Sql_string sql_string) noexcept
+  void push_back(Sql_string sql_string)
   {
     storage_.push_back(std::move(sql_string));
+    try {
+      index_back__();
+    } catch (...) {
+      storage_.pop_back();
+      throw;
+    }
   }
 
   /// @overload
@@ -166,6 +191,12 @@ public:
   void emplace_back(Types&& ... args)
   {
     storage_.emplace_back(std::forward<Types>(args)...);
+    try {
+      index_back__();
+    } catch (...) {
+      storage_.pop_back();
+      throw;
+    }
   }
 
   /**
@@ -182,7 +213,13 @@ public:
     assert(index < size());
     const auto b = begin(storage_);
     using Diff = decltype(b)::difference_type;
-    storage_.insert(b + static_cast<Diff>(index), std::move(sql_string));
+    const auto i = storage_.insert(b + static_cast<Diff>(index), std::move(sql_string));
+    try {
+      update_index();
+    } catch (...) {
+      storage_.erase(i);
+      throw;
+    }
   }
 
   /**
@@ -197,6 +234,7 @@ public:
     const auto b = begin(storage_);
     using Diff = decltype(b)::difference_type;
     storage_.erase(b + static_cast<Diff>(index));
+    unindex__(index);
   }
 
   /// @returns The result of conversion of this instance to the instance of type `std::string`.
@@ -212,11 +250,36 @@ public:
   {
     decltype(storage_) result;
     storage_.swap(result);
+    index_.clear();
     return result;
   }
 
+  /**
+   * @brief Rebuilds the hash index of the extra data.
+   *
+   * @see index_of().
+   */
+  DMITIGR_PGFE_API void update_index();
+
 private:
   mutable std::vector<Sql_string> storage_;
+
+  /*
+   * The hash index of the extra data. The key is the hash of the name and the
+   * value of the first field of the extra data with such a name. The value is
+   * the sorted indexes of the SQL strings. (The SQL strings found by the key
+   * are checked since the hashes can collide.)
+   */
+  using Index = std::unordered_map<std::size_t, std::vector<std::size_t>>;
+  Index index_;
+
+  static std::size_t index_key(std::string_view extra_name,
+    std::string_view extra_value) noexcept;
+  static void index(Index& index, std::size_t i, const Sql_string& sql_string);
+  static bool has_extra(const Sql_string& sql_string, std::string_view extra_name,
+    std::string_view extra_value, std::size_t extra_offset) noexcept;
+  DMITIGR_PGFE_API void index_back__();
+  DMITIGR_PGFE_API void unindex__(std::size_t index) noexcept;
 };
 
 /// Sql_vector is swappable.
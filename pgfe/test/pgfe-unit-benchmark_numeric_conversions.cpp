@@ -0,0 +1,138 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "../../testo.hpp"
+#include "../../pgfe/conversions.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+namespace {
+
+// The conversions implemented as before std::from_chars() and std::to_chars().
+namespace streams {
+
+template<typename T>
+T to(const pgfe::Data& data)
+{
+  const std::string text{static_cast<const char*>(data.bytes()), data.size()};
+  std::size_t idx{};
+  T result;
+  if constexpr (std::is_same_v<T, int>)
+    result = std::stoi(text, &idx, 10);
+  else if constexpr (std::is_same_v<T, long long>)
+    result = std::stoll(text, &idx, 10);
+  else
+    result = std::stod(text, &idx);
+  if (idx != text.size())
+    throw std::runtime_error{"the input string contains symbols not convertible to numeric"};
+  return result;
+}
+
+template<typename T>
+std::unique_ptr<pgfe::Data> to_data(const T value)
+{
+  std::string text;
+  if constexpr (std::is_floating_point_v<T>) {
+    std::ostringstream stream;
+    stream.precision(std::numeric_limits<T>::max_digits10);
+    stream << value;
+    text = stream.str();
+  } else
+    text = std::to_string(value);
+  return pgfe::Data::make(std::move(text), pgfe::Data_format::text);
+}
+
+} // namespace streams
+
+template<typename F>
+auto measure(F&& f)
+{
+  namespace chrono = std::chrono;
+  const auto start = chrono::steady_clock::now();
+  f();
+  return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+
+template<typename T>
+void bench(const char* const type_name, const std::vector<T>& values,
+  const unsigned long iteration_count, const bool is_verbose)
+{
+  std::vector<std::unique_ptr<pgfe::Data>> datas;
+  datas.reserve(values.size());
+  for (const auto value : values)
+    datas.push_back(pgfe::to_data(value));
+
+  // Check that both paths produce the same values.
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    ASSERT(pgfe::to<T>(*datas[i]) == streams::to<T>(*datas[i]));
+    ASSERT(pgfe::to<T>(*streams::to_data(values[i])) == values[i]);
+  }
+
+  volatile T sink{};
+  const auto parse_streams = measure([&]
+  {
+    for (auto i = 0*iteration_count; i < iteration_count; ++i)
+      for (const auto& data : datas)
+        sink = streams::to<T>(*data);
+  });
+  const auto parse_charconv = measure([&]
+  {
+    for (auto i = 0*iteration_count; i < iteration_count; ++i)
+      for (const auto& data : datas)
+        sink = pgfe::to<T>(*data);
+  });
+  const auto format_streams = measure([&]
+  {
+    for (auto i = 0*iteration_count; i < iteration_count; ++i)
+      for (const auto value : values)
+        streams::to_data(value);
+  });
+  const auto format_charconv = measure([&]
+  {
+    for (auto i = 0*iteration_count; i < iteration_count; ++i)
+      for (const auto value : values)
+        pgfe::to_data(value);
+  });
+
+  if (is_verbose)
+    std::cout << type_name
+              << ": parse " << parse_streams << "us -> " << parse_charconv << "us"
+              << ", format " << format_streams << "us -> " << format_charconv << "us"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+try {
+  const unsigned long iteration_count = (argc >= 2) ? std::stoul(argv[1]) : 1;
+  const bool is_verbose = argc >= 2;
+
+  std::vector<int> ints;
+  std::vector<long long> longs;
+  std::vector<double> doubles;
+  for (int i = -5000; i < 5000; ++i) {
+    ints.push_back(i * 104729);
+    longs.push_back(i * 1000000007LL * 1299709);
+    doubles.push_back(i / 7.0);
+  }
+
+  bench("int", ints, iteration_count, is_verbose);
+  bench("long long", longs, iteration_count, is_verbose);
+  bench("double", doubles, iteration_count, is_verbose);
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
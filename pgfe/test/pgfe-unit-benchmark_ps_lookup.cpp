@@ -0,0 +1,65 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int argc, char* argv[])
+try {
+  namespace chrono = std::chrono;
+  const unsigned long iteration_count = (argc >= 2) ? std::stoul(argv[1]) : 1;
+  const bool is_verbose = argc >= 2;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+
+  std::vector<std::string> names;
+  std::size_t prepared_count{};
+  for (const std::size_t count : {10, 1000, 10000}) {
+    // Prepare the statements in the pipeline to avoid the round trips.
+    conn->set_pipeline_enabled(true);
+    for (auto i = names.size(); i < count; ++i) {
+      names.push_back("ps_lookup_" + std::to_string(i));
+      conn->prepare_nio("select 1", names.back());
+    }
+    conn->send_sync();
+    for (auto i = prepared_count; i < count; ++i) {
+      ASSERT(conn->wait_response_throw());
+      ASSERT(conn->prepared_statement());
+    }
+    ASSERT(conn->process_responses(pgfe::ignore_row).operation_name() == "sync");
+    prepared_count = count;
+    conn->set_pipeline_enabled(false);
+    for (const auto& name : names)
+      ASSERT(conn->prepared_statement(name));
+
+    std::size_t found_count{};
+    const auto start = chrono::steady_clock::now();
+    for (auto i = 0*iteration_count; i < iteration_count; ++i) {
+      for (const auto& name : names)
+        found_count += static_cast<bool>(conn->prepared_statement(name));
+    }
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(
+      chrono::steady_clock::now() - start).count();
+    ASSERT(found_count == count * iteration_count);
+
+    if (is_verbose)
+      std::cout << count << " statements: "
+                << elapsed << "us for " << found_count << " lookups" << std::endl;
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -5,21 +5,81 @@
 #include "../../testo.hpp"
 #include "../../pgfe/sql_string.hpp"
 
+#include <chrono>
+#include <iostream>
+#include <string>
+
 namespace pgfe = dmitigr::pgfe;
 namespace testo = dmitigr::testo;
 
+namespace {
+
+template<typename F>
+auto measure(F&& f)
+{
+  namespace chrono = std::chrono;
+  const auto start = chrono::steady_clock::now();
+  f();
+  return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
 int main(int argc, char* argv[])
 try {
-  pgfe::Sql_string s;
   const unsigned long iteration_count = (argc >= 2) ? std::stoul(argv[1]) : 1;
-  for (auto i = 0*iteration_count; i < iteration_count; ++i) {
-    s = "SELECT :list_ FROM :t1_ t1 JOIN :t2_ t2 ON (t1.t2 = t2.id) WHERE :where_";
-    s.replace_parameter("list_", "t1.id id, t1.age age, t2.dat dat");
-    s.replace_parameter("t1_", "table1");
-    s.replace_parameter("t2_", "table2");
-    s.replace_parameter("where_", "t1.nm = :nm AND t2.age = :age");
-  }
-  const auto modified_string = s.to_string();
+  const bool is_verbose = argc >= 2;
+
+  const auto replace = [iteration_count]
+  {
+    pgfe::Sql_string s;
+    for (auto i = 0*iteration_count; i < iteration_count; ++i) {
+      s = "SELECT :list_ FROM :t1_ t1 JOIN :t2_ t2 ON (t1.t2 = t2.id) WHERE :where_";
+      s.replace_parameter("list_", "t1.id id, t1.age age, t2.dat dat");
+      s.replace_parameter("t1_", "table1");
+      s.replace_parameter("t2_", "table2");
+      s.replace_parameter("where_", "t1.nm = :nm AND t2.age = :age");
+    }
+    const auto modified_string = s.to_string();
+    ASSERT(s.to_query_string() ==
+      "SELECT t1.id id, t1.age age, t2.dat dat FROM table1 t1 JOIN table2 t2"
+      " ON (t1.t2 = t2.id) WHERE t1.nm = $1 AND t2.age = $2");
+  };
+
+  const auto construct = [iteration_count]
+  {
+    for (auto i = 0*iteration_count; i < iteration_count; ++i) {
+      const pgfe::Sql_string s{"-- $id$benchmark$id$\n"
+        "SELECT t1.id id, t1.age age, t2.dat dat FROM table1 t1 JOIN table2 t2"
+        " ON (t1.t2 = t2.id) WHERE t1.nm = :nm AND t2.age = :age"};
+      ASSERT(s.parameter_count() == 2);
+    }
+  };
+
+  const auto to_query_string = [iteration_count]
+  {
+    const pgfe::Sql_string s{"SELECT :a, :b, :c FROM t WHERE x = :a AND y = :b"};
+    std::size_t size{};
+    for (auto i = 0*iteration_count; i < iteration_count; ++i)
+      size += s.to_query_string().size();
+    ASSERT(size);
+  };
+
+  pgfe::Sql_string::set_parse_cache_capacity(0);
+  const auto replace_uncached = measure(replace);
+  const auto construct_uncached = measure(construct);
+
+  pgfe::Sql_string::set_parse_cache_capacity(256);
+  const auto replace_cached = measure(replace);
+  const auto construct_cached = measure(construct);
+
+  const auto to_query_string_time = measure(to_query_string);
+
+  if (is_verbose)
+    std::cout << "replace: " << replace_uncached << "us -> " << replace_cached << "us (cached)"
+              << ", construct: " << construct_uncached << "us -> " << construct_cached << "us (cached)"
+              << ", to_query_string: " << to_query_string_time << "us"
+              << std::endl;
 } catch (const std::exception& e) {
   testo::report_failure(argv[0], e);
   return 1;
@@ -0,0 +1,281 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+/*
+ * The benchmark suite.
+ *
+ * Usage: pgfe-unit-benchmark_suite [count [output_file]]
+ *
+ * Each benchmark processes `count` units (rows, queries etc, 1000 by default)
+ * and prints one line of JSON (JSON Lines) to the `output_file` (or to the
+ * standard output) in the following form:
+ *
+ *   {"name":"rows_text","unit":"row","count":1000,"elapsed_ns":1234567,
+ *    "per_second":810000.5,"allocations_per_unit":3.002}
+ *
+ * The allocations are counted by the replaced global `operator new`, thus the
+ * allocations made by libpq (by `malloc()`) are not counted. The names of the
+ * benchmarks and the keys are stable, so the outputs of different releases
+ * can be compared by the tools.
+ */
+
+#include "pgfe-unit.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+namespace {
+
+std::atomic<std::uint64_t> allocation_count;
+
+} // namespace
+
+#if defined(__GNUG__) && !defined(__clang__) && __GNUC__ >= 11
+// The replaced operators are inlined and the pair of malloc()/free() is misreported.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(const std::size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* const result = std::malloc(size ? size : 1))
+    return result;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* const ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+#if defined(__GNUG__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+volatile double sink;
+
+/**
+ * Calls `f` which returns the number of processed units and prints the
+ * results of the measurement.
+ */
+template<typename F>
+void measure(std::ostream& output, const std::string_view name,
+  const std::string_view unit, F&& f)
+{
+  namespace chrono = std::chrono;
+  const auto allocations = allocation_count.load(std::memory_order_relaxed);
+  const auto start = chrono::steady_clock::now();
+  const std::uint64_t count = f();
+  const auto elapsed = chrono::duration_cast<chrono::nanoseconds>(
+    chrono::steady_clock::now() - start);
+  const auto allocated = allocation_count.load(std::memory_order_relaxed) - allocations;
+  ASSERT(count);
+
+  const auto seconds = chrono::duration<double>(elapsed).count();
+  output << "{\"name\":\"" << name << "\""
+         << ",\"unit\":\"" << unit << "\""
+         << ",\"count\":" << count
+         << ",\"elapsed_ns\":" << elapsed.count()
+         << ",\"per_second\":" << (seconds > 0 ? static_cast<double>(count) / seconds : 0)
+         << ",\"allocations_per_unit\":" << static_cast<double>(allocated) / count
+         << "}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+try {
+  const int count = (argc > 1) ? std::stoi(argv[1]) : 1000;
+  ASSERT(count > 0);
+  std::ofstream output_file;
+  if (argc > 2) {
+    output_file.open(argv[2]);
+    if (!output_file)
+      throw std::runtime_error{"Unable to open output file " + std::string{argv[2]}};
+  }
+  std::ostream& output = (argc > 2) ? output_file : std::cout;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+
+  // Retrieving the rows in the text and in the binary formats.
+  {
+    const pgfe::Sql_string query{"select i, i::int8, i::float8, 'Row ' || i"
+      " from generate_series(1, $1::int) i"};
+    for (const auto format : {pgfe::Data_format::text, pgfe::Data_format::binary}) {
+      conn->set_result_format(format);
+      measure(output, format == pgfe::Data_format::text ? "rows_text" : "rows_binary",
+        "row", [&]
+        {
+          std::uint64_t result{};
+          double sum{};
+          conn->execute([&](auto&& row)
+          {
+            sum += pgfe::to<int>(row[0]) + pgfe::to<long long>(row[1])
+              + pgfe::to<double>(row[2]) + pgfe::to<std::string_view>(row[3]).size();
+            ++result;
+          }, query, count);
+          sink = sum;
+          return result;
+        });
+    }
+    conn->set_result_format(pgfe::Data_format::text);
+  }
+
+  // Execution of the unprepared, the prepared and the cached statements.
+  {
+    const pgfe::Sql_string query{"select $1::int8"};
+    const auto execute = [&]
+    {
+      double sum{};
+      for (int i = 0; i < count; ++i)
+        conn->execute([&sum](auto&& row)
+        {
+          sum += pgfe::to<long long>(row[0]);
+        }, query, i);
+      sink = sum;
+      return count;
+    };
+    measure(output, "execute_unprepared", "query", execute);
+
+    auto* const ps = conn->prepare(query, "benchmark_suite");
+    measure(output, "execute_prepared", "query", [&]
+    {
+      double sum{};
+      for (int i = 0; i < count; ++i)
+        ps->bind(0, i).execute([&sum](auto&& row)
+        {
+          sum += pgfe::to<long long>(row[0]);
+        });
+      sink = sum;
+      return count;
+    });
+    conn->unprepare("benchmark_suite");
+
+    conn->set_statement_cache_capacity(16);
+    measure(output, "execute_cached", "query", execute);
+    conn->set_statement_cache_capacity(0);
+  }
+
+  // Acquisition and release of the connections of the pool.
+  {
+    pgfe::Connection_pool pool{1, pgfe::test::connection_options()};
+    pool.connect();
+    const auto acquire_release = [&]
+    {
+      for (int i = 0; i < count; ++i) {
+        const auto handle = pool.connection();
+        ASSERT(handle);
+      }
+      return count;
+    };
+    measure(output, "pool_acquire_release_discard_all", "acquisition", acquire_release);
+    pool.set_release_handler([](pgfe::Connection&){});
+    measure(output, "pool_acquire_release", "acquisition", acquire_release);
+  }
+
+  // Parsing of the SQL strings (without and with the parse cache).
+  {
+    const auto parse = [&]
+    {
+      std::size_t sum{};
+      for (int i = 0; i < count; ++i) {
+        const pgfe::Sql_string s{"-- $id$benchmark$id$\n"
+          "SELECT t1.id id, t1.age age, t2.dat dat FROM table1 t1 JOIN table2 t2"
+          " ON (t1.t2 = t2.id) /* comment */ WHERE t1.nm = :nm AND t2.age = :age"
+          " AND t2.dat <> 'a :literal' AND t1.id = ANY($1)"};
+        sum += s.parameter_count();
+      }
+      sink = static_cast<double>(sum);
+      return count;
+    };
+    const auto parse_cache_capacity = pgfe::Sql_string::parse_cache_capacity();
+    pgfe::Sql_string::set_parse_cache_capacity(0);
+    measure(output, "sql_string_parse", "statement", parse);
+    pgfe::Sql_string::set_parse_cache_capacity(parse_cache_capacity ? parse_cache_capacity : 256);
+    measure(output, "sql_string_parse_cached", "statement", parse);
+    pgfe::Sql_string::set_parse_cache_capacity(parse_cache_capacity);
+  }
+
+  // Decoding of the arrays.
+  {
+    const auto text_array = pgfe::Data::make(std::string_view{
+      "{\"Column 1, Row 1\",\"Column 2, Row 1\",\"Column 3, Row 1\","
+      "\"Column 4, Row 1\",NULL}"});
+    measure(output, "array_text_decode", "array", [&]
+    {
+      std::size_t sum{};
+      for (int i = 0; i < count; ++i)
+        sum += pgfe::to<std::vector<std::optional<std::string>>>(*text_array).size();
+      sink = static_cast<double>(sum);
+      return count;
+    });
+
+    std::string literal{"{"};
+    for (int i = 0; i < 100; ++i)
+      literal.append(std::to_string(i)).append(i < 99 ? "," : "}");
+    const auto int_array = pgfe::Data::make(literal);
+    measure(output, "array_int_decode", "array", [&]
+    {
+      std::size_t sum{};
+      for (int i = 0; i < count; ++i)
+        sum += pgfe::to<std::vector<int>>(*int_array).size();
+      sink = static_cast<double>(sum);
+      return count;
+    });
+  }
+
+  // Decoding of the rows into the composites.
+  {
+    const pgfe::Sql_string query{"select i id, 'Name ' || i nm, i % 100 age,"
+      " 'Column 4, Row ' || i dat from generate_series(1, $1::int) i"};
+    measure(output, "composite_from_row", "row", [&]
+    {
+      std::uint64_t result{};
+      conn->execute([&result](auto&& row)
+      {
+        pgfe::Composite composite;
+        for (std::size_t i = 0; i < row.size(); ++i)
+          composite.append(std::string{row.name_of(i)}, row.data(i).to_data());
+        result += composite.size() == 4;
+      }, query, count);
+      return result;
+    });
+    measure(output, "flat_composite_from_row", "row", [&]
+    {
+      std::uint64_t result{};
+      conn->execute([&result](auto&& row)
+      {
+        const pgfe::Flat_composite composite{row};
+        result += composite.size() == 4;
+      }, query, count);
+      return result;
+    });
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,163 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+namespace {
+
+struct Sample final {
+  std::int64_t id{};
+  std::optional<double> value;
+  std::string source;
+};
+
+} // namespace
+
+namespace dmitigr::pgfe {
+
+template<>
+struct Binary_copy_conversions<Sample> final {
+  using Tuple = std::tuple<std::int64_t, std::optional<double>, std::string>;
+
+  static auto to_tuple(const Sample& value)
+  {
+    return std::tie(value.id, value.value, value.source);
+  }
+
+  static Sample to_type(Tuple&& value)
+  {
+    auto& [id, val, source] = value;
+    return Sample{id, val, std::move(source)};
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+int main(int, char* argv[])
+try {
+  using std::chrono::system_clock;
+
+  // Header and trailer.
+  {
+    pgfe::Binary_copy_encoder encoder;
+    ASSERT(!encoder.is_finished());
+    ASSERT(encoder.size() == 19);
+    ASSERT(encoder.data().substr(0, 11) == std::string_view("PGCOPY\n\377\r\n\0", 11));
+    encoder.finish();
+    ASSERT(encoder.is_finished());
+    ASSERT(encoder.size() == 21);
+
+    pgfe::Binary_copy_decoder decoder;
+    decoder.append(encoder.data());
+    ASSERT(!decoder.has_row());
+    ASSERT(decoder.is_finished());
+  }
+
+  // Encoding of the row.
+  {
+    pgfe::Binary_copy_encoder encoder;
+    encoder.clear();
+    encoder.append_row(std::int16_t{1}, 2, nullptr, "ab");
+    const std::string_view expected{
+      "\0\4"
+      "\0\0\0\2" "\0\1"
+      "\0\0\0\4" "\0\0\0\2"
+      "\377\377\377\377"
+      "\0\0\0\2" "ab", 26};
+    ASSERT(encoder.data() == expected);
+  }
+
+  // Round trip of tuples and structs.
+  {
+    const system_clock::time_point now{
+      std::chrono::time_point_cast<std::chrono::microseconds>(system_clock::now())};
+    pgfe::Binary_copy_encoder encoder;
+    encoder.append_row(1, true, now, std::optional<std::string>{"one"});
+    encoder.append(std::make_tuple(2, false, now, std::optional<std::string>{}));
+    encoder.append(Sample{3, 3.5, "sensor"});
+    encoder.append(Sample{4, std::nullopt, ""});
+    encoder.finish();
+
+    // Feed the decoder byte by byte to check the handling of partial rows.
+    pgfe::Binary_copy_decoder decoder;
+    const auto data = encoder.data();
+    std::size_t i{};
+    const auto feed = [&]
+    {
+      while (!decoder.has_row() && !decoder.is_finished() && i < data.size())
+        decoder.append(data.substr(i++, 1));
+    };
+
+    feed();
+    {
+      const auto [id, flag, tp, name] =
+        decoder.read_row<int, bool, system_clock::time_point, std::optional<std::string>>();
+      ASSERT(id == 1 && flag && tp == now && name == "one");
+    }
+    feed();
+    {
+      using Row = std::tuple<long long, bool, system_clock::time_point, std::optional<std::string>>;
+      const auto [id, flag, tp, name] = decoder.read<Row>();
+      ASSERT(id == 2 && !flag && tp == now && !name);
+    }
+    feed();
+    {
+      const auto sample = decoder.read<Sample>();
+      ASSERT(sample.id == 3 && sample.value == 3.5 && sample.source == "sensor");
+    }
+    feed();
+    {
+      const auto sample = decoder.read<Sample>();
+      ASSERT(sample.id == 4 && !sample.value && sample.source.empty());
+    }
+    feed();
+    ASSERT(!decoder.has_row());
+    ASSERT(decoder.is_finished());
+    ASSERT(i == data.size());
+  }
+
+  // Errors.
+  {
+    const auto is_thrown = [](const auto& f)
+    {
+      try {
+        f();
+      } catch (const std::runtime_error&) {
+        return true;
+      }
+      return false;
+    };
+
+    pgfe::Binary_copy_encoder encoder;
+    encoder.append_row(nullptr, 1);
+    encoder.append_row(1);
+    pgfe::Binary_copy_decoder decoder;
+    decoder.append(encoder.data());
+    ASSERT(decoder.has_row());
+    ASSERT(is_thrown([&]{ decoder.read_row<int, int>(); }));
+    ASSERT(decoder.has_row());
+    ASSERT(is_thrown([&]{ decoder.read_row<int, int>(); }));
+    ASSERT(!decoder.has_row());
+
+    pgfe::Binary_copy_decoder invalid;
+    invalid.append(std::string(19, 'x'));
+    ASSERT(is_thrown([&]{ invalid.has_row(); }));
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,150 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::Data_direction;
+  using pgfe::Data_format;
+  using pgfe::to;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table copy_test(id integer not null, nm text)");
+
+  ASSERT(!conn->copier());
+
+  // COPY FROM STDIN by rows.
+  {
+    ASSERT(!conn->execute("copy copy_test from stdin"));
+    auto copier = conn->copier();
+    ASSERT(copier);
+    ASSERT(!conn->copier());
+    ASSERT(copier.data_direction() == Data_direction::to_server);
+    ASSERT(copier.data_format() == Data_format::text);
+    ASSERT(copier.field_count() == 2);
+    copier.send_row(1, "one");
+    copier.send_row(2, std::optional<std::string>{});
+    copier.send_row(3, nullptr);
+    copier.send_row(4, "tab\tnew line\nbackslash\\");
+    copier.end();
+    conn->wait_response_throw();
+    const auto comp = conn->completion();
+    ASSERT(comp);
+    ASSERT(comp.operation_name() == "COPY");
+    ASSERT(comp.affected_row_count() == 4);
+  }
+
+  // COPY FROM STDIN by raw chunks.
+  {
+    conn->execute("copy copy_test from stdin");
+    auto copier = conn->copier();
+    copier.send("5\tfi");
+    copier.send("ve\n6\tsix\n");
+    copier.end();
+    conn->wait_response_throw();
+    ASSERT(conn->completion().affected_row_count() == 2);
+  }
+
+  // Failed COPY FROM STDIN.
+  {
+    conn->execute("copy copy_test from stdin");
+    auto copier = conn->copier();
+    copier.send_row(7, "seven");
+    copier.end("canceled by client");
+    conn->wait_response();
+    const auto err = conn->error();
+    ASSERT(err);
+    ASSERT(!conn->has_uncompleted_request());
+  }
+
+  // The failed COPY doesn't insert anything.
+  {
+    long count{};
+    conn->execute([&count](auto&& row){ count = to<long>(row[0]); },
+      "select count(*) from copy_test");
+    ASSERT(count == 6);
+  }
+
+  // COPY TO STDOUT.
+  {
+    conn->execute("copy (select * from copy_test order by id) to stdout");
+    auto copier = conn->copier();
+    ASSERT(copier);
+    ASSERT(copier.data_direction() == Data_direction::from_server);
+    std::string result;
+    while (auto data = copier.receive())
+      result.append(to<std::string_view>(*data));
+    ASSERT(result ==
+      "1\tone\n"
+      "2\t\\N\n"
+      "3\t\\N\n"
+      "4\ttab\\tnew line\\nbackslash\\\\\n"
+      "5\tfive\n"
+      "6\tsix\n");
+    conn->wait_response_throw();
+    ASSERT(conn->completion().affected_row_count() == 6);
+  }
+
+  // Binary COPY TO STDOUT.
+  {
+    conn->execute("copy copy_test to stdout (format binary)");
+    auto copier = conn->copier();
+    ASSERT(copier.data_format() == Data_format::binary);
+    std::size_t size{};
+    while (auto data = copier.receive()) {
+      ASSERT(data->format() == Data_format::binary);
+      size += data->size();
+    }
+    ASSERT(size > 0);
+    conn->wait_response_throw();
+    ASSERT(conn->completion());
+  }
+
+  // Binary COPY round trip by using the encoder and the decoder.
+  {
+    conn->execute("copy copy_test from stdin (format binary)");
+    auto copier = conn->copier();
+    pgfe::Binary_copy_encoder encoder;
+    encoder.append_row(7, "seven");
+    encoder.append(std::make_tuple(8, std::optional<std::string>{}));
+    encoder.finish();
+    copier.send(encoder.data());
+    copier.end();
+    conn->wait_response_throw();
+    ASSERT(conn->completion().affected_row_count() == 2);
+
+    conn->execute("copy (select * from copy_test where id >= 7 order by id) to stdout (format binary)");
+    copier = conn->copier();
+    pgfe::Binary_copy_decoder decoder;
+    int row_count{};
+    while (const auto data = copier.receive()) {
+      decoder.append(*data);
+      while (decoder.has_row()) {
+        const auto [id, nm] = decoder.read_row<int, std::optional<std::string>>();
+        ASSERT(id == 7 + row_count);
+        ASSERT(id == 7 ? nm == "seven" : !nm);
+        ++row_count;
+      }
+    }
+    ASSERT(row_count == 2);
+    ASSERT(decoder.is_finished());
+    conn->wait_response_throw();
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
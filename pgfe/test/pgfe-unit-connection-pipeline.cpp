@@ -0,0 +1,95 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::Pipeline_status;
+  using pgfe::to;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  ASSERT(conn->pipeline_status() == Pipeline_status::disabled);
+
+  conn->set_pipeline_enabled();
+  ASSERT(conn->pipeline_status() == Pipeline_status::enabled);
+  ASSERT(conn->is_ready_for_nio_request());
+  ASSERT(!conn->is_ready_for_request());
+
+  // Successful pipeline.
+  {
+    constexpr int request_count{100};
+    for (int i = 0; i < request_count; ++i)
+      conn->execute_nio("select $1::int, generate_series(1, 3)", i);
+    conn->send_sync();
+    ASSERT(conn->has_uncompleted_request());
+
+    for (int i = 0; i < request_count; ++i) {
+      int row_count{};
+      const auto comp = conn->process_responses([&row_count, i](auto&& row)
+      {
+        ASSERT(to<int>(row[0]) == i);
+        ++row_count;
+      });
+      ASSERT(comp);
+      ASSERT(comp.operation_name() == "SELECT");
+      ASSERT(row_count == 3);
+    }
+
+    const auto sync = conn->process_responses(pgfe::ignore_row);
+    ASSERT(sync);
+    ASSERT(sync.operation_name() == "sync");
+    ASSERT(!conn->has_uncompleted_request());
+  }
+
+  // Aborted pipeline.
+  {
+    conn->execute_nio("select 1");
+    conn->execute_nio("provoke syntax error");
+    conn->execute_nio("select 3");
+    conn->send_sync();
+
+    ASSERT(conn->process_responses(pgfe::ignore_row));
+    bool is_error{};
+    ASSERT(!conn->process_responses([&is_error](auto&&, auto&& error)
+    {
+      is_error = static_cast<bool>(error);
+    }));
+    ASSERT(is_error);
+    ASSERT(conn->pipeline_status() == Pipeline_status::aborted);
+    ASSERT(!conn->process_responses(pgfe::ignore_row)); // aborted request
+    ASSERT(conn->process_responses(pgfe::ignore_row).operation_name() == "sync");
+    ASSERT(conn->pipeline_status() == Pipeline_status::enabled);
+  }
+
+  // Prepared statements in pipeline.
+  {
+    conn->prepare_nio("select $1::int", "ps1");
+    conn->send_flush();
+    ASSERT(conn->wait_response_throw());
+    auto* const ps = conn->prepared_statement();
+    ASSERT(ps);
+    for (int i = 0; i < 10; ++i)
+      ps->bind(0, i).execute_nio();
+    conn->send_sync();
+    for (int i = 0; i < 10; ++i)
+      conn->process_responses([i](auto&& row){ ASSERT(to<int>(row[0]) == i); });
+    ASSERT(conn->process_responses(pgfe::ignore_row).operation_name() == "sync");
+  }
+
+  conn->set_pipeline_enabled(false);
+  ASSERT(conn->pipeline_status() == Pipeline_status::disabled);
+  ASSERT(conn->is_ready_for_request());
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,85 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::to;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  ASSERT(conn->row_batch_size() == 1);
+
+  constexpr int row_count{1000};
+
+  // Batches of single rows.
+  {
+    int total{};
+    const auto comp = conn->execute([&total](pgfe::Row_batch&& batch)
+    {
+      ASSERT(batch);
+      ASSERT(batch.size() >= 1);
+      ASSERT(batch.info().size() == 1);
+      for (std::size_t i = 0; i < batch.size(); ++i)
+        ASSERT(to<int>(batch.data(i, "n")) == ++total);
+    }, "select generate_series(1, $1) n", row_count);
+    ASSERT(comp);
+    ASSERT(comp.operation_name() == "SELECT");
+    ASSERT(total == row_count);
+  }
+
+  // Batches of many rows.
+  {
+    conn->set_row_batch_size(64);
+    ASSERT(conn->row_batch_size() == 64);
+
+    int total{};
+    int batch_count{};
+    const auto comp = conn->execute([&](pgfe::Row_batch&& batch, pgfe::Error&& error)
+    {
+      ASSERT(!error);
+      ASSERT(batch.size() <= 64);
+      for (std::size_t i = 0; i < batch.size(); ++i)
+        ASSERT(to<int>(batch.data(i)) == ++total);
+      ++batch_count;
+    }, "select generate_series(1, $1) n", row_count);
+    ASSERT(comp);
+    ASSERT(total == row_count);
+    ASSERT(batch_count >= row_count / 64);
+
+    // Early completion.
+    total = 0;
+    conn->execute([&total](pgfe::Row_batch&& batch)
+    {
+      total += static_cast<int>(batch.size());
+      return pgfe::Row_processing::complete;
+    }, "select generate_series(1, $1) n", row_count);
+    ASSERT(total >= 1 && total <= 64);
+    ASSERT(conn->is_ready_for_request());
+  }
+
+  // Errors.
+  {
+    pgfe::Error err;
+    const auto comp = conn->execute([&err](pgfe::Row_batch&& batch, pgfe::Error&& error)
+    {
+      ASSERT(!batch);
+      err = std::move(error);
+    }, "select 1/0");
+    ASSERT(!comp);
+    ASSERT(err);
+    ASSERT(err.condition() == pgfe::Server_errc::c22_division_by_zero);
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,129 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::a;
+  using pgfe::to;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  ASSERT(!conn->statement_cache_capacity());
+  ASSERT(!conn->statement_cache_size());
+
+  // Disabled by default.
+  conn->execute("select 1");
+  ASSERT(!conn->statement_cache_size());
+
+  conn->set_statement_cache_capacity(2);
+  conn->set_statement_cache_threshold(2);
+  ASSERT(conn->statement_cache_capacity() == 2);
+  ASSERT(conn->statement_cache_threshold() == 2);
+
+  // Positional parameters.
+  for (int i = 0; i < 3; ++i) {
+    conn->execute([i](auto&& row)
+    {
+      ASSERT(to<int>(row[0]) == i);
+    }, "select $1::int", i);
+    ASSERT(static_cast<bool>(conn->prepared_statement("pgfe_cached_1")) == (i > 0));
+  }
+  ASSERT(conn->statement_cache_size() == 1);
+
+  // Named parameters and NULLs.
+  for (int i = 0; i < 3; ++i) {
+    conn->execute([](auto&& row)
+    {
+      ASSERT(to<int>(row[0]) == 3);
+      ASSERT(!row[1]);
+    }, "select :a::int + :b::int, :c::int", a{"a", 1}, a{"b", 2}, a{"c", nullptr});
+  }
+  ASSERT(conn->prepared_statement("pgfe_cached_2"));
+  ASSERT(conn->statement_cache_size() == 2);
+
+  // Eviction of the least recently used.
+  conn->execute("select 1");
+  ASSERT(conn->statement_cache_size() == 2);
+  ASSERT(!conn->prepared_statement("pgfe_cached_1"));
+  ASSERT(conn->prepared_statement("pgfe_cached_2"));
+
+  // No preparing in the transaction block.
+  conn->execute("begin");
+  for (int i = 0; i < 3; ++i)
+    conn->execute("select 2");
+  ASSERT(!conn->prepared_statement("pgfe_cached_3"));
+  conn->execute("commit");
+  conn->execute("select 2");
+  ASSERT(conn->prepared_statement("pgfe_cached_3"));
+
+  // Errors are reported as usual.
+  for (int i = 0; i < 3; ++i) {
+    bool is_thrown{};
+    try {
+      conn->execute("provoke syntax error");
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() == pgfe::Server_errc::c42_syntax_error);
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+  ASSERT(conn->is_ready_for_request());
+
+  // Disabling.
+  conn->set_statement_cache_capacity(0);
+  ASSERT(!conn->statement_cache_size());
+  ASSERT(!conn->prepared_statement("pgfe_cached_2"));
+  ASSERT(!conn->prepared_statement("pgfe_cached_3"));
+
+  // Overflow evicts only the least recently used entry.
+  {
+    // execute_nio() doesn't use the cache.
+    const auto server_prepared_count = [&conn]
+    {
+      long long result{};
+      conn->execute_nio("select count(*) from pg_prepared_statements"
+        " where name like 'pgfe\\_cached\\_%'");
+      conn->process_responses([&result](auto&& row)
+      {
+        result = to<long long>(row[0]);
+      });
+      return result;
+    };
+    ASSERT(!server_prepared_count());
+    ASSERT(!conn->statement_cache_size());
+
+    conn->set_statement_cache_capacity(3);
+    conn->set_statement_cache_threshold(1);
+    for (const char* const query : {"select 10", "select 11", "select 12"})
+      conn->execute(query);
+    ASSERT(conn->statement_cache_size() == 3);
+    ASSERT(server_prepared_count() == 3);
+
+    conn->execute("select 13");
+    ASSERT(conn->statement_cache_size() == 3);
+    ASSERT(server_prepared_count() == 3);
+
+    // The survivors are reused rather than prepared again.
+    for (const char* const query : {"select 11", "select 12", "select 13"})
+      conn->execute(query);
+    ASSERT(conn->statement_cache_size() == 3);
+    ASSERT(server_prepared_count() == 3);
+
+    conn->set_statement_cache_capacity(0);
+    ASSERT(!server_prepared_count());
+    ASSERT(!conn->statement_cache_size());
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
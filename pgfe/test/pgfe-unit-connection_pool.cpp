@@ -5,6 +5,12 @@
 #include "pgfe-unit.hpp"
 #include "../../pgfe.hpp"
 
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace pgfe = dmitigr::pgfe;
 namespace testo = dmitigr::testo;
 
@@ -51,6 +57,7 @@ try {
 
     auto conn4 = pool.connection();
     ASSERT(!conn4);
+    ASSERT(pool.busy_count() == pool_size);
     pool.disconnect();
     ASSERT(!pool.is_connected());
     ASSERT(conn1->is_connected());
@@ -63,6 +70,160 @@ try {
   ASSERT(!conn1p->is_connected());
   ASSERT(!conn2p->is_connected());
   ASSERT(!conn3p->is_connected());
+
+  // Blocking acquisition.
+  {
+    using std::chrono::milliseconds;
+    pool.connect();
+    ASSERT(pool.free_count() == pool_size);
+    auto conn1 = pool.connection();
+    auto conn2 = pool.connection();
+    auto conn3 = pool.connection();
+    ASSERT(conn1 && conn2 && conn3);
+    ASSERT(pool.free_count() == 0);
+
+    const auto started = std::chrono::steady_clock::now();
+    ASSERT(!pool.connection(milliseconds{50}));
+    ASSERT(std::chrono::steady_clock::now() - started >= milliseconds{50});
+    ASSERT(!pool.waiter_count());
+
+    // The waiters are served in the order of arrival.
+    std::vector<int> order;
+    std::mutex order_mutex;
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 2; ++i) {
+      waiters.emplace_back([&pool, &order, &order_mutex, i]
+      {
+        auto conn = pool.connection(std::nullopt);
+        ASSERT(conn);
+        const std::lock_guard lg{order_mutex};
+        order.push_back(i);
+      });
+      while (pool.waiter_count() != static_cast<std::size_t>(i + 1))
+        std::this_thread::yield();
+    }
+    conn1.release();
+    conn2.release();
+    for (auto& waiter : waiters)
+      waiter.join();
+    ASSERT((order == std::vector<int>{0, 1}));
+    ASSERT(pool.free_count() == 2);
+
+    // The disconnection wakes up the waiters.
+    auto conn4 = pool.connection();
+    auto conn5 = pool.connection();
+    ASSERT(conn4 && conn5);
+    std::thread waiter{[&pool]
+    {
+      ASSERT(!pool.connection(std::nullopt));
+    }};
+    while (pool.waiter_count() != 1)
+      std::this_thread::yield();
+    pool.disconnect();
+    waiter.join();
+    ASSERT(!pool.waiter_count());
+
+    // The reconnection before the waiters wake up doesn't strand them.
+    pool.connect();
+    ASSERT(!pool.free_count());
+    std::thread waiter2{[&pool]
+    {
+      ASSERT(!pool.connection(std::nullopt));
+    }};
+    while (pool.waiter_count() != 1)
+      std::this_thread::yield();
+    pool.disconnect();
+    pool.connect();
+    waiter2.join();
+    ASSERT(!pool.waiter_count());
+    conn5.release();
+    ASSERT(pool.free_count() == 1);
+    ASSERT(pool.connection());
+  }
+
+  // Elastic sizing.
+  {
+    using std::chrono::milliseconds;
+    pgfe::Connection_pool pool{pool_size, pgfe::test::connection_options()};
+    ASSERT(pool.min_size() == pool_size);
+    pool.set_min_size(1);
+    ASSERT(pool.min_size() == 1);
+    pool.connect();
+    ASSERT(pool.connected_count() == 1);
+    ASSERT(pool.free_count() == pool_size);
+    {
+      auto conn1 = pool.connection();
+      auto conn2 = pool.connection(); // opened on demand
+      ASSERT(conn1 && conn2);
+      ASSERT(conn2->is_connected());
+      ASSERT(pool.connected_count() == 2);
+    }
+    ASSERT(pool.connected_count() == 2);
+
+    // Idle shrink.
+    pool.set_max_idle_time(milliseconds{});
+    {
+      auto conn = pool.connection();
+      ASSERT(conn);
+    }
+    ASSERT(pool.connected_count() == 1);
+
+    // Lifetime recycle.
+    pool.set_max_lifetime(milliseconds{});
+    {
+      auto conn = pool.connection();
+      ASSERT(conn && conn->is_connected());
+    }
+    ASSERT(pool.connected_count() == 0);
+    pool.disconnect();
+  }
+
+  // Statement-preserving release handler and registered prepared statements.
+  {
+    pgfe::Connection_pool pool{1, pgfe::test::connection_options()};
+    pool.set_release_handler(&pgfe::Connection_pool::reset_preserving_statements);
+    pool.register_prepared_statement("plus_one", "select :n::int + 1");
+    pool.connect();
+
+    pgfe::Prepared_statement* ps{};
+    {
+      auto conn = pool.connection();
+      ASSERT(!conn.prepared_statement("unknown"));
+      ps = conn.prepared_statement("plus_one");
+      ASSERT(ps);
+      ps->bind("n", 1).execute([](auto&& row)
+      {
+        ASSERT(pgfe::to<int>(row[0]) == 2);
+      });
+      conn->execute("set application_name to 'pgfe_test_pool'");
+      conn->execute("begin");
+    }
+    {
+      auto conn = pool.connection();
+      ASSERT(conn.prepared_statement("plus_one") == ps); // not re-prepared
+      ASSERT(conn->transaction_status() == pgfe::Transaction_status::unstarted);
+      conn->execute([](auto&& row)
+      {
+        ASSERT(pgfe::to<std::string>(row[0]) != "pgfe_test_pool");
+      }, "show application_name");
+    }
+
+    pool.set_release_handler(&pgfe::Connection_pool::discard_all);
+    {
+      auto conn = pool.connection();
+      ASSERT(conn.prepared_statement("plus_one"));
+    }
+    {
+      auto conn = pool.connection();
+      ASSERT(!conn->prepared_statement("plus_one")); // deallocated
+      ASSERT(conn.prepared_statement("plus_one")); // prepared again
+    }
+    pool.unregister_prepared_statement("plus_one");
+    {
+      auto conn = pool.connection();
+      ASSERT(!conn.prepared_statement("plus_one"));
+    }
+  }
 } catch (const std::exception& e) {
   testo::report_failure(argv[0], e);
   return 1;
@@ -6,6 +6,9 @@
 #include "../../pgfe/exceptions.hpp"
 #include "../../pgfe/conversions.hpp"
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <limits>
 #include <optional>
 #include <string>
@@ -185,6 +188,132 @@ int main(int, char* argv[])
       }
     }
 
+    // Binary numerics
+    {
+      const auto binary = pgfe::Data_format::binary;
+      {
+        const short original = numeric_limits<short>::min();
+        const auto data = pgfe::to_data(original, binary);
+        ASSERT(data->format() == binary);
+        ASSERT(data->size() == 2);
+        ASSERT(pgfe::to<short>(data.get()) == original);
+        ASSERT(pgfe::to<long long>(data.get()) == original);
+      }
+      {
+        const int original = -1;
+        const auto data = pgfe::to_data(original, binary);
+        ASSERT(data->size() == 4);
+        ASSERT(pgfe::to<int>(data.get()) == original);
+        ASSERT(pgfe::to<long>(data.get()) == original);
+      }
+      {
+        const long long original = numeric_limits<long long>::min();
+        const auto data = pgfe::to_data(original, binary);
+        ASSERT(data->size() == 8);
+        ASSERT(pgfe::to<long long>(data.get()) == original);
+      }
+      {
+        // The data wider than the requested type is rejected.
+        const auto is_rejected = [](const auto& data, auto type)
+        {
+          try {
+            pgfe::to<decltype(type)>(data.get());
+          } catch (const std::runtime_error&) {
+            return true;
+          }
+          return false;
+        };
+        ASSERT(is_rejected(pgfe::to_data(1LL, binary), int{}));
+        ASSERT(is_rejected(pgfe::to_data(1.0, binary), int{}));
+        ASSERT(is_rejected(pgfe::to_data(1, binary), short{}));
+        ASSERT(is_rejected(pgfe::to_data(1.0, binary), float{}));
+        ASSERT(is_rejected(pgfe::Data::make(std::string_view{"\0\0\0", 3}, binary), int{}));
+        ASSERT(!is_rejected(pgfe::to_data(short{1}, binary), int{}));
+        ASSERT(!is_rejected(pgfe::to_data(1.0f, binary), double{}));
+      }
+      {
+        const float original = -1.5f;
+        const auto data = pgfe::to_data(original, binary);
+        ASSERT(data->size() == 4);
+        ASSERT(pgfe::to<float>(data.get()) == original);
+        ASSERT(pgfe::to<double>(data.get()) == original);
+      }
+      {
+        const double original = numeric_limits<double>::max();
+        const auto data = pgfe::to_data(original, binary);
+        ASSERT(data->size() == 8);
+        ASSERT(pgfe::to<double>(data.get()) == original);
+      }
+      {
+        const auto data = pgfe::to_data(true, binary);
+        ASSERT(data->format() == binary && data->size() == 1);
+        ASSERT(pgfe::to<bool>(data.get()));
+      }
+      {
+        const auto data = pgfe::to_data(42, pgfe::Data_format::text);
+        ASSERT(data->format() == pgfe::Data_format::text);
+        ASSERT(pgfe::to<int>(data.get()) == 42);
+      }
+    }
+
+    // std::chrono::system_clock::time_point
+    {
+      using Time_point = std::chrono::system_clock::time_point;
+      using std::chrono::microseconds;
+      const Time_point original{microseconds{1234567890123456}};
+      {
+        const auto data = pgfe::to_data(original);
+        ASSERT(data->format() == pgfe::Data_format::text);
+        ASSERT(pgfe::to<std::string_view>(data.get()) == "2009-02-13 23:31:30.123456+00");
+        ASSERT(pgfe::to<Time_point>(data.get()) == original);
+      }
+      {
+        const auto data = pgfe::to_data(original, pgfe::Data_format::binary);
+        ASSERT(data->format() == pgfe::Data_format::binary);
+        ASSERT(data->size() == 8);
+        ASSERT(pgfe::to<Time_point>(data.get()) == original);
+      }
+      ASSERT(pgfe::to<Time_point>(pgfe::Data::make("2009-02-14 02:31:30.123456+03")) == original);
+      ASSERT(pgfe::to<Time_point>(pgfe::Data::make("2000-01-01")) == Time_point{std::chrono::seconds{946684800}});
+      ASSERT(pgfe::to<Time_point>(pgfe::Data::make("1970-01-01 00:00:00")) == Time_point{});
+      ASSERT(pgfe::to<Time_point>(pgfe::Data::make("1969-12-31 23:59:59.5+00")) ==
+        Time_point{std::chrono::milliseconds{-500}});
+
+      // Binary date.
+      const char date[]{0, 0, 0, 1};
+      const auto data = pgfe::Data::make(std::string_view{date, sizeof(date)}, pgfe::Data_format::binary);
+      ASSERT(pgfe::to<Time_point>(data.get()) == Time_point{std::chrono::seconds{946684800 + 86400}});
+    }
+
+    // bytea
+    {
+      using Bytea = std::vector<std::byte>;
+      const Bytea original{std::byte{0}, std::byte{0xde}, std::byte{0xad}, std::byte{0xff}};
+      {
+        const auto data = pgfe::to_data(original);
+        ASSERT(pgfe::to<std::string_view>(data.get()) == "\\x00deadff");
+        ASSERT(pgfe::to<Bytea>(data.get()) == original);
+      }
+      {
+        const auto data = pgfe::to_data(original, pgfe::Data_format::binary);
+        ASSERT(data->size() == original.size());
+        ASSERT(pgfe::to<Bytea>(data.get()) == original);
+      }
+    }
+
+    // uuid
+    {
+      using Uuid = std::array<std::byte, 16>;
+      const std::string_view text{"a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"};
+      const auto original = pgfe::to<Uuid>(pgfe::Data::make(text));
+      ASSERT(original[0] == std::byte{0xa0} && original[15] == std::byte{0x11});
+      ASSERT(pgfe::to<std::string_view>(pgfe::to_data(original).get()) == text);
+      ASSERT(pgfe::to<Uuid>(pgfe::Data::make("{A0EEBC999C0B4EF8BB6D6BB9BD380A11}")) == original);
+      const auto data = pgfe::to_data(original, pgfe::Data_format::binary);
+      ASSERT(data->size() == 16);
+      ASSERT(pgfe::to<Uuid>(data.get()) == original);
+    }
+
     // Arrays
     // =========================================================================
 
@@ -369,6 +498,170 @@ int main(int, char* argv[])
           ASSERT(cond == pgfe::Client_errc::malformed_array_literal);
         }
       }
+
+      {
+        auto malformed_literals = {"{1{2}}", "{\"1\"2}", "{\"1\"\"2\"}", "{\"1}", "{\"1\\\"}"};
+        for (const auto* malformed_literal : malformed_literals) {
+          std::error_condition cond;
+          try {
+            const auto native = pgfe::to<Arr>(pgfe::Data::make(malformed_literal));
+          } catch (const pgfe::Client_exception& e) {
+            cond = e.condition();
+          }
+          ASSERT(cond == pgfe::Client_errc::malformed_array_literal);
+        }
+      }
+    }
+
+    // Array literals of strings
+    {
+      using Arr = Vector_array<std::string>;
+
+      {
+        const auto data = pgfe::Data::make(R"({"", " a b ", "\"q\"", "back\\slash", a\,b, NULL, "NULL", ab  })");
+        const auto native_arr = pgfe::to<Arr>(data.get());
+        ASSERT((native_arr == Arr{"", " a b ", "\"q\"", "back\\slash", "a,b", {}, "NULL", "ab"}));
+      }
+
+      {
+        const Arr original{"", "a", "\"q\"", "back\\slash", {}, "NULL"};
+        const auto data = pgfe::to_data(original);
+        ASSERT(pgfe::to<Arr>(data.get()) == original);
+      }
+
+      {
+        std::string literal{"{"};
+        for (int i = 0; i < 1000; ++i)
+          literal.append(i ? "," : "").append("\"Column ").append(std::to_string(i)).append("\"");
+        literal.append("}");
+        const auto native_arr = pgfe::to<Arr>(pgfe::Data::make(literal));
+        ASSERT(native_arr.size() == 1000);
+        ASSERT(native_arr[999] == "Column 999");
+      }
+    }
+
+    // Binary arrays
+    {
+      const auto append_int32 = [](std::string& result, const std::int32_t value)
+      {
+        const auto offset = result.size();
+        result.resize(offset + sizeof(value));
+        dmitigr::net::copy(result.data() + offset, sizeof(value), value);
+      };
+      const auto make_header = [&append_int32](const std::uint32_t oid,
+        const std::initializer_list<std::int32_t> dimensions)
+      {
+        std::string result;
+        append_int32(result, static_cast<std::int32_t>(dimensions.size()));
+        append_int32(result, 0); // flags
+        append_int32(result, static_cast<std::int32_t>(oid));
+        for (const auto dimension : dimensions) {
+          append_int32(result, dimension);
+          append_int32(result, 1); // lower bound
+        }
+        return result;
+      };
+      const auto append_int8 = [&append_int32](std::string& result, const std::int64_t value)
+      {
+        append_int32(result, sizeof(value));
+        const auto offset = result.size();
+        result.resize(offset + sizeof(value));
+        dmitigr::net::copy(result.data() + offset, sizeof(value), value);
+      };
+      const auto make_data = [](const std::string& bytes)
+      {
+        return pgfe::Data::make(bytes, pgfe::Data_format::binary);
+      };
+
+      // Empty array.
+      {
+        const auto data = make_data(make_header(20, {}));
+        ASSERT(pgfe::to<std::vector<long long>>(data.get()).empty());
+      }
+
+      // 1-dimensional array of int8 with NULL.
+      {
+        auto bytes = make_header(20, {3});
+        append_int8(bytes, 1);
+        append_int32(bytes, -1);
+        append_int8(bytes, std::numeric_limits<std::int64_t>::max());
+        const auto data = make_data(bytes);
+        ASSERT((pgfe::to<Vector_array<long long>>(data.get()) ==
+            Vector_array<long long>{1, {}, std::numeric_limits<long long>::max()}));
+        ASSERT(is_throw_works<std::exception>([&] { pgfe::to<std::vector<long long>>(data.get()); }));
+      }
+
+      // 2-dimensional array of text.
+      {
+        auto bytes = make_header(25, {2, 2});
+        for (const std::string_view str : {"a", "", "c\"d", "e"}) {
+          append_int32(bytes, static_cast<std::int32_t>(str.size()));
+          bytes.append(str);
+        }
+        const auto data = make_data(bytes);
+        using Vec2 = std::vector<std::vector<std::string>>;
+        ASSERT((pgfe::to<Vec2>(data.get()) == Vec2{{"a", ""}, {"c\"d", "e"}}));
+
+        std::error_condition cond;
+        try {
+          pgfe::to<std::vector<std::string>>(data.get());
+        } catch (const pgfe::Client_exception& e) {
+          cond = e.condition();
+        }
+        ASSERT(cond == pgfe::Client_errc::insufficient_array_dimensionality);
+      }
+
+      // Excessive array dimensionality and malformed data.
+      {
+        auto bytes = make_header(20, {1});
+        append_int8(bytes, 1);
+        const auto data = make_data(bytes);
+        std::error_condition cond;
+        try {
+          pgfe::to<std::vector<std::vector<long long>>>(data.get());
+        } catch (const pgfe::Client_exception& e) {
+          cond = e.condition();
+        }
+        ASSERT(cond == pgfe::Client_errc::excessive_array_dimensionality);
+
+        cond = {};
+        try {
+          pgfe::to<std::vector<long long>>(make_data(bytes.substr(0, bytes.size() - 1)).get());
+        } catch (const pgfe::Client_exception& e) {
+          cond = e.condition();
+        }
+        ASSERT(cond == pgfe::Client_errc::malformed_array_literal);
+
+        // The dimensions which don't match the size of the data.
+        const auto condition_of = [](const auto& convert)
+        {
+          try {
+            convert();
+          } catch (const pgfe::Client_exception& e) {
+            return e.condition();
+          }
+          return std::error_condition{};
+        };
+        const auto malformed = pgfe::Client_errc::malformed_array_literal;
+        ASSERT(condition_of([&]
+        {
+          pgfe::to<std::vector<long long>>(make_data(make_header(20, {2147483647})).get());
+        }) == malformed);
+        ASSERT(condition_of([&]
+        {
+          pgfe::to<std::list<long long>>(make_data(make_header(20, {2147483647})).get());
+        }) == malformed);
+        ASSERT(condition_of([&]
+        {
+          using Vec2 = std::vector<std::vector<long long>>;
+          pgfe::to<Vec2>(make_data(make_header(20, {2147483647, 1})).get());
+        }) == malformed);
+        ASSERT(condition_of([&]
+        {
+          using Vec2 = std::vector<std::vector<long long>>;
+          pgfe::to<Vec2>(make_data(make_header(20, {65536, 0})).get());
+        }) == malformed);
+      }
     }
   } catch (const std::exception& e) {
     report_failure(argv[0], e);
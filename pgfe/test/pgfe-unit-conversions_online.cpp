@@ -8,9 +8,13 @@
 #include "../../pgfe/row.hpp"
 #include "../../pgfe/sql_string.hpp"
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <optional>
 #include <limits>
 #include <string>
+#include <vector>
 
 namespace pgfe = dmitigr::pgfe;
 namespace testo = dmitigr::testo;
@@ -115,6 +119,55 @@ try {
         ASSERT(to<bool>(row[1]) == false);
       }, "SELECT true, $1::boolean", false);
     }
+
+    // timestamptz and date
+    {
+      using Time_point = std::chrono::system_clock::time_point;
+      const Time_point tp{std::chrono::microseconds{1234567890123456}};
+      conn->execute([tp](auto&& row)
+      {
+        ASSERT(to<Time_point>(row[0]) == tp);
+        ASSERT(to<Time_point>(row[1]) == Time_point{std::chrono::seconds{946684800}});
+      }, "SELECT $1::timestamptz, '2000-01-01'::date", tp);
+    }
+
+    // bytea and uuid
+    {
+      using Bytea = std::vector<std::byte>;
+      using Uuid = std::array<std::byte, 16>;
+      const Bytea bytea{std::byte{0}, std::byte{1}, std::byte{0xff}};
+      conn->execute([&bytea](auto&& row)
+      {
+        ASSERT(to<Bytea>(row[0]) == bytea);
+        ASSERT(to<Uuid>(row[1])[0] == std::byte{0xa0});
+      }, "SELECT $1::bytea, 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid", bytea);
+    }
+
+    // parameters in binary format
+    {
+      const auto ps = conn->prepare("SELECT $1::smallint, $2::integer, $3::bigint,"
+        " $4::real, $5::double precision, $6::boolean, $7::timestamptz, $8::bytea");
+      const Data_format bin{Data_format::binary};
+      ps->bind(0, short{-1}, bin)
+        .bind(1, -2, bin)
+        .bind(2, -3LL, bin)
+        .bind(3, -4.5f, bin)
+        .bind(4, -5.5, bin)
+        .bind(5, true, bin)
+        .bind(6, std::chrono::system_clock::time_point{}, bin)
+        .bind(7, std::vector<std::byte>{std::byte{42}}, bin);
+      ps->execute([](auto&& row)
+      {
+        ASSERT(to<short>(row[0]) == -1);
+        ASSERT(to<int>(row[1]) == -2);
+        ASSERT(to<long long>(row[2]) == -3);
+        ASSERT(to<float>(row[3]) == -4.5f);
+        ASSERT(to<double>(row[4]) == -5.5);
+        ASSERT(to<bool>(row[5]));
+        ASSERT(to<std::chrono::system_clock::time_point>(row[6]).time_since_epoch().count() == 0);
+        ASSERT(to<std::vector<std::byte>>(row[7]).at(0) == std::byte{42});
+      });
+    }
   }
 } catch (const std::exception& e) {
   testo::report_failure(argv[0], e);
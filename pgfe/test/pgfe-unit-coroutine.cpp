@@ -0,0 +1,196 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::to;
+
+  constexpr int connection_count{4};
+  constexpr int request_count{20};
+
+  pgfe::Reactor reactor;
+
+  // Awaiting the operations of many connections from a single thread.
+  {
+    std::vector<std::unique_ptr<pgfe::Connection>> connections;
+    std::vector<std::unique_ptr<pgfe::Awaitable_connection>> aconnections;
+    for (int i = 0; i < connection_count; ++i) {
+      connections.push_back(pgfe::test::make_connection());
+      aconnections.push_back(std::make_unique<pgfe::Awaitable_connection>(
+          reactor, *connections.back()));
+    }
+
+    int sum{};
+    std::vector<pgfe::Task> tasks;
+    for (auto& aconn : aconnections) {
+      tasks.push_back([](pgfe::Awaitable_connection& aconn, int& sum) -> pgfe::Task
+      {
+        co_await aconn.connect();
+        ASSERT(aconn.connection().is_connected());
+
+        auto* const ps = co_await aconn.prepare("select $1::int + $2::int");
+        ASSERT(ps && ps->is_preparsed());
+        ASSERT(ps->parameter_count() == 2);
+
+        for (int j = 0; j < request_count; ++j) {
+          const auto result = co_await aconn.execute(
+            "select generate_series(1, $1::int)", j);
+          ASSERT(result.completion.operation_name() == "SELECT");
+          ASSERT(result.rows.size() == static_cast<std::size_t>(j));
+          for (const auto& row : result.rows)
+            sum += to<int>(row[0]);
+        }
+
+        // Errors are thrown.
+        bool is_thrown{};
+        try {
+          co_await aconn.execute("provoke syntax error");
+        } catch (const pgfe::Server_exception& e) {
+          ASSERT(e.error().condition() == pgfe::Server_errc::c42_syntax_error);
+          is_thrown = true;
+        }
+        ASSERT(is_thrown);
+        const auto result = co_await aconn.execute("select 1");
+        ASSERT(result.rows.size() == 1);
+      }(*aconn, sum));
+      ASSERT(!tasks.back().is_done());
+    }
+
+    reactor.run();
+    for (const auto& task : tasks) {
+      ASSERT(task.is_done());
+      task.get();
+    }
+    ASSERT(sum == connection_count * 1330);
+  }
+  ASSERT(!reactor.size());
+
+  // Resumption via the executor.
+  {
+    std::deque<std::coroutine_handle<>> ready;
+    const auto conn = pgfe::test::make_connection();
+    pgfe::Awaitable_connection aconn{reactor, *conn,
+      [&ready](const auto handle){ ready.push_back(handle); }};
+    bool is_completed{};
+    auto task = [](pgfe::Awaitable_connection& aconn, bool& is_completed) -> pgfe::Task
+    {
+      const auto result = co_await aconn.execute("select $1::int", 7);
+      ASSERT(to<int>(result.rows.at(0)[0]) == 7);
+      is_completed = true;
+    }(aconn, is_completed);
+    while (!task.is_done()) {
+      reactor.run_once();
+      for (; !ready.empty(); ready.pop_front())
+        ready.front().resume();
+    }
+    task.get();
+    ASSERT(is_completed);
+  }
+
+  // Connection failures.
+  {
+    pgfe::Connection conn{pgfe::test::connection_options().port(1)};
+    pgfe::Awaitable_connection aconn{reactor, conn};
+    bool is_thrown{};
+    auto task = [](pgfe::Awaitable_connection& aconn, bool& is_thrown) -> pgfe::Task
+    {
+      try {
+        co_await aconn.execute("select 1");
+      } catch (const std::exception&) {
+        is_thrown = true;
+      }
+    }(aconn, is_thrown);
+    reactor.run();
+    ASSERT(task.is_done());
+    task.get();
+    ASSERT(is_thrown);
+    ASSERT(!reactor.contains(conn));
+  }
+
+  // Acquisition of connections from the pool.
+  {
+    pgfe::Connection_pool pool{1, pgfe::test::connection_options()};
+    pool.connect();
+    std::deque<std::coroutine_handle<>> ready;
+    const pgfe::Coroutine_executor executor = [&ready](const auto handle)
+    {
+      ready.push_back(handle);
+    };
+    const auto acquire = [](pgfe::Connection_pool& pool,
+      pgfe::Coroutine_executor executor, bool& is_acquired) -> pgfe::Task
+    {
+      auto handle = co_await pgfe::connection(pool, std::move(executor));
+      is_acquired = handle.is_valid();
+      if (is_acquired)
+        ASSERT(handle->is_connected());
+    };
+
+    // The free connection is acquired right away.
+    bool is_acquired{};
+    auto task = acquire(pool, executor, is_acquired);
+    ASSERT(task.is_done());
+    task.get();
+    ASSERT(is_acquired);
+    ASSERT(ready.empty());
+
+    // The coroutine waits for the release without blocking the thread.
+    auto handle = pool.connection();
+    ASSERT(handle);
+    is_acquired = false;
+    task = acquire(pool, executor, is_acquired);
+    ASSERT(!task.is_done());
+    ASSERT(pool.waiter_count() == 1);
+    ASSERT(ready.empty());
+    handle.release();
+    ASSERT(!pool.waiter_count());
+    ASSERT(ready.size() == 1);
+    ready.front().resume();
+    ready.pop_front();
+    ASSERT(task.is_done());
+    task.get();
+    ASSERT(is_acquired);
+    ASSERT(pool.free_count() == 1);
+
+    // The waiting is cancelled by disconnection.
+    handle = pool.connection();
+    ASSERT(handle);
+    is_acquired = true;
+    task = acquire(pool, executor, is_acquired);
+    ASSERT(!task.is_done());
+    pool.disconnect();
+    ASSERT(ready.size() == 1);
+    ready.front().resume();
+    ready.pop_front();
+    ASSERT(task.is_done());
+    task.get();
+    ASSERT(!is_acquired);
+    handle.release();
+    ASSERT(!pool.waiter_count());
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
+
+#else
+
+int main()
+{}
+
+#endif
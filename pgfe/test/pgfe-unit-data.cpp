@@ -57,6 +57,34 @@ try {
     ASSERT(to<std::string_view>(*d) == name);
   }
 
+  // Small and large data (the small data is stored inline)
+  {
+    for (std::size_t sz = 0; sz <= 64; ++sz) {
+      const std::string bytes(sz, 'x');
+      for (const auto format : {pgfe::Data_format::text, pgfe::Data_format::binary}) {
+        std::vector<std::unique_ptr<pgfe::Data>> datas;
+        datas.push_back(pgfe::Data::make(std::string_view{bytes}, format));
+        datas.push_back(pgfe::Data::make(std::string{bytes}, format));
+        datas.push_back(datas.front()->to_data());
+        datas.push_back(pgfe::Data_view{bytes.data(), static_cast<int>(sz), format}.to_data());
+        for (const auto& d : datas) {
+          ASSERT(d->format() == format);
+          ASSERT(d->size() == sz);
+          ASSERT(d->is_empty() == !sz);
+          ASSERT(static_cast<const char*>(d->bytes())[sz] == '\0');
+          ASSERT(to<std::string_view>(*d) == bytes);
+        }
+      }
+    }
+
+    // The released instances are reused.
+    for (int i = 0; i < 10000; ++i) {
+      const auto d1 = pgfe::Data::make("small");
+      const auto d2 = d1->to_data();
+      ASSERT(*d1 == *d2);
+    }
+  }
+
   // ---------------------------------------------------------------------------
   // Operators
   // ---------------------------------------------------------------------------
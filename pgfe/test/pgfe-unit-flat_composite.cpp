@@ -0,0 +1,176 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "../../testo.hpp"
+#include "../../pgfe/flat_composite.hpp"
+
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int, char* argv[])
+{
+  namespace pgfe = dmitigr::pgfe;
+  using namespace dmitigr::testo;
+
+  try {
+    pgfe::Flat_composite composite;
+    ASSERT(composite.size() == 0);
+    ASSERT(composite.is_empty());
+    ASSERT(composite.index_of("foo") == 0);
+
+    // Modifying the composite.
+    composite.append("foo", nullptr);
+    ASSERT(composite.size() == 1);
+    ASSERT(!composite.is_empty());
+    ASSERT(composite.name_of(0) == "foo");
+    ASSERT(composite.index_of("foo") == 0);
+    ASSERT(!composite.data(0));
+    ASSERT(!composite.data("foo"));
+    composite.set_data("foo", "foo data");
+    ASSERT(pgfe::to<std::string_view>(composite.data(0)) == "foo data");
+    ASSERT(pgfe::to<std::string_view>(composite["foo"]) == "foo data");
+    //
+    composite.append("bar", std::string{"bar data"});
+    composite.append("baz", 1983);
+    composite.append("empty", "");
+    composite.append("null", std::optional<int>{});
+    ASSERT(composite.size() == 5);
+    ASSERT(composite.index_of("bar") == 1);
+    ASSERT(pgfe::to<std::string>(composite.data("bar")) == "bar data");
+    ASSERT(pgfe::to<int>(composite.data("baz")) == 1983);
+    ASSERT(composite.data("empty") && composite.data("empty").size() == 0);
+    ASSERT(!composite.data("null"));
+    composite.set_data("baz", pgfe::to_data(2020, pgfe::Data_format::binary));
+    ASSERT(composite.data("baz").format() == pgfe::Data_format::binary);
+    ASSERT(pgfe::to<int>(composite.data("baz")) == 2020);
+    composite.set_data("baz", nullptr);
+    ASSERT(!composite.data("baz"));
+
+    // Copying.
+    {
+      const auto copy = composite;
+      ASSERT(copy.size() == composite.size());
+      for (std::size_t i = 0; i < copy.size(); ++i) {
+        ASSERT(copy.name_of(i) == composite.name_of(i));
+        ASSERT(static_cast<bool>(copy.data(i)) == static_cast<bool>(composite.data(i)));
+      }
+      ASSERT(pgfe::to<std::string_view>(copy.data("foo")) == "foo data");
+    }
+
+    // Conversions from/to Composite.
+    {
+      const auto converted = composite.to_composite();
+      ASSERT(converted.size() == composite.size());
+      ASSERT(pgfe::to<std::string_view>(converted.data("bar").get()) == "bar data");
+      ASSERT(!converted.data("null"));
+      const pgfe::Flat_composite flat{converted};
+      ASSERT(flat.size() == converted.size());
+      ASSERT(pgfe::to<std::string_view>(flat.data("foo")) == "foo data");
+    }
+
+    // Removing.
+    composite.remove("foo");
+    ASSERT(composite.size() == 4);
+    ASSERT(composite.index_of("foo") == composite.size());
+    ASSERT(pgfe::to<std::string_view>(composite.data(0)) == "bar data");
+    composite.remove(0);
+    ASSERT(composite.index_of("bar") == composite.size());
+    composite.clear();
+    ASSERT(composite.is_empty());
+
+    // Hash index and duplicate names.
+    {
+      const std::size_t count{pgfe::Flat_composite::hash_threshold * 4};
+      for (std::size_t i = 0; i < count; ++i)
+        composite.append("f" + std::to_string(i % (count / 2)), static_cast<int>(i));
+      for (std::size_t i = 0; i < count / 2; ++i) {
+        const auto name = "f" + std::to_string(i);
+        ASSERT(composite.index_of(name) == i);
+        ASSERT(composite.index_of(name, i + 1) == i + count / 2);
+        ASSERT(composite.index_of(name, i + count / 2 + 1) == composite.size());
+      }
+      ASSERT(composite.index_of("nonexistent") == composite.size());
+
+      // Overwriting the data many times must not grow the buffer infinitely.
+      for (int i = 0; i < 10000; ++i)
+        composite.set_data(0, std::string(100, 'x'));
+      ASSERT(composite.data(0).size() == 100);
+      ASSERT(pgfe::to<int>(composite.data("f1")) == 1);
+
+      // The index is concurrently readable.
+      {
+        const auto& fc = composite;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+          threads.emplace_back([&fc, count]
+          {
+            for (std::size_t i = 0; i < count / 2; ++i)
+              ASSERT(fc.index_of("f" + std::to_string(i)) == i);
+          });
+        }
+        for (auto& thread : threads)
+          thread.join();
+      }
+
+      // The index is updated upon removal.
+      composite.remove(0);
+      ASSERT(composite.index_of("f0") == count / 2 - 1);
+      ASSERT(composite.index_of("f1") == 0);
+      ASSERT(pgfe::to<int>(composite.data("f1")) == 1);
+      composite.append("new", 1);
+      ASSERT(composite.index_of("new") == count - 1);
+      while (composite.size() > 1)
+        composite.remove(0);
+      ASSERT(composite.index_of("new") == 0);
+    }
+
+    // Copying of the own fields (the buffer can be reallocated meanwhile).
+    {
+      pgfe::Flat_composite fc;
+      const std::string big(1000, 'b');
+      fc.append("foo", "foo data");
+      fc.append("big", big);
+      fc.append("null", nullptr);
+      for (int i = 0; i < 100; ++i)
+        fc.append(fc.name_of(0), fc.data(0));
+      // The reallocation of the buffer can happen on appending the name.
+      for (std::size_t sz = 1; sz < 64; ++sz) {
+        pgfe::Flat_composite c;
+        c.append("f", std::string(sz, 'x'));
+        for (int i = 0; i < 8; ++i) {
+          c.append("f", c.data(0));
+          ASSERT(pgfe::to<std::string_view>(c.data(i + 1)) == std::string(sz, 'x'));
+        }
+      }
+      fc.append("copy", fc.data("big"));
+      fc.append(fc.name_of(1), fc.name_of(0));
+      for (std::size_t i = 3; i < 103; ++i) {
+        ASSERT(fc.name_of(i) == "foo");
+        ASSERT(pgfe::to<std::string_view>(fc.data(i)) == "foo data");
+      }
+      ASSERT(pgfe::to<std::string_view>(fc.data("copy")) == big);
+      ASSERT(fc.name_of(104) == "big");
+      ASSERT(pgfe::to<std::string_view>(fc.data(104)) == "foo");
+
+      for (int i = 0; i < 100; ++i) {
+        fc.set_data("foo", fc.data(1));
+        fc.set_data("big", fc.data(0));
+      }
+      ASSERT(pgfe::to<std::string_view>(fc.data(0)) == big);
+      ASSERT(pgfe::to<std::string_view>(fc.data(1)) == big);
+      fc.set_data("big", fc.data("null"));
+      ASSERT(!fc.data(1));
+      fc.set_data(2, fc.name_of(0));
+      ASSERT(pgfe::to<std::string_view>(fc.data("null")) == "foo");
+    }
+  } catch (const std::exception& e) {
+    report_failure(argv[0], e);
+    return 1;
+  } catch (...) {
+    report_failure(argv[0]);
+    return 1;
+  }
+}
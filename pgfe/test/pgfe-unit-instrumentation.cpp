@@ -0,0 +1,124 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using std::chrono::microseconds;
+  using std::chrono::milliseconds;
+
+  // query_hash()
+  {
+    static_assert(pgfe::query_hash("") == 14695981039346656037ULL);
+    ASSERT(pgfe::query_hash("select 1") == pgfe::query_hash("select 1"));
+    ASSERT(pgfe::query_hash("select 1") != pgfe::query_hash("select 2"));
+  }
+
+  // Latency_histogram
+  {
+    pgfe::Latency_histogram h;
+    ASSERT(!h.count());
+    ASSERT(h.value_at_percentile(50) == microseconds{});
+
+    for (int i = 1; i <= 1000; ++i)
+      h.record(microseconds{i});
+    ASSERT(h.count() == 1000);
+    ASSERT(h.min() == microseconds{1});
+    ASSERT(h.max() == microseconds{1000});
+    ASSERT(h.mean() == microseconds{500});
+    const auto is_near = [](const microseconds value, const std::int64_t expected)
+    {
+      const auto error = static_cast<double>(expected) / pgfe::Latency_histogram::sub_bucket_count;
+      return value.count() >= expected && value.count() <= expected + error;
+    };
+    ASSERT(h.value_at_percentile(0) == microseconds{1});
+    ASSERT(h.value_at_percentile(1) == microseconds{10});
+    ASSERT(is_near(h.value_at_percentile(50), 500));
+    ASSERT(is_near(h.value_at_percentile(99), 990));
+    ASSERT(h.value_at_percentile(100) == microseconds{1000});
+
+    // Large values.
+    pgfe::Latency_histogram h2;
+    h2.record(std::chrono::hours{24 * 365});
+    ASSERT(h2.max() == pgfe::Latency_histogram::max_value());
+    h2.record(milliseconds{1500});
+    ASSERT(is_near(h2.value_at_percentile(50), 1500000));
+
+    // Merge.
+    h.merge(h2);
+    ASSERT(h.count() == 1002);
+    ASSERT(h.max() == pgfe::Latency_histogram::max_value());
+    h.clear();
+    ASSERT(!h.count() && h.max() == microseconds{});
+  }
+
+  // Statement_statistics
+  {
+    const pgfe::Connection conn;
+    pgfe::Statement_statistics stats;
+    const auto execute = [&conn, &stats](const std::string& query,
+      const milliseconds latency, const std::string& sqlstate = {})
+    {
+      pgfe::Request_metrics m;
+      m.kind = pgfe::Request_kind::execution;
+      m.query_hash = pgfe::query_hash(query);
+      m.sent_at = pgfe::Request_metrics::Clock::now();
+      stats.on_send(conn, m, query);
+      m.first_response_at = m.sent_at + latency / 2;
+      m.completed_at = m.sent_at + latency;
+      m.row_count = 2;
+      m.byte_count = 10;
+      m.sqlstate = sqlstate;
+      stats.on_complete(conn, m);
+    };
+    for (int i = 0; i < 100; ++i) {
+      execute("select fast", milliseconds{1});
+      execute("select slow", milliseconds{100});
+      execute("select medium", milliseconds{i < 99 ? 1 : 1000});
+    }
+    execute("select error", milliseconds{1}, "42601");
+
+    // Preparations are not accounted.
+    {
+      pgfe::Request_metrics m;
+      m.kind = pgfe::Request_kind::preparation;
+      m.query_hash = pgfe::query_hash("select prepared");
+      stats.on_send(conn, m, "select prepared");
+      stats.on_complete(conn, m);
+    }
+
+    ASSERT(stats.entries().size() == 4);
+    auto slowest = stats.slowest(2);
+    ASSERT(slowest.size() == 2);
+    ASSERT(slowest[0].query == "select slow");
+    ASSERT(slowest[0].latency.count() == 100);
+    ASSERT(slowest[0].row_count == 200);
+    ASSERT(slowest[0].byte_count == 1000);
+    ASSERT(slowest[1].query == "select fast" || slowest[1].query == "select medium");
+    slowest = stats.slowest(1, 100);
+    ASSERT(slowest.size() == 1 && slowest[0].query == "select medium");
+    for (const auto& e : stats.entries()) {
+      if (e.query == "select error") {
+        ASSERT(e.error_count == 1);
+        ASSERT(e.last_sqlstate == "42601");
+      } else
+        ASSERT(!e.error_count);
+    }
+    stats.clear();
+    ASSERT(stats.entries().empty());
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
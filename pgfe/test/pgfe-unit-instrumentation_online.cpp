@@ -0,0 +1,144 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+namespace {
+
+struct Recorder final : pgfe::Instrument {
+  std::vector<std::string> events;
+  std::vector<pgfe::Request_kind> sent_kinds;
+  std::vector<pgfe::Request_metrics> completed;
+
+  void on_send(const pgfe::Connection&, const pgfe::Request_metrics& m,
+    const std::string_view query) override
+  {
+    ASSERT(m.sent_at.time_since_epoch().count());
+    events.push_back("send " + std::string{query});
+    sent_kinds.push_back(m.kind);
+  }
+
+  void on_first_response(const pgfe::Connection&, const pgfe::Request_metrics& m) override
+  {
+    ASSERT(m.first_response_at && *m.first_response_at >= m.sent_at);
+    events.push_back("first");
+  }
+
+  void on_result(const pgfe::Connection&, const pgfe::Request_metrics&) override
+  {
+    events.push_back("result");
+  }
+
+  void on_complete(const pgfe::Connection&, const pgfe::Request_metrics& m) override
+  {
+    ASSERT(m.completed_at && *m.completed_at >= *m.first_response_at);
+    events.push_back("complete");
+    completed.push_back(m);
+  }
+};
+
+} // namespace
+
+int main(int, char* argv[])
+try {
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  auto recorder = std::make_shared<Recorder>();
+  conn->set_instrument(recorder);
+  ASSERT(conn->instrument() == recorder);
+
+  // Execution.
+  conn->execute([](auto&&){}, "select generate_series(1, 3)::text");
+  ASSERT((recorder->events == std::vector<std::string>{
+    "send select generate_series(1, 3)::text",
+    "first", "result", "result", "result", "complete"}));
+  {
+    const auto& m = recorder->completed.back();
+    ASSERT(m.kind == pgfe::Request_kind::execution);
+    ASSERT(m.query_hash == pgfe::query_hash("select generate_series(1, 3)::text"));
+    ASSERT(m.statement_name.empty());
+    ASSERT(m.result_count == 3);
+    ASSERT(m.row_count == 3);
+    ASSERT(m.byte_count == 3);
+    ASSERT(!m.is_failed());
+    ASSERT(m.latency() >= m.first_response_latency());
+  }
+
+  // Error.
+  try {
+    conn->execute("provoke syntax error");
+  } catch (const pgfe::Server_exception&) {}
+  ASSERT(recorder->completed.back().sqlstate == "42601");
+  ASSERT(recorder->completed.back().is_failed());
+
+  // Preparation, execution and deallocation of the named statement.
+  {
+    auto* const ps = conn->prepare("select $1::int", "ps");
+    ASSERT(recorder->completed.back().kind == pgfe::Request_kind::preparation);
+    const auto hash = recorder->completed.back().query_hash;
+    ps->bind(0, 1).execute();
+    ASSERT(recorder->completed.back().kind == pgfe::Request_kind::execution);
+    ASSERT(recorder->completed.back().statement_name == "ps");
+    ASSERT(recorder->completed.back().query_hash == hash);
+    ASSERT(recorder->completed.back().row_count == 1);
+    recorder->events.clear();
+    conn->unprepare("ps");
+    ASSERT(recorder->sent_kinds.back() == pgfe::Request_kind::deallocation);
+    ASSERT(recorder->events.front() == "send DEALLOCATE \"ps\"");
+    ASSERT(recorder->completed.back().kind == pgfe::Request_kind::deallocation);
+    ASSERT(recorder->completed.back().statement_name == "ps");
+  }
+
+  // Pipeline.
+  {
+    recorder->completed.clear();
+    conn->set_pipeline_enabled();
+    conn->execute_nio("select 1");
+    conn->execute_nio("provoke syntax error");
+    conn->execute_nio("select 2");
+    conn->send_sync();
+    for (int i = 0; i < 3; ++i)
+      conn->process_responses([](auto&&, auto&&){});
+    conn->process_responses([](auto&&, auto&&){}); // sync
+    conn->set_pipeline_enabled(false);
+    ASSERT(recorder->completed.size() == 3);
+    ASSERT(!recorder->completed[0].is_failed());
+    ASSERT(recorder->completed[1].sqlstate == "42601");
+    ASSERT(recorder->completed[2].is_aborted);
+  }
+
+  // Statistics.
+  {
+    auto stats = std::make_shared<pgfe::Statement_statistics>();
+    conn->set_instrument(stats);
+    for (int i = 0; i < 10; ++i) {
+      conn->execute("select pg_catalog.pg_sleep(0.01)");
+      conn->execute("select 1");
+    }
+    const auto slowest = stats->slowest(1);
+    ASSERT(slowest.size() == 1);
+    ASSERT(slowest[0].query == "select pg_catalog.pg_sleep(0.01)");
+    ASSERT(slowest[0].latency.count() == 10);
+    ASSERT(slowest[0].latency.min() >= std::chrono::milliseconds{10});
+  }
+
+  // Turning off.
+  conn->set_instrument(nullptr);
+  recorder->events.clear();
+  conn->execute("select 1");
+  ASSERT(recorder->events.empty());
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
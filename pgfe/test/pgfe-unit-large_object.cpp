@@ -0,0 +1,106 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#ifdef _WIN32
+#define DMITIGR_PGFE_TEST_FILENO _fileno
+#else
+#define DMITIGR_PGFE_TEST_FILENO fileno
+#endif
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using Open_mode = pgfe::Large_object_open_mode;
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("begin");
+
+  const auto oid = conn->create_large_object();
+  ASSERT(oid != pgfe::invalid_oid);
+  auto lob = conn->open_large_object(oid, Open_mode::reading | Open_mode::writing);
+  ASSERT(lob.is_valid());
+
+  // The content which is not a multiple of the chunk size.
+  std::string content;
+  for (int i = 0; content.size() < 100000; ++i)
+    content.append(std::to_string(i)).append(1, '\0');
+
+  // Streaming.
+  {
+    pgfe::Large_object_streambuf buf{lob, 1000, 3};
+    std::ostream out{&buf};
+    out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    ASSERT(out.flush());
+    ASSERT(out.tellp() == static_cast<std::streamoff>(content.size()));
+
+    std::istream in{&buf};
+    ASSERT(in.seekg(0));
+    std::string read(content.size() + 1, '\1');
+    in.read(read.data(), static_cast<std::streamsize>(read.size()));
+    ASSERT(in.gcount() == static_cast<std::streamsize>(content.size()));
+    read.resize(content.size());
+    ASSERT(read == content);
+
+    // Mixing reads and writes.
+    in.clear();
+    ASSERT(in.seekg(1));
+    ASSERT(in.get() == content[1]);
+    ASSERT(in.tellg() == 2);
+    out.put('x');
+    ASSERT(out.flush());
+    ASSERT(in.seekg(0));
+    ASSERT(in.get() == content[0]);
+    ASSERT(in.get() == content[1]);
+    ASSERT(in.get() == 'x');
+    ASSERT(in.get() == content[3]);
+    content[2] = 'x';
+  }
+
+  // Transfers to and from the file descriptor.
+  {
+    std::FILE* const file = std::tmpfile();
+    ASSERT(file);
+    const int fd = DMITIGR_PGFE_TEST_FILENO(file);
+
+    for (const std::size_t read_ahead : {1, 4}) {
+      ASSERT(lob.seek(0, pgfe::Large_object_seek_whence::begin) == 0);
+      std::rewind(file);
+      ASSERT(lob.read_to(fd, 4096, read_ahead) ==
+        static_cast<std::int_fast64_t>(content.size()));
+    }
+
+    ASSERT(lob.truncate(0));
+    ASSERT(lob.seek(0, pgfe::Large_object_seek_whence::begin) == 0);
+    std::rewind(file);
+    ASSERT(lob.write_from(fd, 4096, 3) ==
+      static_cast<std::int_fast64_t>(content.size()));
+    ASSERT(conn->is_ready_for_request());
+
+    std::string read(content.size(), '\0');
+    ASSERT(lob.seek(0, pgfe::Large_object_seek_whence::begin) == 0);
+    ASSERT(lob.read(read.data(), 1000, 1000) == content.size());
+    ASSERT(read == content);
+    std::fclose(file);
+  }
+
+  ASSERT(lob.close());
+  ASSERT(conn->remove_large_object(oid));
+  conn->execute("commit");
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,137 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using namespace std::chrono_literals;
+  using pgfe::to;
+
+  pgfe::Notification_hub hub{pgfe::test::connection_options()};
+  const auto notifier = pgfe::test::make_connection();
+  notifier->connect();
+
+  const auto receive = [&hub](const auto& subscription, const std::size_t count)
+  {
+    for (int i = 0; i < 100 && subscription->size() < count; ++i)
+      hub.run_once(100ms);
+    ASSERT(subscription->size() == count);
+  };
+
+  // Subscribing many subscribers on the single connection.
+  constexpr int subscriber_count{16};
+  std::vector<std::shared_ptr<pgfe::Notification_hub::Subscription>> subscriptions;
+  for (int i = 0; i < subscriber_count; ++i)
+    subscriptions.push_back(hub.subscribe(i % 2 ? "pgfe_test_odd" : "pgfe_test_even", 8));
+  ASSERT(hub.subscription_count() == subscriber_count);
+  ASSERT(subscriptions.front()->capacity() == 8);
+  hub.run_once(0ms);
+  ASSERT(hub.connection().is_connected());
+
+  // Fan-out.
+  notifier->execute("select pg_notify('pgfe_test_even', 'e1')");
+  notifier->execute("select pg_notify('pgfe_test_odd', 'o1')");
+  notifier->execute("select pg_notify('pgfe_test_odd', 'o2')");
+  receive(subscriptions[1], 2);
+  for (int i = 0; i < subscriber_count; ++i) {
+    auto& sub = subscriptions[i];
+    ASSERT(!sub->reset_missed());
+    if (i % 2) {
+      ASSERT(to<std::string_view>(sub->pop()->payload()) == "o1");
+      ASSERT(to<std::string_view>(sub->pop()->payload()) == "o2");
+    } else {
+      const auto n = sub->pop();
+      ASSERT(n && n->channel_name() == "pgfe_test_even");
+      ASSERT(to<std::string_view>(n->payload()) == "e1");
+    }
+    ASSERT(!sub->pop());
+  }
+
+  // Overflow.
+  for (int i = 0; i < 10; ++i)
+    notifier->execute("select pg_notify('pgfe_test_even', $1)", std::to_string(i));
+  receive(subscriptions[0], 8);
+  ASSERT(subscriptions[0]->reset_missed());
+  ASSERT(!subscriptions[0]->reset_missed());
+  ASSERT(subscriptions[0]->dropped_count() == 2);
+  for (int i = 0; i < 8; ++i)
+    ASSERT(to<int>(subscriptions[0]->pop()->payload()) == i);
+
+  // Consuming from the other thread.
+  {
+    std::atomic<int> consumed{};
+    std::thread consumer{[&consumed, sub = subscriptions[1]]
+    {
+      for (int expected{}; expected < 100;) {
+        if (const auto n = sub->pop()) {
+          ASSERT(to<int>(n->payload()) == expected);
+          ++expected;
+          ++consumed;
+        } else
+          std::this_thread::yield();
+      }
+    }};
+    for (int i = 0; i < 100; ++i) {
+      notifier->execute("select pg_notify('pgfe_test_odd', $1)", std::to_string(i));
+      while (subscriptions[1]->size() == subscriptions[1]->capacity())
+        std::this_thread::yield();
+      hub.run_once(10ms);
+    }
+    for (int i = 0; i < 100 && consumed < 100; ++i)
+      hub.run_once(10ms);
+    consumer.join();
+    ASSERT(consumed == 100);
+    ASSERT(!subscriptions[1]->reset_missed());
+  }
+  for (auto& sub : subscriptions) {
+    while (sub->pop());
+    sub->reset_missed();
+  }
+
+  // Resubscription after reconnect.
+  {
+    const auto pid = hub.connection().server_pid();
+    notifier->execute("select pg_terminate_backend($1)", pid);
+    for (int i = 0; i < 100 && hub.reconnect_count() == 0; ++i)
+      hub.run_once(10ms);
+    ASSERT(hub.reconnect_count() == 1);
+    ASSERT(hub.connection().server_pid() != pid);
+    for (auto& sub : subscriptions)
+      ASSERT(sub->reset_missed());
+    notifier->execute("select pg_notify('pgfe_test_even', 'after')");
+    receive(subscriptions[0], 1);
+    ASSERT(to<std::string_view>(subscriptions[0]->pop()->payload()) == "after");
+  }
+
+  // Unsubscribing.
+  {
+    for (int i = 0; i < subscriber_count; i += 2) {
+      ASSERT(hub.unsubscribe(*subscriptions[i]));
+      ASSERT(!subscriptions[i]->is_subscribed());
+      ASSERT(!hub.unsubscribe(*subscriptions[i]));
+    }
+    ASSERT(hub.subscription_count() == subscriber_count / 2);
+    notifier->execute("select pg_notify('pgfe_test_even', 'ignored')");
+    notifier->execute("select pg_notify('pgfe_test_odd', 'o3')");
+    receive(subscriptions[1], 1);
+    for (int i = 0; i < subscriber_count; ++i)
+      ASSERT(subscriptions[i]->size() == static_cast<std::size_t>(i % 2));
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,132 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using pgfe::to;
+
+  constexpr int connection_count{8};
+  constexpr int request_count{50};
+
+  pgfe::Reactor reactor;
+  ASSERT(reactor.is_idle());
+
+  // Half of the connections are in pipeline mode.
+  std::vector<std::unique_ptr<pgfe::Connection>> connections;
+  int connected_count{};
+  for (int i = 0; i < connection_count; ++i) {
+    connections.push_back(pgfe::test::make_connection());
+    reactor.add(*connections.back(), [&connected_count, i](auto& conn)
+    {
+      ASSERT(conn.is_connected());
+      if (i % 2)
+        conn.set_pipeline_enabled();
+      ++connected_count;
+    });
+  }
+  ASSERT(reactor.size() == connection_count);
+
+  // Requests are queued until the connections are established.
+  int completed_count{};
+  int row_sum{};
+  for (auto& conn : connections) {
+    for (int j = 0; j < request_count; ++j) {
+      reactor.execute(*conn, [&completed_count](auto&& comp, auto&& error)
+      {
+        ASSERT(comp && !error);
+        ASSERT(comp.operation_name() == "SELECT");
+        ++completed_count;
+      }, [&row_sum, j](auto&& row)
+      {
+        ASSERT(to<int>(row[0]) == j);
+        row_sum += to<int>(row[1]);
+      }, "select $1::int, generate_series(1, 3)", j);
+    }
+  }
+  ASSERT(!reactor.is_idle());
+  ASSERT(reactor.request_count() == connection_count * request_count);
+
+  reactor.run();
+  ASSERT(reactor.is_idle());
+  ASSERT(connected_count == connection_count);
+  ASSERT(completed_count == connection_count * request_count);
+  ASSERT(row_sum == connection_count * request_count * 6);
+
+  // Errors and chaining from the handlers.
+  {
+    auto& conn = *connections.front();
+    bool is_error{};
+    bool is_chained{};
+    reactor.execute(conn, [&](auto&& comp, auto&& error)
+    {
+      ASSERT(!comp && error);
+      is_error = true;
+      reactor.execute(conn, [&is_chained](auto&& comp, auto&&)
+      {
+        ASSERT(comp);
+        is_chained = true;
+      }, "select 1");
+    }, "provoke syntax error");
+    reactor.run();
+    ASSERT(is_error && is_chained);
+  }
+
+  // Removing.
+  for (auto& conn : connections) {
+    ASSERT(reactor.remove(*conn));
+    ASSERT(!reactor.contains(*conn));
+    if (conn->pipeline_status() != pgfe::Pipeline_status::disabled)
+      conn->set_pipeline_enabled(false);
+    ASSERT(conn->is_ready_for_request());
+    ASSERT(conn->execute("select 1"));
+  }
+  ASSERT(!reactor.size());
+
+  // Removing from the connect handler called by add().
+  {
+    auto& conn = *connections.front();
+    ASSERT(conn.is_connected());
+    bool is_connected{};
+    reactor.add(conn, [&](auto& c)
+    {
+      ASSERT(reactor.remove(c));
+      is_connected = true;
+    });
+    ASSERT(is_connected);
+    ASSERT(!reactor.contains(conn));
+    ASSERT(conn.execute("select 1"));
+  }
+
+  // Connection failures.
+  {
+    pgfe::Connection conn{pgfe::test::connection_options().port(1)};
+    bool is_failed{};
+    reactor.set_failure_handler([&](auto& failed, auto exception)
+    {
+      ASSERT(&failed == &conn);
+      ASSERT(exception);
+      is_failed = true;
+    });
+    reactor.add(conn);
+    reactor.execute(conn, [](auto&&, auto&&){ ASSERT(false); }, "select 1");
+    reactor.run();
+    ASSERT(is_failed);
+    ASSERT(!reactor.contains(conn));
+    ASSERT(reactor.is_idle());
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -0,0 +1,86 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+int main(int, char* argv[])
+try {
+  using Target = pgfe::Routing_pool::Target;
+  const auto options = pgfe::test::connection_options();
+  auto unreachable = pgfe::test::connection_options();
+  unreachable.port(1);
+
+  // The test server is not in recovery, so the "replicas" are out of rotation.
+  {
+    pgfe::Routing_pool pool{2, options, {options, unreachable}};
+    ASSERT(pool.replica_count() == 2);
+    pool.connect();
+    ASSERT(pool.is_primary_available());
+    ASSERT(!pool.is_in_rotation(0));
+    ASSERT(!pool.is_in_rotation(1));
+    ASSERT(pool.latency(0));
+    ASSERT(!pool.latency(1));
+
+    // Read-only work falls back to the primary.
+    auto handle = pool.connection(Target::replica);
+    ASSERT(handle && handle.pool() == &pool.primary());
+    ASSERT(handle->execute("select 1"));
+  }
+
+  // Rotation and balancing.
+  {
+    std::atomic<bool> is_in_recovery{true};
+    pgfe::Routing_pool pool{2, options, {options, options, unreachable}};
+    pool.set_recovery_check([&is_in_recovery](auto&)
+    {
+      return is_in_recovery.load();
+    });
+    pool.connect();
+    ASSERT(!pool.is_primary_available());
+    ASSERT(pool.is_in_rotation(0) && pool.is_in_rotation(1));
+    ASSERT(!pool.is_in_rotation(2));
+    ASSERT(!pool.connection(Target::primary));
+
+    // The replica with the least number of busy connections is selected.
+    std::vector<pgfe::Connection_pool::Handle> handles;
+    for (int i = 0; i < 4; ++i) {
+      handles.push_back(pool.connection(Target::replica));
+      ASSERT(handles.back());
+      ASSERT(handles.back().pool() != &pool.primary());
+    }
+    ASSERT(pool.replica(0).busy_count() == 2);
+    ASSERT(pool.replica(1).busy_count() == 2);
+    ASSERT(!pool.connection(Target::replica));
+    handles.clear();
+
+    // The replica with the least latency is selected.
+    pool.set_balancing(pgfe::Routing_pool::Balancing::latency);
+    ASSERT(pool.latency(0) && pool.latency(1));
+    const std::size_t fastest = *pool.latency(0) <= *pool.latency(1) ? 0 : 1;
+    {
+      const auto handle = pool.connection(Target::replica);
+      ASSERT(handle.pool() == &pool.replica(fastest));
+    }
+
+    // The replicas are out of rotation after promotion.
+    is_in_recovery = false;
+    ASSERT(pool.check() == 0);
+    ASSERT(pool.is_primary_available());
+    const auto handle = pool.connection(Target::replica);
+    ASSERT(handle && handle.pool() == &pool.primary());
+  }
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
@@ -24,6 +24,39 @@ try {
     ASSERT(row.info().index_of("theNumberOne") == 1);
   }, R"(select 1::integer theNumberOne, 1::integer "theNumberOne")");
 
+  // Duplicate names.
+  conn->execute([](auto&& row)
+  {
+    const auto& info = row.info();
+    ASSERT(info.index_of("a") == 0);
+    ASSERT(info.index_of("a", 1) == 2);
+    ASSERT(info.index_of("a", 3) == info.size());
+    ASSERT(info.index_of("b", 2) == info.size());
+    ASSERT(info.index_of("c") == info.size());
+  }, R"(select 1 a, 2 b, 3 a)");
+
+  // Wide rows.
+  {
+    constexpr std::size_t column_count{200};
+    std::string query{"select "};
+    for (std::size_t i = 0; i < column_count; ++i)
+      query.append(i ? ", " : "").append(std::to_string(i)).append(" c").append(std::to_string(i));
+
+    std::size_t row_count{};
+    conn->execute([&row_count](auto&& row)
+    {
+      const auto& info = row.info();
+      ASSERT(info.size() == column_count);
+      for (std::size_t i = 0; i < column_count; ++i) {
+        const auto index = info.index_of("c" + std::to_string(i));
+        ASSERT(index == i);
+        ASSERT(pgfe::to<int>(row[index]) == static_cast<int>(i));
+      }
+      row_count++;
+    }, query + " from generate_series(1, 100)");
+    ASSERT(row_count == 100);
+  }
+
   // ---------------------------------------------------------------------------
   // Row
   // ---------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+// -*- C++ -*-
+// Copyright (C) Dmitry Igrishin
+// For conditions of distribution and use, see files LICENSE.txt
+
+#include "pgfe-unit.hpp"
+#include "../../pgfe.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace testo = dmitigr::testo;
+
+namespace {
+
+struct Person final {
+  int id{};
+  std::string name;
+  std::optional<int> age;
+};
+
+} // namespace
+
+namespace dmitigr::pgfe {
+
+template<> struct Row_binding<Person> {
+  static constexpr auto columns()
+  {
+    return std::make_tuple(bind_column("id", &Person::id),
+      bind_column("name", &Person::name),
+      bind_column("age", &Person::age));
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+int main(int, char* argv[])
+try {
+  static_assert(pgfe::Row_decoder<Person>::column_count == 3);
+
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+
+  // Columns in the different order.
+  pgfe::Row_decoder<Person> decoder;
+  ASSERT(!decoder.is_resolved());
+  std::vector<Person> persons;
+  conn->execute([&](auto&& row)
+  {
+    persons.push_back(decoder.decode(row));
+    ASSERT(decoder.is_resolved());
+    ASSERT(decoder.column_index(0) == 2);
+    ASSERT(decoder.column_index(1) == 0);
+    ASSERT(decoder.column_index(2) == 1);
+  }, "select 'person' || i as name, nullif(i, 2) * 10 as age, i as id"
+     " from generate_series(1, 3) i");
+  ASSERT(persons.size() == 3);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT(persons[i].id == i + 1);
+    ASSERT(persons[i].name == "person" + std::to_string(i + 1));
+    ASSERT(persons[i].age == (i == 1 ? std::nullopt : std::optional<int>{(i + 1) * 10}));
+  }
+
+  // Indexes are resolved again for the other result.
+  conn->execute([&](auto&& row)
+  {
+    const auto person = decoder(row);
+    ASSERT(decoder.column_index(0) == 0);
+    ASSERT(person.id == 7);
+    ASSERT(person.name == "seven");
+    ASSERT(!person.age);
+  }, "select 7 id, 'seven' name, null::int age, 'extra' extra");
+
+  // Row batch.
+  {
+    conn->set_row_batch_size(10);
+    int total{};
+    conn->execute([&](pgfe::Row_batch&& batch)
+    {
+      for (std::size_t i = 0; i < batch.size(); ++i)
+        ASSERT(decoder.decode(batch, i).id == ++total);
+    }, "select i id, i::text name, i age from generate_series(1, 5) i");
+    ASSERT(total == 5);
+    conn->set_row_batch_size(1);
+  }
+
+  // Missing column.
+  conn->execute([](auto&& row)
+  {
+    bool is_thrown{};
+    try {
+      pgfe::Row_decoder<Person>{row.info()};
+    } catch (const std::runtime_error&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }, "select 1 id, 'one' name");
+} catch (const std::exception& e) {
+  testo::report_failure(argv[0], e);
+  return 1;
+} catch (...) {
+  testo::report_failure(argv[0]);
+  return 1;
+}
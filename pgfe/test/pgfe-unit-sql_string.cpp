@@ -8,6 +8,8 @@
 #include "../../pgfe/sql_string.hpp"
 
 #include <functional>
+#include <string>
+#include <string_view>
 
 int main(int, char* argv[])
 {
@@ -98,6 +100,39 @@ int main(int, char* argv[])
 
       std::cout << "Final SQL string is: " << s_orig.to_string() << std::endl;
     }
+
+    // Parse cache
+    {
+      pgfe::Sql_string::set_parse_cache_capacity(2);
+      ASSERT(pgfe::Sql_string::parse_cache_capacity() == 2);
+      ASSERT(pgfe::Sql_string::parse_cache_size() <= 2);
+
+      const std::string text{"/* $id$cached$id$ */ SELECT :a, $2, :a"};
+      const pgfe::Sql_string s1{text};
+      const pgfe::Sql_string s2{text};
+      ASSERT(pgfe::Sql_string::parse_cache_size() >= 1);
+      for (const auto* const str : {&s1, &s2}) {
+        ASSERT(str->to_string() == text);
+        ASSERT(str->to_query_string() == " SELECT $3, $2, $3");
+        ASSERT(str->parameter_count() == 3);
+        ASSERT(str->parameter_name(2) == "a");
+        const auto& id = str->extra().data("id");
+        ASSERT(id);
+        ASSERT(std::string_view(static_cast<const char*>(id->bytes()), id->size()) == "cached");
+      }
+
+      // Appending to itself.
+      auto s3 = s1;
+      s3.append(s3);
+      ASSERT(s3.to_string() == text + text);
+      ASSERT(s3.parameter_count() == 3);
+
+      pgfe::Sql_string::set_parse_cache_capacity(0);
+      ASSERT(pgfe::Sql_string::parse_cache_size() == 0);
+      const pgfe::Sql_string s4{text};
+      ASSERT(pgfe::Sql_string::parse_cache_size() == 0);
+      ASSERT(s4.to_string() == text);
+    }
   } catch (const std::exception& e) {
     report_failure(argv[0], e);
     return 1;
@@ -5,6 +5,9 @@
 #include "pgfe-unit.hpp"
 #include "../../str.hpp"
 
+#include <thread>
+#include <vector>
+
 namespace pgfe = dmitigr::pgfe;
 namespace str = dmitigr::str;
 namespace testo = dmitigr::testo;
@@ -44,6 +47,8 @@ try {
   const auto input = str::to_string(this_exe_dir_name / "pgfe-unit-sql_vector.sql");
   bunch = pgfe::Sql_vector{input};
   ASSERT(bunch.size() == 2);
+  ASSERT(pgfe::Sql_vector::from_file(this_exe_dir_name / "pgfe-unit-sql_vector.sql").to_string() ==
+    bunch.to_string());
   ASSERT(bunch[0].extra().size() == 1);
   ASSERT(bunch[1].extra().size() == 2);
   //
@@ -55,6 +60,57 @@ try {
   ASSERT(bunch[1].extra().index_of("id") == 0);
   ASSERT(bunch[1].extra().index_of("cond") == 1);
 
+  // Lookup with the offsets.
+  ASSERT(bunch.index_of("id", "plus_one", 1) == bunch.size());
+  ASSERT(bunch.index_of("id", "digit", 1) == 1);
+  ASSERT(bunch.index_of("cond", "n > 0\n  AND n < 2") == 1);
+  ASSERT(bunch.index_of("cond", "n > 0\n  AND n < 2", 0, 1) == 1);
+  ASSERT(bunch.index_of("id", "digit", 0, 1) == bunch.size());
+  ASSERT(bunch.index_of("id", "unknown") == bunch.size());
+
+  // Lookup after modifying the extra data by reference.
+  {
+    auto copy = bunch;
+    copy[0].extra().append("alias", pgfe::Data::make("one"));
+    copy.update_index();
+    ASSERT(copy.index_of("alias", "one") == 0);
+  }
+
+  // The index is kept up to date by the modifiers.
+  {
+    auto copy = bunch;
+    const pgfe::Sql_string extra{"-- $id$extra$id$\nSELECT 3"};
+    copy.push_back(extra);
+    ASSERT(copy.index_of("id", "extra") == 2);
+    copy.insert(0, extra);
+    ASSERT(copy.index_of("id", "extra") == 0);
+    ASSERT(copy.index_of("id", "extra", 1) == 3);
+    ASSERT(copy.index_of("id", "plus_one") == 1);
+    ASSERT(copy.index_of("id", "digit") == 2);
+    copy.erase(1);
+    ASSERT(copy.index_of("id", "plus_one") == copy.size());
+    ASSERT(copy.index_of("id", "digit") == 1);
+    ASSERT(copy.index_of("id", "extra", 1) == 2);
+    copy.release();
+    ASSERT(copy.index_of("id", "extra") == copy.size());
+  }
+
+  // Concurrent lookups in the shared vector.
+  {
+    const auto& shared = bunch;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+      threads.emplace_back([&shared]
+      {
+        for (int j = 0; j < 1000; ++j) {
+          ASSERT(shared.find("id", "plus_one") == &shared[0]);
+          ASSERT(shared.find("id", "digit") == &shared[1]);
+        }
+      });
+    for (auto& thread : threads)
+      thread.join();
+  }
+
   auto* const digit = bunch.find("id", "digit");
   ASSERT(digit);
   const auto* const plus_one = bunch.find("id", "plus_one");
@@ -21,10 +21,13 @@ namespace dmitigr::pgfe {
 
 enum class Communication_mode;
 enum class Connection_status;
+enum class Data_direction;
 enum class Data_format;
 enum class External_library;
 enum class Password_encryption;
+enum class Pipeline_status;
 enum class Problem_severity;
+enum class Request_kind;
 enum class Socket_readiness;
 enum class Ssl_mode;
 enum class Ssl_certificate_authority_policy;
@@ -40,34 +43,50 @@ enum class Large_object_seek_whence;
 // Classes
 // -----------------------------------------------------------------------------
 
+class Binary_copy_decoder;
+class Binary_copy_encoder;
 class Completion;
 class Composite;
 class Compositional;
 class Connection;
 class Connection_options;
 class Connection_pool;
+class Copier;
 class Data;
 class Data_view;
 class Error;
+class Flat_composite;
+class Instrument;
+class Latency_histogram;
 class Large_object;
+class Large_object_streambuf;
 class Message;
 class Notice;
 class Notification;
+class Notification_hub;
 class Parameterizable;
 class Prepared_statement;
 class Problem;
+class Reactor;
+struct Request_metrics;
 class Response;
+class Routing_pool;
 class Row;
+class Row_batch;
 class Row_info;
 class Signal;
 class Sql_string;
 class Sql_vector;
+class Statement_statistics;
 
 class Client_exception;
 class Server_exception;
 
+template<typename> struct Binary_copy_conversions;
 template<typename> struct Conversions;
 template<typename> class Entity_vector;
+template<typename> struct Row_binding;
+template<typename> class Row_decoder;
 
 /// The implementation details.
 namespace detail {